@@ -22,7 +22,7 @@
 #ifndef QTAV_QUICKVIDEOPREVIEW_H
 #define QTAV_QUICKVIDEOPREVIEW_H
 
-#include <QtAV/VideoFrameExtractor.h>
+#include <QtAV/VideoFrame.h>
 #if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
 #include <QmlAV/QuickFBORenderer.h>
 typedef QuickFBORenderer BaseQuickRenderer;
@@ -41,6 +41,7 @@ class QuickVideoPreview : public BaseQuickRenderer
     Q_PROPERTY(QUrl file READ file WRITE setFile NOTIFY fileChanged)
 public:
     explicit QuickVideoPreview(QQuickItem *parent = 0);
+    ~QuickVideoPreview();
     void setTimestamp(int value);
     int timestamp() const;
     void setFile(const QUrl& value);
@@ -53,10 +54,14 @@ signals:
 private slots:
     void displayFrame(const QtAV::VideoFrame& frame); //parameter VideoFrame
     void displayNoFrame();
+    void onFrameReady(int id, const QtAV::VideoFrame& frame);
+    void onError(int id);
+    void preview();
 
 private:
     QUrl m_file;
-    VideoFrameExtractor m_extractor;
+    int m_timestamp;
+    int m_request; // id of the pending ThumbnailService request. 0: none
 };
 } //namespace QtAV
 #endif // QUICKVIDEOPREVIEW_H
@@ -135,6 +135,7 @@ bool QuickFBORenderer::receiveFrame(const VideoFrame &frame)
     DPTR_D(QuickFBORenderer);
     d.video_frame = frame;
     d.frame_changed = true;
+    d.glv.prepareFrame(frame); // copy to gl buffer here but not in rendering thread
 //    update();  // why update slow? because of calling in a different thread?
     //QMetaObject::invokeMethod(this, "update"); // slower than directly postEvent
     QCoreApplication::postEvent(this, new QEvent(QEvent::User));
@@ -20,27 +20,53 @@
 ******************************************************************************/
 
 #include "QmlAV/QuickVideoPreview.h"
+#include <QtAV/ThumbnailService.h>
 #include <QtCore/QRectF>
+#include <QtQuick/QQuickWindow>
 
 namespace QtAV {
+namespace {
+// frames are decoded and scaled for device pixels, otherwise they are upscaled and blurry on high dpi screens
+QSize devicePixelSize(const QQuickItem *item)
+{
+    const QSize s(item->boundingRect().toRect().size());
+    if (!item->window())
+        return s;
+    return s*item->window()->devicePixelRatio();
+}
+} //namespace
 
-QuickVideoPreview::QuickVideoPreview(QQuickItem *parent) : BaseQuickRenderer(parent)
+QuickVideoPreview::QuickVideoPreview(QQuickItem *parent)
+    : BaseQuickRenderer(parent)
+    , m_timestamp(0)
+    , m_request(0)
 {
-    connect(&m_extractor, SIGNAL(positionChanged()), this, SIGNAL(timestampChanged()));
-    connect(&m_extractor, SIGNAL(frameExtracted(QtAV::VideoFrame)), SLOT(displayFrame(QtAV::VideoFrame)));
-    connect(&m_extractor, SIGNAL(error(const QString &)), SLOT(displayNoFrame()));
-    connect(&m_extractor, SIGNAL(aborted(const QString &)), SLOT(displayNoFrame()));
+    // demuxers, decoders and frames are shared by all previews
+    ThumbnailService *service = ThumbnailService::instance();
+    connect(service, SIGNAL(frameReady(int,QtAV::VideoFrame)), SLOT(onFrameReady(int,QtAV::VideoFrame)));
+    connect(service, SIGNAL(error(int,QString)), SLOT(onError(int)));
     connect(this, SIGNAL(fileChanged()), SLOT(displayNoFrame()));
+    connect(this, SIGNAL(timestampChanged()), SLOT(preview()));
+    connect(this, SIGNAL(widthChanged()), SLOT(preview()));
+    connect(this, SIGNAL(heightChanged()), SLOT(preview()));
+}
+
+QuickVideoPreview::~QuickVideoPreview()
+{
+    ThumbnailService::instance()->cancel(this);
 }
 
 void QuickVideoPreview::setTimestamp(int value)
 {
-    m_extractor.setPosition((qint64)value);
+    if (m_timestamp == value)
+        return;
+    m_timestamp = value;
+    emit timestampChanged();
 }
 
 int QuickVideoPreview::timestamp() const
 {
-    return (int)m_extractor.position();
+    return m_timestamp;
 }
 
 void QuickVideoPreview::setFile(const QUrl &value)
@@ -49,7 +75,7 @@ void QuickVideoPreview::setFile(const QUrl &value)
         return;
     m_file = value;
     emit fileChanged();
-    m_extractor.setSource(QUrl::fromPercentEncoding(m_file.toEncoded()));
+    preview();
 }
 
 QUrl QuickVideoPreview::file() const
@@ -59,15 +85,11 @@ QUrl QuickVideoPreview::file() const
 
 void QuickVideoPreview::displayFrame(const QtAV::VideoFrame &frame)
 {
-    int diff = qAbs(qint64(frame.timestamp()*1000.0) - m_extractor.position());
-    if (diff > m_extractor.precision()) {
-        //qWarning("timestamp difference (%d/%lld) is too large! ignore", diff);
-    }
     if (isOpenGL() || frame.imageFormat() != QImage::Format_Invalid) {
         receive(frame);
         return;
     }
-    VideoFrame f(frame.to(VideoFormat::Format_RGB32, boundingRect().toRect().size()));
+    VideoFrame f(frame.to(VideoFormat::Format_RGB32, devicePixelSize(this)));
     if (!f.isValid())
         return;
     receive(f);
@@ -78,4 +100,29 @@ void QuickVideoPreview::displayNoFrame()
     receive(VideoFrame());
 }
 
+void QuickVideoPreview::onFrameReady(int id, const QtAV::VideoFrame &frame)
+{
+    if (id != m_request)
+        return;
+    m_request = 0;
+    displayFrame(frame);
+}
+
+void QuickVideoPreview::onError(int id)
+{
+    if (id != m_request)
+        return;
+    m_request = 0;
+    displayNoFrame();
+}
+
+void QuickVideoPreview::preview()
+{
+    if (m_file.isEmpty())
+        return;
+    // small previews decode in a lower resolution or quality. a pending request of this item is replaced
+    m_request = ThumbnailService::instance()->request(this, QUrl::fromPercentEncoding(m_file.toEncoded()), m_timestamp
+                                                      , devicePixelSize(this), isVisible() ? 1 : 0);
+}
+
 } //namespace QtAV
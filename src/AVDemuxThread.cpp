@@ -24,6 +24,7 @@
 #include "QtAV/AVClock.h"
 #include "QtAV/AVDemuxer.h"
 #include "QtAV/AVDecoder.h"
+#include "QtAV/Statistics.h"
 #include "VideoThread.h"
 #include <QtCore/QTime>
 #include "utils/Logger.h"
@@ -84,6 +85,8 @@ AVDemuxThread::AVDemuxThread(QObject *parent) :
   , video_thread(0)
   , clock_type(-1)
   , last_seek_pos(0)
+  , last_read_pts(0)
+  , statistics(0)
   , current_seek_task(nullptr)
   , stepping(false)
   , stepping_timeout_time(0)
@@ -101,6 +104,8 @@ AVDemuxThread::AVDemuxThread(AVDemuxer *dmx, QObject *parent) :
   , audio_thread(0)
   , video_thread(0)
   , last_seek_pos(0)
+  , last_read_pts(0)
+  , statistics(0)
   , current_seek_task(nullptr)
   , stepping(false)
   , stepping_timeout_time(0)
@@ -148,6 +153,11 @@ void AVDemuxThread::setVideoThread(AVThread *thread)
     setAVThread(video_thread, thread);
 }
 
+void AVDemuxThread::setStatistics(Statistics *statistics)
+{
+    this->statistics = statistics;
+}
+
 AVThread* AVDemuxThread::videoThread()
 {
     return video_thread;
@@ -289,6 +299,7 @@ void AVDemuxThread::seekInternal(qint64 pos, SeekType type, qint64 external_pos)
     qDebug("seek to %s %lld ms (%f%%)", QTime(0, 0, 0).addMSecs(pos).toString().toUtf8().constData(), pos, double(pos - demuxer->startTime())/double(demuxer->duration())*100.0);
     demuxer->setSeekType(type);
     demuxer->seek(pos);
+    setLastReadPts(0);
     if (ademuxer) {
         ademuxer->setSeekType(type);
         ademuxer->seek(pos);
@@ -372,6 +383,29 @@ qint64 AVDemuxThread::lastSeekPos()
     return last_seek_pos;
 }
 
+qreal AVDemuxThread::lastReadPts() const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 3, 0) && defined(Q_ATOMIC_INT64_IS_SUPPORTED)
+    return qreal(last_read_pts.loadAcquire())/1000.0;
+#else
+    QMutexLocker lock(&last_read_mutex);
+    Q_UNUSED(lock);
+    return qreal(last_read_pts)/1000.0;
+#endif
+}
+
+void AVDemuxThread::setLastReadPts(qreal pts)
+{
+    const qint64 ms = qint64(pts*1000.0);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 3, 0) && defined(Q_ATOMIC_INT64_IS_SUPPORTED)
+    last_read_pts.storeRelease(ms);
+#else
+    QMutexLocker lock(&last_read_mutex);
+    Q_UNUSED(lock);
+    last_read_pts = ms;
+#endif
+}
+
 void AVDemuxThread::pauseInternal(bool value)
 {
     paused = value;
@@ -631,6 +665,7 @@ void AVDemuxThread::run()
     }
     qreal last_apts = 0;
     qreal last_vpts = 0;
+    setLastReadPts(0);
 
     AutoSem as(&sem);
     Q_UNUSED(as);
@@ -692,9 +727,12 @@ void AVDemuxThread::run()
             continue; //the queue is empty and will block
         }
         updateBufferState();
+        const qint64 t_read = Statistics::Pipeline::now();
         if (!demuxer->readFrame()) {
             continue;
         }
+        if (statistics)
+            statistics->pipeline.record(Statistics::Pipeline::DemuxRead, t_read);
         stream = demuxer->stream();
         pkt = demuxer->packet();
         Packet apkt;
@@ -756,8 +794,10 @@ void AVDemuxThread::run()
                 // attached picture is cover for song, 1 frame
                 aqueue->blockFull(!video_thread || !video_thread->isRunning() || !vqueue || audio_has_pic);
                 // external audio: a_ext < 0, stream = audio_idx=>put invalid packet
-                if (a_ext >= 0)
+                if (a_ext >= 0) {
                     aqueue->put(apkt); //affect video_thread
+                    setLastReadPts(apkt.pts);
+                }
             }
         }
         // always check video stream if use external audio
@@ -770,6 +810,7 @@ void AVDemuxThread::run()
                 vqueue->blockFull(!audio_thread || !audio_thread->isRunning() || !aqueue || aqueue->isEnough());
                 vqueue->put(pkt); //affect audio_thread
                 last_vpts = pkt.pts;
+                setLastReadPts(pkt.pts);
             }
         } else if (demuxer->subtitleStreams().contains(stream)) { //subtitle
             Q_EMIT internalSubtitlePacketRead(demuxer->subtitleStreams().indexOf(stream), pkt);
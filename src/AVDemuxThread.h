@@ -22,6 +22,7 @@
 #ifndef QAV_DEMUXTHREAD_H
 #define QAV_DEMUXTHREAD_H
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QMutex>
 #include <QtCore/QSemaphore>
 #include <QtCore/QThread>
@@ -33,6 +34,7 @@ namespace QtAV {
 
 class AVDemuxer;
 class AVThread;
+class Statistics;
 class AVDemuxThread : public QThread
 {
     Q_OBJECT
@@ -44,6 +46,7 @@ public:
     void setAudioThread(AVThread *thread);
     AVThread* audioThread();
     void setVideoThread(AVThread *thread);
+    void setStatistics(Statistics *statistics); //not thread safe
     AVThread* videoThread();
     void stepForward(); // show next video frame and pause
     void stepBackward();
@@ -62,6 +65,8 @@ public:
     bool waitForStarted(int msec = -1);
     qint64 lastSeekPos();
     bool hasSeekTasks();
+    /// timestamp(in seconds) of the last audio/video packet put into the queues. Used to measure live stream latency
+    qreal lastReadPts() const;
 Q_SIGNALS:
     void requestClockPause(bool value);
     void mediaStatusChanged(QtAV::MediaStatus);
@@ -91,6 +96,7 @@ private:
     void processNextSeekTask();
     void seekInternal(qint64 pos, SeekType type, qint64 external_pos = std::numeric_limits < qint64 >::min()); //must call in AVDemuxThread
     void pauseInternal(bool value);
+    void setLastReadPts(qreal pts);
 
     bool paused;
     bool user_paused;
@@ -106,6 +112,14 @@ private:
     QWaitCondition cond;
     BlockingQueue<QRunnable*> seek_tasks;
     qint64 last_seek_pos;
+    // in ms. written by demux thread, read by player thread. 32bit ms overflows for streams with large timestamps
+#if QT_VERSION >= QT_VERSION_CHECK(5, 3, 0) && defined(Q_ATOMIC_INT64_IS_SUPPORTED)
+    QAtomicInteger<qint64> last_read_pts;
+#else
+    mutable QMutex last_read_mutex;
+    qint64 last_read_pts;
+#endif
+    Statistics *statistics;
     QRunnable *current_seek_task;
     bool stepping;
     qint64 stepping_timeout_time;
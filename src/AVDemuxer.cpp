@@ -21,8 +21,14 @@
 #include "QtAV/AVDemuxer.h"
 #include "QtAV/MediaIO.h"
 #include "QtAV/private/AVCompat.h"
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
 #include <QtCore/QMutex>
+#include <QtCore/QPair>
 #include <QtCore/QStringList>
+#include <QtCore/QVector>
 #if QT_VERSION >= QT_VERSION_CHECK(4, 7, 0)
 #include <QtCore/QElapsedTimer>
 #else
@@ -57,6 +63,7 @@ public:
         callback = handleTimeout;
         opaque = this;
     }
+    void setDemuxer(AVDemuxer* demuxer) { mpDemuxer = demuxer; }
     ~InterruptHandler() {
 #if QT_VERSION >= QT_VERSION_CHECK(4, 7, 0)
         mTimer.invalidate();
@@ -190,6 +197,147 @@ private:
     QElapsedTimer mTimer;
 };
 
+namespace {
+// stream parameters found by avformat_find_stream_info()
+struct ProbedStream {
+    int codec_type;
+    int codec_id;
+    int width, height;
+    int pix_fmt;
+    AVRational sample_aspect_ratio, avg_frame_rate, r_frame_rate;
+    int sample_rate, channels;
+    int sample_fmt;
+    quint64 channel_layout;
+    int frame_size;
+    QByteArray extradata;
+};
+typedef QVector<ProbedStream> ProbedStreams;
+
+class ProbeCache
+{
+public:
+    static ProbeCache& instance() {
+        static ProbeCache c;
+        return c;
+    }
+    bool get(const QString& key, ProbedStreams* streams) {
+        QMutexLocker lock(&mutex);
+        Q_UNUSED(lock);
+        QHash<QString, ProbedStreams>::const_iterator it = entries.constFind(key);
+        if (it == entries.constEnd())
+            return false;
+        *streams = it.value();
+        keys.removeOne(key);
+        keys.append(key);
+        return true;
+    }
+    void put(const QString& key, AVFormatContext *ctx) {
+        ProbedStreams streams(ctx->nb_streams);
+        for (unsigned int i = 0; i < ctx->nb_streams; ++i) {
+            const AVStream *st = ctx->streams[i];
+            const AVCodecContext *c = st->codec;
+            ProbedStream &s = streams[i];
+            s.codec_type = c->codec_type;
+            s.codec_id = c->codec_id;
+            s.width = c->width;
+            s.height = c->height;
+            s.pix_fmt = c->pix_fmt;
+            s.sample_aspect_ratio = c->sample_aspect_ratio;
+            s.avg_frame_rate = st->avg_frame_rate;
+            s.r_frame_rate = st->r_frame_rate;
+            s.sample_rate = c->sample_rate;
+            s.channels = c->channels;
+            s.sample_fmt = c->sample_fmt;
+            s.channel_layout = c->channel_layout;
+            s.frame_size = c->frame_size;
+            if (c->extradata && c->extradata_size > 0)
+                s.extradata = QByteArray((const char*)c->extradata, c->extradata_size);
+        }
+        QMutexLocker lock(&mutex);
+        Q_UNUSED(lock);
+        if (!entries.contains(key) && keys.size() >= kMaxEntries)
+            entries.remove(keys.takeFirst());
+        keys.removeOne(key);
+        keys.append(key);
+        entries.insert(key, streams);
+    }
+    void remove(const QString& key) {
+        QMutexLocker lock(&mutex);
+        Q_UNUSED(lock);
+        entries.remove(key);
+        keys.removeOne(key);
+    }
+    void clear() {
+        QMutexLocker lock(&mutex);
+        Q_UNUSED(lock);
+        entries.clear();
+        keys.clear();
+    }
+    /*!
+     * Fill the parameters not found by a shortened probing. Return false if stream layout does not match the cached one.
+     */
+    static bool restore(AVFormatContext *ctx, const ProbedStreams& streams) {
+        if (ctx->nb_streams < (unsigned int)streams.size())
+            return false;
+        for (int i = 0; i < streams.size(); ++i) {
+            AVStream *st = ctx->streams[i];
+            AVCodecContext *c = st->codec;
+            const ProbedStream &s = streams[i];
+            if (c->codec_type != s.codec_type)
+                return false;
+            if (c->codec_id == QTAV_CODEC_ID(NONE))
+                c->codec_id = (AVCodecID)s.codec_id;
+            else if (c->codec_id != s.codec_id)
+                return false;
+            if (c->codec_type == AVMEDIA_TYPE_VIDEO) {
+                if (c->width <= 0 || c->height <= 0) {
+                    c->width = s.width;
+                    c->height = s.height;
+                }
+                if (c->pix_fmt == QTAV_PIX_FMT_C(NONE))
+                    c->pix_fmt = (AVPixelFormat)s.pix_fmt;
+                if (!c->sample_aspect_ratio.num)
+                    c->sample_aspect_ratio = s.sample_aspect_ratio;
+                // estimated from more packets in a full probing
+                if (s.avg_frame_rate.num && s.avg_frame_rate.den)
+                    st->avg_frame_rate = s.avg_frame_rate;
+                if (s.r_frame_rate.num && s.r_frame_rate.den)
+                    st->r_frame_rate = s.r_frame_rate;
+            } else if (c->codec_type == AVMEDIA_TYPE_AUDIO) {
+                if (c->sample_rate <= 0)
+                    c->sample_rate = s.sample_rate;
+                if (c->channels <= 0)
+                    c->channels = s.channels;
+                if (c->sample_fmt == AV_SAMPLE_FMT_NONE)
+                    c->sample_fmt = (AVSampleFormat)s.sample_fmt;
+                if (!c->channel_layout)
+                    c->channel_layout = s.channel_layout;
+                if (!c->frame_size)
+                    c->frame_size = s.frame_size;
+            }
+            if (!c->extradata && !s.extradata.isEmpty()) {
+                c->extradata = (uint8_t*)av_mallocz(s.extradata.size() + AV_INPUT_BUFFER_PADDING_SIZE);
+                if (c->extradata) {
+                    memcpy(c->extradata, s.extradata.constData(), s.extradata.size());
+                    c->extradata_size = s.extradata.size();
+                }
+            }
+        }
+        return true;
+    }
+private:
+    // a kiosk plays a few hundred files
+    static const int kMaxEntries = 1024;
+    QMutex mutex;
+    QHash<QString, ProbedStreams> entries;
+    QStringList keys; // least recently used first
+};
+
+// avformat_find_stream_info() parameters if stream info is cached
+static const int kCachedProbeSize = 64*1024; // bytes
+static const int kCachedAnalyzeDuration = AV_TIME_BASE/5; // us
+} //namespace
+
 class AVDemuxer::Private
 {
 public:
@@ -211,6 +359,8 @@ public:
         , seek_type(AccurateSeek)
         , dict(0)
         , interrupt_hanlder(0)
+        , probe_cache(false)
+        , probe_cached(false)
     {}
     ~Private() {
         delete interrupt_hanlder;
@@ -273,6 +423,10 @@ public:
     bool setStream(AVDemuxer::StreamType st, int streamValue);
     //called by loadFile(). if change to a new stream, call it(e.g. in AVPlayer)
     bool prepareStreams();
+    // key of ProbeCache. (url, size, mtime) for local files, hash of the first 64KB and size for seekable MediaIO
+    QString probeCacheKey() const;
+    // avformat_find_stream_info() with probe cache
+    int findStreamInfo(const QString& cache_key);
 
     MediaStatus media_status;
     bool seekable;
@@ -316,6 +470,10 @@ public:
 
     AVDemuxer::InterruptHandler *interrupt_hanlder;
     QMutex mutex; //TODO: remove if load, read, seek is called in 1 thread
+    // packets read by prefetch() and not returned by readFrame() yet. (stream, packet)
+    QList<QPair<int, Packet> > prefetched;
+    bool probe_cache;
+    bool probe_cached; // stream info of current media is restored from cache
 };
 
 AVDemuxer::AVDemuxer(QObject *parent)
@@ -434,6 +592,16 @@ bool AVDemuxer::readFrame()
     Q_UNUSED(lock);
     if (!d->format_ctx)
         return false;
+    if (!d->prefetched.isEmpty()) {
+        const QPair<int, Packet> p(d->prefetched.takeFirst());
+        d->stream = p.first;
+        d->pkt = p.second;
+        if (!d->started) {
+            d->started = true;
+            Q_EMIT started();
+        }
+        return true;
+    }
     d->pkt = Packet();
     // no lock required because in AVDemuxThread read and seek are in the same thread
     AVPacket packet;
@@ -499,6 +667,46 @@ bool AVDemuxer::readFrame()
     return true;
 }
 
+int AVDemuxer::prefetch(int count)
+{
+    QList<QPair<int, Packet> > packets;
+    {
+        QMutexLocker lock(&d->mutex);
+        Q_UNUSED(lock);
+        if (!d->format_ctx)
+            return 0;
+        packets.swap(d->prefetched); // readFrame() must read from the stream
+    }
+    // unknown stream packets are dropped by readFrame(), limit the tries
+    for (int tries = 0; packets.size() < count && tries < count*4; ++tries) {
+        if (!readFrame()) {
+            if (d->eof || getInterruptStatus())
+                break;
+            continue;
+        }
+        packets.append(qMakePair(d->stream, d->pkt));
+    }
+    QMutexLocker lock(&d->mutex);
+    Q_UNUSED(lock);
+    d->prefetched = packets;
+    // started() is emitted when the 1st prefetched packet is read
+    d->started = false;
+    return packets.size();
+}
+
+void AVDemuxer::swap(AVDemuxer &other)
+{
+    if (&other == this)
+        return;
+    QMutexLocker lock(&d->mutex);
+    Q_UNUSED(lock);
+    QMutexLocker lock2(&other.d->mutex);
+    Q_UNUSED(lock2);
+    d.swap(other.d);
+    d->interrupt_hanlder->setDemuxer(this);
+    other.d->interrupt_hanlder->setDemuxer(&other);
+}
+
 Packet AVDemuxer::packet() const
 {
     return d->pkt;
@@ -513,6 +721,8 @@ bool AVDemuxer::atEnd() const
 {
     if (!d->format_ctx)
         return false;
+    if (!d->prefetched.isEmpty())
+        return false;
     if (d->format_ctx->pb)  {
         AVIOContext *pb = d->format_ctx->pb;
         //qDebug("pb->error: %#x, eof: %d, pos: %lld, bufptr: %p", pb->error, pb->eof_reached, pb->pos, pb->buf_ptr);
@@ -529,6 +739,26 @@ bool AVDemuxer::isSeekable() const
     return d->seekable;
 }
 
+void AVDemuxer::setProbeCacheEnabled(bool value)
+{
+    d->probe_cache = value;
+}
+
+bool AVDemuxer::isProbeCacheEnabled() const
+{
+    return d->probe_cache;
+}
+
+bool AVDemuxer::isProbeCached() const
+{
+    return d->probe_cached;
+}
+
+void AVDemuxer::clearProbeCache()
+{
+    ProbeCache::instance().clear();
+}
+
 void AVDemuxer::setSeekUnit(SeekUnit unit)
 {
     d->seek_unit = unit;
@@ -567,6 +797,7 @@ bool AVDemuxer::seek(qint64 pos)
         }
     }
     d->eof = false;
+    d->prefetched.clear();
     // no lock required because in AVDemuxThread read and seek are in the same thread
 #if 0
     //t: unit is s
@@ -790,6 +1021,8 @@ bool AVDemuxer::load()
         qDebug() << "force format: " << d->format_forced;
     }
     int ret = 0;
+    // MediaIO is read here. compute before avformat_open_input
+    const QString probe_key(d->probe_cache ? d->probeCacheKey() : QString());
     // used dict entries will be removed in avformat_open_input
     d->interrupt_hanlder->begin(InterruptHandler::Open);
     if (d->input) {
@@ -822,7 +1055,7 @@ bool AVDemuxer::load()
     //if(av_find_stread->inputfo(d->format_ctx)<0) {
     //TODO: avformat_find_stread->inputfo is too slow, only useful for some video format
     d->interrupt_hanlder->begin(InterruptHandler::FindStreamInfo);
-    ret = avformat_find_stream_info(d->format_ctx, NULL);
+    ret = d->findStreamInfo(probe_key);
     d->interrupt_hanlder->end();
 
     if (ret < 0) {
@@ -876,6 +1109,8 @@ bool AVDemuxer::unload()
     d->buf_pos = 0;
     d->started = false;
     d->max_pts = 0.0;
+    d->prefetched.clear();
+    d->probe_cached = false;
     d->resetStreams();
     d->interrupt_hanlder->setStatus(0);
     //av_close_input_file(d->format_ctx); //deprecated
@@ -1294,6 +1529,71 @@ bool AVDemuxer::Private::setStream(AVDemuxer::StreamType st, int streamValue)
     return true;
 }
 
+QString AVDemuxer::Private::probeCacheKey() const
+{
+    if (input) {
+        if (!input->isSeekable() || input->size() <= 0)
+            return QString();
+        QByteArray data(64*1024, 0);
+        const qint64 pos = input->position();
+        input->seek(0);
+        const qint64 len = input->read(data.data(), data.size());
+        input->seek(pos);
+        if (len <= 0)
+            return QString();
+        data.resize(len);
+        return QStringLiteral("%1:%2:%3").arg(input->name())
+                .arg(QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex()))
+                .arg(input->size());
+    }
+    QString path(file);
+    if (path.startsWith(QLatin1String(kFileScheme)))
+        path = Internal::Path::toLocal(path);
+    const QFileInfo fi(path);
+    if (fi.isFile()) {
+        return QStringLiteral("%1:%2:%3").arg(fi.absoluteFilePath()).arg(fi.size())
+                .arg(fi.lastModified().toMSecsSinceEpoch());
+    }
+    // other protocols. stream layout of a live url may change, but it's checked in findStreamInfo()
+    return file;
+}
+
+int AVDemuxer::Private::findStreamInfo(const QString &cache_key)
+{
+    probe_cached = false;
+    if (cache_key.isEmpty())
+        return avformat_find_stream_info(format_ctx, NULL);
+    ProbedStreams streams;
+    if (!ProbeCache::instance().get(cache_key, &streams)) {
+        const int ret = avformat_find_stream_info(format_ctx, NULL);
+        if (ret >= 0)
+            ProbeCache::instance().put(cache_key, format_ctx);
+        return ret;
+    }
+    // keep user's values
+    int64_t probesize = 0, analyzeduration = 0;
+    av_opt_get_int(format_ctx, "probesize", 0, &probesize);
+    av_opt_get_int(format_ctx, "analyzeduration", 0, &analyzeduration);
+    if (probesize > kCachedProbeSize)
+        av_opt_set_int(format_ctx, "probesize", kCachedProbeSize, 0);
+    if (analyzeduration <= 0 || analyzeduration > kCachedAnalyzeDuration)
+        av_opt_set_int(format_ctx, "analyzeduration", kCachedAnalyzeDuration, 0);
+    int ret = avformat_find_stream_info(format_ctx, NULL);
+    av_opt_set_int(format_ctx, "probesize", probesize, 0);
+    av_opt_set_int(format_ctx, "analyzeduration", analyzeduration, 0);
+    if (ret >= 0 && ProbeCache::restore(format_ctx, streams)) {
+        qDebug() << "stream info is restored from probe cache: " << cache_key;
+        probe_cached = true;
+        return ret;
+    }
+    qDebug() << "stream layout changed. probe again: " << cache_key;
+    ProbeCache::instance().remove(cache_key);
+    ret = avformat_find_stream_info(format_ctx, NULL);
+    if (ret >= 0)
+        ProbeCache::instance().put(cache_key, format_ctx);
+    return ret;
+}
+
 bool AVDemuxer::Private::prepareStreams()
 {
     has_attached_pic = false;
@@ -37,6 +37,7 @@
 #include "QtAV/AVClock.h"
 #include "QtAV/VideoCapture.h"
 #include "QtAV/VideoCapture.h"
+#include "QtAV/MemoryAccounting.h"
 #include "filter/FilterManager.h"
 #include "output/OutputSet.h"
 #include "AudioThread.h"
@@ -88,6 +89,7 @@ AVPlayer::AVPlayer(QObject *parent) :
     connect(&d->demuxer, SIGNAL(seekableChanged()), this, SIGNAL(seekableChanged()));
     d->read_thread = new AVDemuxThread(this);
     d->read_thread->setDemuxer(&d->demuxer);
+    d->read_thread->setStatistics(&d->statistics);
     //direct connection can not sure slot order?
     connect(d->read_thread, SIGNAL(finished()), this, SLOT(stopFromDemuxerThread()), Qt::DirectConnection);
     connect(d->read_thread, SIGNAL(requestClockPause(bool)), masterClock(), SLOT(pause(bool)), Qt::DirectConnection);
@@ -190,12 +192,8 @@ void AVPlayer::setSpeed(qreal speed)
         return;
     setFrameRate(0); // will set clock to default
     d->speed = speed;
-    //TODO: check clock type?
-    if (d->ao && d->ao->isAvailable()) {
-        qDebug("set speed %.2f", d->speed);
-        d->ao->setSpeed(d->speed);
-    }
-    masterClock()->setSpeed(d->speed);
+    qDebug("set speed %.2f", d->speed);
+    d->applySpeed(); // keep the live catch up factor
     Q_EMIT speedChanged(d->speed);
 }
 
@@ -233,6 +231,16 @@ bool AVPlayer::isInterruptOnTimeout() const
     return d->demuxer.isInterruptOnTimeout();
 }
 
+void AVPlayer::setProbeCacheEnabled(bool value)
+{
+    d->demuxer.setProbeCacheEnabled(value);
+}
+
+bool AVPlayer::isProbeCacheEnabled() const
+{
+    return d->demuxer.isProbeCacheEnabled();
+}
+
 void AVPlayer::setFrameRate(qreal value)
 {
     d->force_fps = value;
@@ -506,6 +514,52 @@ QString AVPlayer::file() const
     return QString();
 }
 
+void AVPlayer::setNextFile(const QString &path)
+{
+    QString p(path);
+    if (p.startsWith(QLatin1String("file:")))
+        p = Internal::Path::toLocal(p);
+    QMutexLocker lock(&d->next_mutex);
+    Q_UNUSED(lock);
+    if (d->next_file == p)
+        return;
+    d->releaseNext();
+    d->next_file = p;
+    if (p.isEmpty())
+        return;
+    d->next_demuxer = new AVDemuxer();
+    d->next_demuxer->setOptions(d->demuxer.options());
+    d->next_demuxer->setInterruptTimeout(d->interrupt_timeout);
+    d->next_demuxer->setInterruptOnTimeout(d->demuxer.isInterruptOnTimeout());
+    d->next_demuxer->setProbeCacheEnabled(d->demuxer.isProbeCacheEnabled());
+    d->next_demuxer->setMedia(p);
+    d->next_loading++;
+
+    // decoder options can be changed in this thread while preloading
+    class PreloadWorker : public QRunnable {
+    public:
+        PreloadWorker(AVPlayer::Private *p, AVDemuxer *demuxer)
+            : m_priv(p), m_demuxer(demuxer), m_aopt(p->ac_opt), m_vids(p->vc_ids), m_vopt(p->vc_opt) {}
+        virtual void run() {
+            m_priv->preloadNext(m_demuxer, m_aopt, m_vids, m_vopt);
+        }
+    private:
+        AVPlayer::Private *m_priv;
+        AVDemuxer *m_demuxer;
+        QVariantHash m_aopt;
+        QVector<VideoDecoderId> m_vids;
+        QVariantHash m_vopt;
+    };
+    loaderThreadPool()->start(new PreloadWorker(d.data(), d->next_demuxer));
+}
+
+QString AVPlayer::nextFile() const
+{
+    QMutexLocker lock(&d->next_mutex);
+    Q_UNUSED(lock);
+    return d->next_file;
+}
+
 void AVPlayer::setIODevice(QIODevice* device)
 {
     // TODO: d->reset_state = d->demuxer2.setMedia(device);
@@ -655,25 +709,31 @@ void AVPlayer::loadInternal()
 {
     QMutexLocker lock(&d->load_mutex);
     Q_UNUSED(lock);
-    // release codec ctx
-    //close decoders here to make sure open and close in the same thread if not async load
-    if (isLoaded()) {
-        if (d->adec)
-            d->adec->setCodecContext(0);
-        if (d->vdec)
-            d->vdec->setCodecContext(0);
-    }
-    qDebug() << "Loading " << d->current_source << " ...";
-    if (d->current_source.type() == QVariant::String) {
-        d->demuxer.setMedia(d->current_source.toString());
+    const qint64 t_load = Statistics::Pipeline::now();
+    if (d->gapless) { // demuxer and decoders are from preloading thread
+        qDebug() << "Preloaded " << d->current_source;
+        d->loaded = d->demuxer.isLoaded();
     } else {
-        if (d->current_source.canConvert<QIODevice*>()) {
-            d->demuxer.setMedia(d->current_source.value<QIODevice*>());
-        } else { // MediaIO
-            d->demuxer.setMedia(d->current_source.value<QtAV::MediaIO*>());
+        // release codec ctx
+        //close decoders here to make sure open and close in the same thread if not async load
+        if (isLoaded()) {
+            if (d->adec)
+                d->adec->setCodecContext(0);
+            if (d->vdec)
+                d->vdec->setCodecContext(0);
+        }
+        qDebug() << "Loading " << d->current_source << " ...";
+        if (d->current_source.type() == QVariant::String) {
+            d->demuxer.setMedia(d->current_source.toString());
+        } else {
+            if (d->current_source.canConvert<QIODevice*>()) {
+                d->demuxer.setMedia(d->current_source.value<QIODevice*>());
+            } else { // MediaIO
+                d->demuxer.setMedia(d->current_source.value<QtAV::MediaIO*>());
+            }
         }
+        d->loaded = d->demuxer.load();
     }
-    d->loaded = d->demuxer.load();
     d->status = d->demuxer.mediaStatus();
     if (!d->loaded) {
         d->statistics.reset();
@@ -706,6 +766,10 @@ void AVPlayer::loadInternal()
     d->stop_position_norm = normalizedPosition(d->stop_position);
     int interval = qAbs(d->notify_interval);
     d->initStatistics();
+    d->statistics.load_only.start = t_load;
+    d->statistics.load_only.open_time = (Statistics::Pipeline::now() - t_load)/1000LL;
+    d->statistics.load_only.probe_cached = d->demuxer.isProbeCached();
+    qDebug("media opened in %lldms. probe cached: %d", d->statistics.load_only.open_time, d->statistics.load_only.probe_cached);
     if (interval != qAbs(d->notify_interval))
         Q_EMIT notifyIntervalChanged();
 }
@@ -1304,6 +1368,18 @@ void AVPlayer::stopFromDemuxerThread()
     qDebug("demuxer thread emit finished. repeat: %d/%d", currentRepeat(), repeat());
     d->seeking = false;
     if (currentRepeat() < 0 || (currentRepeat() >= repeat() && repeat() >= 0)) {
+        if (currentRepeat() >= 0 && d->demuxer.atEnd()) { // not stopped by user
+            QMutexLocker lock(&d->load_mutex);
+            Q_UNUSED(lock);
+            if (d->takeNext()) {
+                d->repeat_current = -1;
+                d->start_position_norm = 0;
+                d->stop_position_norm = kInvalidPosition;
+                d->media_end = kInvalidPosition;
+                QMetaObject::invokeMethod(this, "playNextInternal"); // ensure playInternal() is called from player thread
+                return;
+            }
+        }
         qreal stop_pts = masterClock()->videoTime();
         if (stop_pts <= 0)
             stop_pts = masterClock()->value();
@@ -1324,7 +1400,7 @@ void AVPlayer::stopFromDemuxerThread()
         //Q_EMIT stoppedAt(stop_pts*1000.0);
 
         /*
-         * currently preload is not supported. so always unload. Then some properties will be reset, e.g. duration()
+         * no preloaded next media. so always unload. Then some properties will be reset, e.g. duration()
          */
         unload(); //TODO: invoke?
     } else {
@@ -1333,6 +1409,24 @@ void AVPlayer::stopFromDemuxerThread()
     }
 }
 
+void AVPlayer::playNextInternal()
+{
+    qDebug("gapless: switch to the preloaded media");
+    Q_EMIT sourceChanged();
+    loadInternal();
+    if (d->loaded) {
+        Q_EMIT loaded();
+        playInternal();
+    }
+    d->gapless = false;
+    if (!isPlaying()) { // the same as stopped by demux thread
+        d->state = StoppedState;
+        stopNotifyTimer();
+        Q_EMIT stateChanged(d->state);
+        Q_EMIT stopped();
+    }
+}
+
 void AVPlayer::aboutToQuitApp()
 {
     d->reset_state = true;
@@ -1386,11 +1480,7 @@ void AVPlayer::stopNotifyTimer()
 void AVPlayer::onStarted()
 {
     if (d->speed != 1.0) {
-        //TODO: check clock type?
-        if (d->ao && d->ao->isAvailable()) {
-            d->ao->setSpeed(d->speed);
-        }
-        masterClock()->setSpeed(d->speed);
+        d->applySpeed();
     } else {
         d->applyFrameRate();
     }
@@ -1523,6 +1613,7 @@ void AVPlayer::timerEvent(QTimerEvent *te)
             d->clock->pause(true);
             //return; //ensure positionChanged emitted for stepForward()
         }
+        d->updateLiveLatency();
         // active only when playing
         const qint64 t = position();
         if (d->stop_position_norm == kInvalidPosition) { // or check d->stop_position_norm < 0
@@ -1679,6 +1770,71 @@ int AVPlayer::bufferValue() const
     return d->buffer_value;
 }
 
+void AVPlayer::setLiveLatency(qint64 ms)
+{
+    if (ms < 0LL)
+        ms = 0LL;
+    if (d->live_latency == ms)
+        return;
+    d->live_latency = ms;
+    d->statistics.live_only.target_latency = ms;
+    d->updateBufferValue();
+    if (!ms)
+        d->updateLiveLatency(); // restore speed and frame drop state
+    Q_EMIT liveLatencyChanged();
+}
+
+qint64 AVPlayer::liveLatency() const
+{
+    return d->live_latency;
+}
+
+void AVPlayer::setBufferBytesMax(qint64 bytes)
+{
+    if (bytes < 0LL)
+        bytes = 0LL;
+    if (d->buffer_bytes_max == bytes)
+        return;
+    d->buffer_bytes_max = bytes;
+    d->updateBufferValue();
+}
+
+qint64 AVPlayer::bufferBytesMax() const
+{
+    return d->buffer_bytes_max;
+}
+
+void AVPlayer::setGlobalBufferBytesMax(qint64 bytes)
+{
+    PacketBuffer::setGlobalBufferBytesMax(bytes);
+}
+
+qint64 AVPlayer::globalBufferBytesMax()
+{
+    return PacketBuffer::globalBufferBytesMax();
+}
+
+qint64 AVPlayer::memoryUsage() const
+{
+    qint64 bytes = MemoryAccounting::ownerBytes(this);
+    if (d->ao)
+        bytes += MemoryAccounting::ownerBytes(static_cast<AVOutput*>(d->ao));
+    return bytes;
+}
+
+void AVPlayer::setAdaptiveBuffer(bool value)
+{
+    if (d->adaptive_buffer == value)
+        return;
+    d->adaptive_buffer = value;
+    d->updateBufferValue();
+}
+
+bool AVPlayer::isAdaptiveBuffer() const
+{
+    return d->adaptive_buffer;
+}
+
 void AVPlayer::updateClock(qint64 msecs)
 {
     d->clock->updateExternalClock(msecs);
@@ -1718,12 +1874,18 @@ void AVPlayer::setContrast(int val)
 
 int AVPlayer::hue() const
 {
-    return 0;
+    return d->hue;
 }
 
 void AVPlayer::setHue(int val)
 {
-    Q_UNUSED(val);
+    if (d->hue == val)
+        return;
+    d->hue = val;
+    Q_EMIT hueChanged(d->hue);
+    if (d->vthread) {
+        d->vthread->setHue(val);
+    }
 }
 
 int AVPlayer::saturation() const
@@ -37,6 +37,12 @@ extern "C" {
 
 namespace QtAV {
 
+// live mode catch up parameters
+static const qint64 kLiveLatencyTolerance = 100; // ms
+static const qint64 kLiveFrameDropLatency = 1000; // ms
+static const qreal kLiveCatchUpSpeed = 1.05; // resampled audio is still fine
+static const qreal kLiveCatchUpSpeedMax = 1.25;
+
 namespace Internal {
 
 int computeNotifyPrecision(qint64 duration, qreal fps)
@@ -88,6 +94,9 @@ AVPlayer::Private::Private()
     , subtitle_track(0)
     , buffer_mode(BufferPackets)
     , buffer_value(-1)
+    , live_latency(0)
+    , buffer_bytes_max(0)
+    , adaptive_buffer(false)
     , read_thread(0)
     , clock(new AVClock(AVClock::AudioClock))
     , vo(0)
@@ -103,6 +112,7 @@ AVPlayer::Private::Private()
     , brightness(0)
     , contrast(0)
     , saturation(0)
+    , hue(0)
     , seeking(false)
     , seek_type(AccurateSeek)
     , interrupt_timeout(30000)
@@ -113,6 +123,12 @@ AVPlayer::Private::Private()
     , end_action(MediaEndAction_Default)
     , last_known_good_pts(0)
     , was_stepping(false)
+    , next_demuxer(0)
+    , next_adec(0)
+    , next_vdec(0)
+    , next_ready(false)
+    , next_loading(0)
+    , gapless(false)
 {
     demuxer.setInterruptTimeout(interrupt_timeout);
     /*
@@ -134,6 +150,13 @@ AVPlayer::Private::Private()
             << VideoDecoderId_FFmpeg;
 }
 AVPlayer::Private::~Private() {
+    {
+        QMutexLocker lock(&next_mutex);
+        Q_UNUSED(lock);
+        releaseNext();
+        while (next_loading > 0)
+            next_cond.wait(&next_mutex);
+    }
     // TODO: scoped ptr
     if (ao) {
         delete ao;
@@ -201,7 +224,7 @@ void AVPlayer::Private::applyFrameRate()
         // vfps<0: try to use pts (ExternalClock). if no pts (raw codec), try the default fps(VideoClock)
         vfps = -vfps;
     }
-    qreal r = speed;
+    qreal r = speed*statistics.live_only.catch_up_speed;
     if (force) {
         clock->setClockAuto(false);
         // vfps>0: force video fps to vfps. clock must be external
@@ -364,27 +387,23 @@ bool AVPlayer::Private::setupAudioThread(AVPlayer *player)
         return false;
     }
     qDebug("has audio");
-    // TODO: no delete, just reset avctx and reopen
-    if (adec) {
-        adec->disconnect();
-        delete adec;
-        adec = 0;
-    }
-    adec = AudioDecoder::create();
-    if (!adec)
-    {
-        qWarning("failed to create audio decoder");
-        return false;
-    }
-    QObject::connect(adec, SIGNAL(error(QtAV::AVError)), player, SIGNAL(error(QtAV::AVError)));
-    adec->setCodecContext(avctx);
-    adec->setOptions(ac_opt);
-    if (!adec->open()) {
-        AVError e(AVError::AudioCodecNotFound);
-        qWarning() << e.string();
-        emit player->error(e);
-        return false;
+    // adec is already opened by preloading thread if gapless
+    if (!gapless || !adec || adec->codecContext() != avctx) {
+        // TODO: no delete, just reset avctx and reopen
+        if (adec) {
+            adec->disconnect();
+            delete adec;
+            adec = 0;
+        }
+        adec = createAudioDecoder(avctx, ac_opt);
+        if (!adec) {
+            AVError e(AVError::AudioCodecNotFound);
+            qWarning() << e.string();
+            emit player->error(e);
+            return false;
+        }
     }
+    QObject::connect(adec, SIGNAL(error(QtAV::AVError)), player, SIGNAL(error(QtAV::AVError)), Qt::UniqueConnection);
     correct_audio_channels(avctx);
     AudioFormat af;
     af.setSampleRate(avctx->sample_rate);
@@ -396,6 +415,12 @@ bool AVPlayer::Private::setupAudioThread(AVPlayer *player)
     }
     //af.setChannels(avctx->channels);
     // always reopen to ensure internal buffer queue inside audio backend(openal) is clear. also make it possible to change backend when replay.
+    // except gapless switching: samples of previous media in the queue are still playing
+    if (gapless && ao->isOpen() && ao->requestedFormat() == af) {
+        qDebug("gapless: keep AudioOutput open");
+        // queued samples of the previous media end where the clock of the new media starts
+        ao->rebaseTimestamps(qreal(media_start_pts)/1000.0);
+    } else {
     //if (ao->audioFormat() != af) {
         //qDebug("ao audio format is changed. reopen ao");
         ao->setAudioFormat(af); /// set before close to workaround OpenAL context lost
@@ -405,6 +430,7 @@ bool AVPlayer::Private::setupAudioThread(AVPlayer *player)
             return false;
         }
     //}
+    }
     adec->resampler()->setOutAudioFormat(ao->audioFormat());
     // no need to set resampler if AudioFrame is used
 #if !USE_AUDIO_FRAME
@@ -438,6 +464,7 @@ bool AVPlayer::Private::setupAudioThread(AVPlayer *player)
     athread->resetState();
     athread->setDecoder(adec);
     setAVOutput(ao, ao, athread);
+    athread->packetQueue()->setOwner(player);
     updateBufferValue(athread->packetQueue());
     initAudioStatistics(ademuxer->audioStream());
     return true;
@@ -523,7 +550,7 @@ bool AVPlayer::Private::tryApplyDecoderPriority(AVPlayer *player)
         if (!vd)
             continue;
         vd->setCodecContext(avctx); // It's fine because AVDecoder copy the avctx properties
-        vd->setOptions(vc_opt);
+        vd->setOptions(opt);
         if (vd->open()) {
             qDebug("**************Video decoder found:%p", vd);
             break;
@@ -568,35 +595,23 @@ bool AVPlayer::Private::setupVideoThread(AVPlayer *player)
     if (!avctx) {
         return false;
     }
-    if (vdec) {
-        vdec->disconnect();
-        delete vdec;
-        vdec = 0;
-    }
-    foreach(VideoDecoderId vid, vc_ids) {
-        qDebug("**********trying video decoder: %s...", VideoDecoder::name(vid));
-        VideoDecoder *vd = VideoDecoder::create(vid);
-        if (!vd) {
-            continue;
+    // vdec is already opened by preloading thread if gapless
+    if (!gapless || !vdec || vdec->codecContext() != avctx) {
+        if (vdec) {
+            vdec->disconnect();
+            delete vdec;
+            vdec = 0;
         }
-        //vd->isAvailable() //TODO: the value is wrong now
-        vd->setCodecContext(avctx);
-        vd->setOptions(vc_opt);
-        if (vd->open()) {
-            vdec = vd;
-            qDebug("**************Video decoder found:%p", vdec);
-            break;
+        vdec = createVideoDecoder(avctx, vc_ids, vc_opt);
+        if (!vdec) {
+            // DO NOT emit error signals in VideoDecoder::open(). 1 signal is enough
+            AVError e(AVError::VideoCodecNotFound);
+            qWarning() << e.string();
+            emit player->error(e);
+            return false;
         }
-        delete vd;
-    }
-    if (!vdec) {
-        // DO NOT emit error signals in VideoDecoder::open(). 1 signal is enough
-        AVError e(AVError::VideoCodecNotFound);
-        qWarning() << e.string();
-        emit player->error(e);
-        return false;
     }
-    QObject::connect(vdec, SIGNAL(error(QtAV::AVError)), player, SIGNAL(error(QtAV::AVError)));
+    QObject::connect(vdec, SIGNAL(error(QtAV::AVError)), player, SIGNAL(error(QtAV::AVError)), Qt::UniqueConnection);
     if (!vthread) {
         vthread = new VideoThread(player);
         vthread->setClock(clock);
@@ -622,12 +637,158 @@ bool AVPlayer::Private::setupVideoThread(AVPlayer *player)
     vthread->setBrightness(brightness);
     vthread->setContrast(contrast);
     vthread->setSaturation(saturation);
+    vthread->setHue(hue);
+    vthread->packetQueue()->setOwner(player);
     updateBufferValue(vthread->packetQueue());
     initVideoStatistics(demuxer.videoStream());
 
     return true;
 }
 
+AudioDecoder* AVPlayer::Private::createAudioDecoder(AVCodecContext *avctx, const QVariantHash &opt) const
+{
+    AudioDecoder *ad = AudioDecoder::create();
+    if (!ad) {
+        qWarning("failed to create audio decoder");
+        return 0;
+    }
+    ad->setCodecContext(avctx);
+    ad->setOptions(opt);
+    if (ad->open())
+        return ad;
+    ad->setCodecContext(0);
+    delete ad;
+    return 0;
+}
+
+VideoDecoder* AVPlayer::Private::createVideoDecoder(AVCodecContext *avctx, const QVector<VideoDecoderId> &ids, const QVariantHash &opt) const
+{
+    foreach(VideoDecoderId vid, ids) {
+        qDebug("**********trying video decoder: %s...", VideoDecoder::name(vid));
+        VideoDecoder *vd = VideoDecoder::create(vid);
+        if (!vd) {
+            continue;
+        }
+        //vd->isAvailable() //TODO: the value is wrong now
+        vd->setCodecContext(avctx);
+        vd->setOptions(opt);
+        if (vd->open()) {
+            qDebug("**************Video decoder found:%p", vd);
+            return vd;
+        }
+        delete vd;
+    }
+    return 0;
+}
+
+void AVPlayer::Private::preloadNext(AVDemuxer *next, const QVariantHash &aopt, const QVector<VideoDecoderId> &vids, const QVariantHash &vopt)
+{
+    // about 1s of packets for most media. enough to feed decoders while demux thread is restarting
+    static const int kPrefetchPackets = 64;
+    AudioDecoder *ad = 0;
+    VideoDecoder *vd = 0;
+    bool ok = false;
+    if (next->load()) {
+        // default streams are selected by load()
+        if (next->audioCodecContext())
+            ad = createAudioDecoder(next->audioCodecContext(), aopt);
+        if (next->videoCodecContext()) {
+            // hw decoders may be bound to the opening thread. they are opened in player thread as usual, see setupVideoThread()
+            if (!vids.isEmpty() && vids.first() == VideoDecoderId_FFmpeg)
+                vd = createVideoDecoder(next->videoCodecContext(), QVector<VideoDecoderId>() << VideoDecoderId_FFmpeg, vopt);
+            else
+                ok = true;
+        }
+        ok = ok || ad || vd;
+        if (ok)
+            next->prefetch(kPrefetchPackets);
+    }
+    QMutexLocker lock(&next_mutex);
+    Q_UNUSED(lock);
+    if (next == next_demuxer && ok) {
+        qDebug() << "next media is preloaded: " << next_file;
+        next_adec = ad;
+        next_vdec = vd;
+        next_ready = true;
+    } else {
+        // canceled or failed
+        if (next == next_demuxer) {
+            qWarning() << "failed to preload next media: " << next_file;
+            next_demuxer = 0;
+            next_file.clear(); // setNextFile() with the same file retries
+        }
+        if (ad) {
+            ad->setCodecContext(0);
+            delete ad;
+        }
+        if (vd) {
+            vd->setCodecContext(0);
+            delete vd;
+        }
+        next->deleteLater(); // created in player thread
+    }
+    --next_loading;
+    next_cond.wakeAll();
+}
+
+void AVPlayer::Private::releaseNext()
+{
+    if (next_adec) {
+        next_adec->setCodecContext(0);
+        delete next_adec;
+        next_adec = 0;
+    }
+    if (next_vdec) {
+        next_vdec->setCodecContext(0);
+        delete next_vdec;
+        next_vdec = 0;
+    }
+    if (next_demuxer) {
+        if (next_ready) {
+            delete next_demuxer;
+        } else {
+            // deleted by the preloading task
+            next_demuxer->setInterruptStatus(-1);
+        }
+        next_demuxer = 0;
+    }
+    next_ready = false;
+}
+
+bool AVPlayer::Private::takeNext()
+{
+    QMutexLocker lock(&next_mutex);
+    Q_UNUSED(lock);
+    if (!next_ready)
+        return false;
+    // the same as AVPlayer::unload() but no signal. the new media will be loaded immediately
+    if (adec) {
+        adec->setCodecContext(0);
+        delete adec;
+    }
+    if (vdec) {
+        vdec->setCodecContext(0);
+        delete vdec;
+    }
+    demuxer.unload();
+    // options and interrupt parameters are copied to next demuxer when preloading
+    demuxer.swap(*next_demuxer);
+    next_demuxer->deleteLater(); // created in player thread
+    next_demuxer = 0;
+    adec = next_adec;
+    vdec = next_vdec;
+    next_adec = 0;
+    next_vdec = 0;
+    next_ready = false;
+    current_source = next_file;
+    next_file.clear();
+    audio_track = video_track = subtitle_track = 0;
+    external_audio.clear();
+    loaded = true;
+    gapless = true;
+    return true;
+}
+
 // TODO: set to a lower value when buffering
 void AVPlayer::Private::updateBufferValue(PacketBuffer* buf)
 {
@@ -648,6 +809,13 @@ void AVPlayer::Private::updateBufferValue(PacketBuffer* buf)
         if (demuxer.hasAttacedPicture() || (statistics.video.frames > 0 && statistics.video.frames < bv))
             bv = qMax<qint64>(1LL, statistics.video.frames);
     }
+    buf->setBufferBytesMax(buffer_bytes_max);
+    buf->setAdaptive(adaptive_buffer && live_latency <= 0);
+    if (live_latency > 0) { // never buffer more than the target latency
+        buf->setBufferMode(BufferTime);
+        buf->setBufferValue(live_latency);
+        return;
+    }
     buf->setBufferMode(buffer_mode);
     buf->setBufferValue(buffer_value < 0LL ? bv : buffer_value);
 }
@@ -660,4 +828,54 @@ void AVPlayer::Private::updateBufferValue()
         updateBufferValue(vthread->packetQueue());
 }
 
+void AVPlayer::Private::updateLiveLatency()
+{
+    Statistics::LiveOnly &st = statistics.live_only;
+    st.target_latency = live_latency;
+    // frame drop can be cancelled by others, e.g. AVDemuxThread::stepForward()
+    st.frame_drop = vthread && vthread->isFrameDropScheduled();
+    qreal r = 1.0;
+    bool drop = false;
+    const qreal pts = read_thread ? read_thread->lastReadPts() : 0;
+    if (live_latency > 0 && pts > 0 && read_thread->isRunning() && !seeking) {
+        st.latency = qMax<qint64>(0LL, qint64((pts - clock->value())*1000.0));
+        st.max_latency = qMax(st.max_latency, st.latency);
+        const qint64 tolerance = qMax(kLiveLatencyTolerance, live_latency/4);
+        const qint64 drop_latency = qMax(kLiveFrameDropLatency, live_latency*3);
+        if (st.latency > drop_latency) {
+            r = kLiveCatchUpSpeedMax;
+            drop = true;
+        } else if (st.latency > live_latency + tolerance) {
+            r = kLiveCatchUpSpeed;
+            drop = st.frame_drop; // keep dropping until latency is almost the target value
+        } else if (st.catch_up_speed > 1.0 && st.latency > live_latency) {
+            r = kLiveCatchUpSpeed; // hysteresis
+        }
+        if (r > 1.0 && st.catch_up_speed == 1.0)
+            st.catch_up_count++;
+    }
+    if (drop != st.frame_drop) {
+        qDebug("live latency %lld/%lldms. frame drop: %d", st.latency, live_latency, drop);
+        if (vthread)
+            vthread->scheduleFrameDrop(drop);
+        st.frame_drop = drop;
+    }
+    if (r == st.catch_up_speed)
+        return;
+    qDebug("live latency %lld/%lldms. catch up speed: %.2f", st.latency, live_latency, r);
+    st.catch_up_speed = r;
+    applySpeed();
+}
+
+void AVPlayer::Private::applySpeed()
+{
+    if (force_fps > 0) // speed is computed from forced frame rate
+        return;
+    const qreal r = speed*statistics.live_only.catch_up_speed;
+    //TODO: check clock type?
+    if (ao && ao->isAvailable())
+        ao->setSpeed(r);
+    clock->setSpeed(r);
+}
+
 } //namespace QtAV
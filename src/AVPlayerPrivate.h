@@ -27,6 +27,7 @@
 #include "AudioThread.h"
 #include "VideoThread.h"
 #include "AVDemuxThread.h"
+#include <QtCore/QWaitCondition>
 #include "utils/Logger.h"
 
 namespace QtAV {
@@ -52,10 +53,26 @@ public:
     bool applySubtitleStream(int n, AVPlayer *player);
     bool setupAudioThread(AVPlayer *player);
     bool setupVideoThread(AVPlayer *player);
+    // return an opened decoder, or null if failed. options are passed because preloading runs in loader thread
+    AudioDecoder* createAudioDecoder(AVCodecContext *avctx, const QVariantHash& opt) const;
+    VideoDecoder* createVideoDecoder(AVCodecContext *avctx, const QVector<VideoDecoderId>& ids, const QVariantHash& opt) const;
+    /*!
+     * gapless playback. run in loader thread: open the next demuxer and decoders, read some packets.
+     * decoder options are copied in player thread. hw video decoders are not preloaded but opened in player thread
+     */
+    void preloadNext(AVDemuxer *next, const QVariantHash& aopt, const QVector<VideoDecoderId>& vids, const QVariantHash& vopt);
+    // release the preloaded media, or interrupt it if it's preloading. next_mutex must be locked
+    void releaseNext();
+    // replace current demuxer and decoders with the preloaded ones. called in demux thread when media ends
+    bool takeNext();
     bool tryApplyDecoderPriority(AVPlayer *player);
     // TODO: what if buffer mode changed during playback?
     void updateBufferValue(PacketBuffer *buf);
     void updateBufferValue();
+    // live mode: measure latency and catch up if too large. called periodically when playing
+    void updateLiveLatency();
+    // apply user speed and live catch up speed to audio output and clock
+    void applySpeed();
     //TODO: addAVOutput()
     template<class Out>
     void setAVOutput(Out *&pOut, Out *pNew, AVThread *thread) {
@@ -125,6 +142,9 @@ public:
     QVariantList audio_tracks;
     BufferMode buffer_mode;
     qint64 buffer_value;
+    qint64 live_latency; // ms. <=0: not live mode
+    qint64 buffer_bytes_max;
+    bool adaptive_buffer;
     //the following things are required and must be set not null
     AVDemuxer demuxer;
     AVDemuxThread *read_thread;
@@ -141,7 +161,7 @@ public:
     qreal speed;
     OutputSet *vos, *aos;
     QVector<VideoDecoderId> vc_ids;
-    int brightness, contrast, saturation;
+    int brightness, contrast, saturation, hue;
 
     QVariantHash ac_opt, vc_opt;
 
@@ -157,6 +177,16 @@ public:
     AVPlayer::State state;
     MediaEndAction end_action;
     QMutex load_mutex;
+    // gapless playback. the following next_* are guarded by next_mutex
+    QString next_file;
+    AVDemuxer *next_demuxer; // preloading if not null and !next_ready
+    AudioDecoder *next_adec;
+    VideoDecoder *next_vdec;
+    bool next_ready;
+    int next_loading; // number of running preloading tasks
+    QMutex next_mutex;
+    QWaitCondition next_cond;
+    bool gapless; // switching to the preloaded media: decoders are opened, ao is not reopened
 };
 
 } //namespace QtAV
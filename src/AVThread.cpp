@@ -155,9 +155,15 @@ void AVThread::scheduleFrameDrop(bool value)
                 decoder->setOptions(AVThreadPrivate::dec_opt_normal);
         }
     };
+    d_func().frame_drop_scheduled.fetchAndStoreRelaxed(value);
     scheduleTask(new FrameDropTask(decoder(), value));
 }
 
+bool AVThread::isFrameDropScheduled() const
+{
+    return !!const_cast<QAtomicInt&>(d_func().frame_drop_scheduled).fetchAndAddRelaxed(0);
+}
+
 qreal AVThread::previousHistoryPts() const
 {
     DPTR_D(const AVThread);
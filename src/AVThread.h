@@ -77,6 +77,8 @@ public:
     void scheduleTask(QRunnable *task);
     void requestSeek();
     void scheduleFrameDrop(bool value = true);
+    /// value of the last scheduleFrameDrop(). thread safe
+    bool isFrameDropScheduled() const;
     qreal previousHistoryPts() const; //move to statistics?
     qreal decodeFrameRate() const; //move to statistics?
     void setDropFrameOnSeek(bool value);
@@ -95,6 +95,7 @@ public:
     qreal render_pts0;
 
     static QVariantHash dec_opt_framedrop, dec_opt_normal;
+    QAtomicInt frame_drop_scheduled; // value of the last scheduleFrameDrop()
     bool drop_frame_seek;
     ring<qreal> pts_history;
 
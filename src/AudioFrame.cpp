@@ -23,6 +23,7 @@
 #include "QtAV/private/Frame_p.h"
 #include "QtAV/AudioResampler.h"
 #include "QtAV/private/AVCompat.h"
+#include <QtCore/QMutex>
 #include "utils/Logger.h"
 
 namespace QtAV {
@@ -33,6 +34,92 @@ static const struct RegisterMetaTypes
         qRegisterMetaType<QtAV::AudioFrame>("QtAV::AudioFrame");
     }
 } _registerMetaTypes;
+
+/*!
+ * Idle resamplers used by AudioFrame::to() if no resampler is attached to the frame. A resampler is taken by one thread at
+ * a time. Resamplers are reused for the same in/out formats, so no context is reinitialized when converting a stream.
+ * A context converting the sample rate buffers delayed samples. It's reinitialized only if it's taken for a frame which does
+ * not continue the last frame it converted, i.e. maybe another stream or after a seek
+ */
+class ResamplerCache
+{
+public:
+    enum { MaxIdle = 4 };
+    ~ResamplerCache() {
+        foreach (const Entry& e, idle) {
+            delete e.conv;
+        }
+    }
+    /// \a pts: timestamp of the frame to convert
+    AudioResampler* take(const AudioFormat& in, const AudioFormat& out, qreal pts) {
+        AudioResampler *conv = 0;
+        bool continued = false;
+        {
+            QMutexLocker lock(&mutex);
+            Q_UNUSED(lock);
+            int found = -1;
+            for (int i = idle.size() - 1; i >= 0; --i) {
+                const Entry &e = idle.at(i);
+                if (e.in != in || e.out != out)
+                    continue;
+                if (qAbs(e.next_pts - pts) < kContinuedPtsError) {
+                    found = i;
+                    continued = true;
+                    break;
+                }
+                if (found < 0)
+                    found = i;
+            }
+            if (found >= 0)
+                conv = idle.takeAt(found).conv;
+        }
+        // rate conversion keeps delayed samples of the last frame converted, maybe from another stream. drop them
+        if (conv && !continued && in.sampleRate() != out.sampleRate() && !conv->prepare()) {
+            delete conv;
+            conv = 0;
+        }
+        if (conv)
+            return conv;
+        conv = AudioResampler::create(AudioResamplerId_FF);
+        if (!conv)
+            conv = AudioResampler::create(AudioResamplerId_Libav);
+        return conv;
+    }
+    /// \a nextPts: end time of the frame converted, i.e. timestamp of the next frame of the same stream
+    void put(AudioResampler* conv, const AudioFormat& in, const AudioFormat& out, qreal nextPts) {
+        Entry e;
+        e.conv = conv;
+        e.in = in;
+        e.out = out;
+        e.next_pts = nextPts;
+        AudioResampler *evicted = 0;
+        {
+            QMutexLocker lock(&mutex);
+            Q_UNUSED(lock);
+            idle.append(e);
+            if (idle.size() > MaxIdle)
+                evicted = idle.takeFirst().conv;
+        }
+        delete evicted;
+    }
+private:
+    static const qreal kContinuedPtsError; // timestamps of decoded frames are not exact
+    struct Entry {
+        AudioResampler *conv;
+        AudioFormat in, out;
+        qreal next_pts;
+    };
+    QMutex mutex;
+    QList<Entry> idle;
+};
+
+const qreal ResamplerCache::kContinuedPtsError = 0.002;
+
+ResamplerCache& resamplerCache()
+{
+    static ResamplerCache c;
+    return c;
+}
 }
 
 class AudioFramePrivate : public FramePrivate
@@ -76,6 +163,7 @@ AudioFrame::AudioFrame(const AudioFormat &format, const QByteArray& data)
     Q_D(AudioFrame);
     d->format = format;
     d->data = data;
+    d->accountData(MemoryAccounting::AudioFrames);
     if (!d->format.isValid())
         return;
     if (d->data.isEmpty())
@@ -119,6 +207,7 @@ QByteArray AudioFrame::data()
     if (d->data.isEmpty()) {
         AudioFrame a(clone());
         d->data = a.data();
+        d->accountData(MemoryAccounting::AudioFrames);
     }
     return d->data;
 }
@@ -165,7 +254,8 @@ AudioFrame AudioFrame::mid(int pos, int len) const
         lenBytes = bufSize;
     }
 
-    QByteArray buf(bufSize * planeCount(), 0);
+    QByteArray buf;
+    buf.resize(bufSize * planeCount()); // fully written below, no need to zero fill
     char *dst = buf.data(); //must before buf is shared, otherwise data will be detached.
 
     for (int i = 0; i < planeCount(); ++i) {
@@ -251,29 +341,31 @@ AudioFrame AudioFrame::to(const AudioFormat &fmt) const
     //if (fmt == format())
       //  return clone(); //FIXME: clone a frame from ffmpeg is not enough?
     Q_D(const AudioFrame);
-    // TODO: use a pool
     AudioResampler *conv = d->conv;
-    QScopedPointer<AudioResampler> c;
-    if (!conv) {
-        conv = AudioResampler::create(AudioResamplerId_FF);
-        if (!conv)
-            conv = AudioResampler::create(AudioResamplerId_Libav);
+    const bool cached = !conv;
+    if (cached) {
+        conv = resamplerCache().take(format(), fmt, timestamp());
         if (!conv) {
             qWarning("no audio resampler is available");
             return AudioFrame();
         }
-        c.reset(conv);
     }
     conv->setInAudioFormat(format());
     conv->setOutAudioFormat(fmt);
     //conv->prepare(); // already called in setIn/OutFormat
     conv->setInSampesPerChannel(samplesPerChannel()); //TODO
-    if (!conv->convert((const quint8**)d->planes.constData())) {
+    const bool ok = conv->convert((const quint8**)d->planes.constData());
+    AudioFrame f;
+    if (ok) {
+        f = AudioFrame(fmt, conv->outData());
+        f.setSamplesPerChannel(conv->outSamplesPerChannel());
+    }
+    if (cached)
+        resamplerCache().put(conv, format(), fmt, timestamp() + qreal(duration())/1000000.0);
+    if (!ok) {
         qWarning() << "AudioFrame::to error: " << format() << "=>" << fmt;
         return AudioFrame();
     }
-    AudioFrame f(fmt, conv->outData());
-    f.setSamplesPerChannel(conv->outSamplesPerChannel());
     f.setTimestamp(timestamp());
     f.d_ptr->metadata = d->metadata; // need metadata?
     return f;
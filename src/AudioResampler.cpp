@@ -94,8 +94,10 @@ qreal AudioResampler::speed() const
 void AudioResampler::setInAudioFormat(const AudioFormat& format)
 {
     DPTR_D(AudioResampler);
-    if (d.in_format == format)
+    // compare with the requested format too, otherwise an incomplete format always reinitializes the resampler
+    if (d.in_format == format || d.in_format_requested == format)
         return;
+    d.in_format_requested = format;
     d.in_format = format;
     prepare();
 }
@@ -113,8 +115,10 @@ const AudioFormat& AudioResampler::inAudioFormat() const
 void AudioResampler::setOutAudioFormat(const AudioFormat& format)
 {
     DPTR_D(AudioResampler);
-    if (d.out_format == format)
+    // compare with the requested format too, otherwise an incomplete format always reinitializes the resampler
+    if (d.out_format == format || d.out_format_requested == format)
         return;
+    d.out_format_requested = format;
     d.out_format = format;
     prepare();
 }
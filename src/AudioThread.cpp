@@ -28,6 +28,7 @@
 #include "QtAV/AudioResampler.h"
 #include "QtAV/AVClock.h"
 #include "QtAV/Filter.h"
+#include "QtAV/Statistics.h"
 #include "output/OutputSet.h"
 #include "QtAV/private/AVCompat.h"
 #include <QtCore/QCoreApplication>
@@ -118,7 +119,11 @@ void AudioThread::run()
             //qDebug("eof pkt: %d valid: %d, aqueue size: %d, abuffer: %d %.3f %d, fake_duration: %lld", pkt.isEOF(), pkt.isValid(), d.packets.size(), d.packets.bufferValue(), d.packets.bufferMax(), d.packets.isFull(), fake_duration);
             // If seek requested but last decode failed
             if (!pkt.isEOF() && (fake_duration <= 0 || !d.packets.isEmpty())) {
+                const qint64 t_wait = Statistics::Pipeline::now();
                 pkt = d.packets.take(); //wait to dequeue
+                d.statistics->pipeline.record(Statistics::Pipeline::AudioQueueWait, t_wait);
+                d.statistics->audio.buffered_bytes = d.packets.bufferedBytes();
+                d.statistics->audio.buffered_time = d.packets.bufferedTime();
             }
             if (pkt.isEOF()) {
                 fake_duration = 0; //avoid endless wait
@@ -267,6 +272,7 @@ void AudioThread::run()
             break;
         }
         //qDebug("apkt: %.3f, %lld %p", pkt.pts, pkt.asAVPacket()->pts, pkt.asAVPacket()->data);
+        const qint64 t_dec = Statistics::Pipeline::now();
         if (!dec->decode(pkt)) {
             qWarning("Decode audio failed. undecoded: %d", dec->undecodedSize());
             if (pkt.isEOF()) {
@@ -292,6 +298,7 @@ void AudioThread::run()
             d.last_pts = d.clock->value(); //not pkt.pts! the delay is updated!
             continue;
         }
+        d.statistics->pipeline.record(Statistics::Pipeline::AudioDecode, t_dec);
         // reduce here to ensure to decode the rest data in the next loop
         if (!pkt.isEOF())
             pkt.skip(pkt.data.size() - dec->undecodedSize());
@@ -299,6 +306,7 @@ void AudioThread::run()
         AudioFrame frame(dec->frame());
         if (!frame)
             continue; //pkt data is updated after decode, no reset here
+        frame.setMemoryOwner(d.packets.owner());
         if (frame.timestamp() <= 0)
             frame.setTimestamp(pkt.pts); // pkt.pts is wrong. >= real timestamp
         if (d.render_pts0 >= 0.0) { // seeking
@@ -316,12 +324,14 @@ void AudioThread::run()
             }
         }
         if (has_ao) {
+            const qint64 t_filter = Statistics::Pipeline::now();
             applyFilters(frame);
             frame.setAudioResampler(dec->resampler()); //!!!
             // FIXME: resample ONCE is required for audio frames from ffmpeg
             //if (ao->audioFormat() != frame.format()) {
                 frame = frame.to(ao->audioFormat());
             //}
+            d.statistics->pipeline.record(Statistics::Pipeline::AudioFilter, t_filter);
         }
         QByteArray decoded(frame.data());
 #else
@@ -344,7 +354,12 @@ void AudioThread::run()
             if (has_ao && ao->isOpen()) {
                 QByteArray decodedChunk = QByteArray::fromRawData(decoded.constData() + decodedPos, chunk);
                 //qDebug("ao.timestamp: %.3f, pts: %.3f, pktpts: %.3f", ao->timestamp(), pts, pkt.pts);
+                const qint64 t_play = Statistics::Pipeline::now();
                 ao->play(decodedChunk, pts);
+                d.statistics->pipeline.record(Statistics::Pipeline::AudioOutput, t_play);
+                Statistics::LoadOnly &lo = d.statistics->load_only;
+                if (lo.first_frame_time < 0 && lo.start > 0 && !d.statistics->video.available)
+                    lo.first_frame_time = (Statistics::Pipeline::now() - lo.start)/1000LL;
                 if (!is_external_clock && ao->timestamp() > 0) {//TODO: clear ao buffer
                    // const qreal da = qAbs(pts - ao->timestamp());
                    // if (da > 1.0) { // what if frame duration is long?
@@ -54,6 +54,24 @@ int Frame::bytesPerLine(int plane) const
     return d_func()->line_sizes[plane];
 }
 
+bool Frame::isDataWritable() const
+{
+    Q_D(const Frame);
+    if (!d->buffer)
+        return false;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    return d->ref.load() == 1 && d->buffer->ref.load() == 1;
+#else
+    return int(d->ref) == 1 && int(d->buffer->ref) == 1;
+#endif
+}
+
+void Frame::setMemoryOwner(const void *owner)
+{
+    Q_D(Frame);
+    d->setAccountedOwner(owner);
+}
+
 QByteArray Frame::frameData() const
 {
     return d_func()->data;
@@ -0,0 +1,268 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#include "QtAV/FrameAllocator.h"
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+#include <stdlib.h>
+#ifdef Q_OS_WIN
+#include <malloc.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/mman.h>
+#endif
+#include "utils/Logger.h"
+
+namespace QtAV {
+namespace {
+static const int kHugePageSize = 2*1024*1024;
+
+void* alignedMalloc(size_t size, size_t alignment)
+{
+#ifdef Q_OS_WIN
+    return _aligned_malloc(size, alignment);
+#else
+    void *ptr = 0;
+    if (alignment < sizeof(void*))
+        alignment = sizeof(void*);
+    if (posix_memalign(&ptr, alignment, size) != 0)
+        return 0;
+    return ptr;
+#endif
+}
+
+void alignedFree(void *ptr)
+{
+#ifdef Q_OS_WIN
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+// 8 size classes for each power of 2. small buffers are rounded to cache line size
+int sizeClass(int size)
+{
+    if (size <= 4096)
+        return (size + 63) & ~63;
+    int p = 4096;
+    while (p <= size/2)
+        p *= 2;
+    const int step = p/8;
+    return (size + step - 1)/step*step;
+}
+
+QAtomicPointer<FrameAllocator> gAllocator;
+} //namespace
+
+FrameAllocator* FrameAllocator::current()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    FrameAllocator *a = gAllocator.loadAcquire();
+#else
+    FrameAllocator *a = gAllocator;
+#endif
+    if (a)
+        return a;
+    return FramePool::instance();
+}
+
+void FrameAllocator::setCurrent(FrameAllocator *allocator)
+{
+    gAllocator.fetchAndStoreOrdered(allocator);
+}
+
+class FramePool::Private
+{
+public:
+    Private()
+        : max_pooled_bytes(64*1024*1024)
+        , pooled_bytes(0)
+        , huge_pages(false)
+        , allocations(0)
+        , hits(0)
+    {}
+    ~Private() {
+        clear();
+    }
+    void clear() {
+        QHash<quint64, QVector<void*> >::iterator it = free_list.begin();
+        for (; it != free_list.end(); ++it) {
+            foreach (void* p, it.value()) {
+                alignedFree(p);
+            }
+        }
+        free_list.clear();
+        pooled_bytes = 0;
+    }
+    static quint64 key(int size_class, int alignment) {
+        return (quint64(size_class) << 32) | quint32(alignment);
+    }
+
+    mutable QMutex mutex;
+    qint64 max_pooled_bytes;
+    qint64 pooled_bytes;
+    bool huge_pages;
+    qint64 allocations;
+    qint64 hits;
+    QHash<quint64, QVector<void*> > free_list;
+};
+
+FramePool* FramePool::instance()
+{
+    // never deleted. frames can be released after static objects are destroyed
+    static FramePool *pool = new FramePool();
+    return pool;
+}
+
+FramePool::FramePool()
+    : d(new Private())
+{
+}
+
+FramePool::~FramePool()
+{
+}
+
+void* FramePool::allocate(int size, int alignment)
+{
+    if (size <= 0)
+        return 0;
+    const int s = sizeClass(size);
+    bool huge = false;
+    {
+        QMutexLocker lock(&d->mutex);
+        Q_UNUSED(lock);
+        huge = d->huge_pages && s >= kHugePageSize;
+        d->allocations++;
+        QHash<quint64, QVector<void*> >::iterator it = d->free_list.find(Private::key(s, alignment));
+        if (it != d->free_list.end() && !it.value().isEmpty()) {
+            void *p = it.value().last();
+            it.value().pop_back();
+            d->pooled_bytes -= s;
+            d->hits++;
+            return p;
+        }
+    }
+    void *p = alignedMalloc(s, huge ? qMax(alignment, kHugePageSize) : alignment);
+    if (!p) {
+        qWarning("FramePool: failed to allocate %d bytes", s);
+        return 0;
+    }
+#if defined(Q_OS_LINUX) && defined(MADV_HUGEPAGE)
+    if (huge)
+        madvise(p, s, MADV_HUGEPAGE);
+#endif
+    return p;
+}
+
+void FramePool::deallocate(void *ptr, int size, int alignment)
+{
+    if (!ptr)
+        return;
+    const int s = sizeClass(size);
+    QMutexLocker lock(&d->mutex);
+    Q_UNUSED(lock);
+    if (d->pooled_bytes + s > d->max_pooled_bytes) {
+        alignedFree(ptr);
+        return;
+    }
+    d->free_list[Private::key(s, alignment)].append(ptr);
+    d->pooled_bytes += s;
+}
+
+void FramePool::setMaxPooledBytes(qint64 bytes)
+{
+    QMutexLocker lock(&d->mutex);
+    Q_UNUSED(lock);
+    d->max_pooled_bytes = qMax<qint64>(0, bytes);
+    if (d->pooled_bytes > d->max_pooled_bytes)
+        d->clear();
+}
+
+qint64 FramePool::maxPooledBytes() const
+{
+    QMutexLocker lock(&d->mutex);
+    Q_UNUSED(lock);
+    return d->max_pooled_bytes;
+}
+
+void FramePool::setHugePagesEnabled(bool value)
+{
+    QMutexLocker lock(&d->mutex);
+    Q_UNUSED(lock);
+    d->huge_pages = value;
+}
+
+bool FramePool::isHugePagesEnabled() const
+{
+    QMutexLocker lock(&d->mutex);
+    Q_UNUSED(lock);
+    return d->huge_pages;
+}
+
+void FramePool::clear()
+{
+    QMutexLocker lock(&d->mutex);
+    Q_UNUSED(lock);
+    d->clear();
+}
+
+qint64 FramePool::pooledBytes() const
+{
+    QMutexLocker lock(&d->mutex);
+    Q_UNUSED(lock);
+    return d->pooled_bytes;
+}
+
+qint64 FramePool::allocations() const
+{
+    QMutexLocker lock(&d->mutex);
+    Q_UNUSED(lock);
+    return d->allocations;
+}
+
+qint64 FramePool::hits() const
+{
+    QMutexLocker lock(&d->mutex);
+    Q_UNUSED(lock);
+    return d->hits;
+}
+
+qreal FramePool::hitRate() const
+{
+    QMutexLocker lock(&d->mutex);
+    Q_UNUSED(lock);
+    if (d->allocations <= 0)
+        return 0;
+    return qreal(d->hits)/qreal(d->allocations);
+}
+
+void FramePool::resetStatistics()
+{
+    QMutexLocker lock(&d->mutex);
+    Q_UNUSED(lock);
+    d->allocations = 0;
+    d->hits = 0;
+}
+} //namespace QtAV
@@ -198,6 +198,11 @@ QVector<int> ImageConverter::outLineSizes() const
 bool ImageConverter::convert(const quint8 * const src[], const int srcStride[])
 {
     DPTR_D(ImageConverter);
+    // planes may point to the caller's buffer after convert(src, srcStride, dst, dstStride)
+    if (!d.update_data && !d.bits.isEmpty()) {
+        const quint8 *out = (const quint8*)d.data_out.constData();
+        d.update_data = d.bits[0] < out || d.bits[0] >= out + d.data_out.size();
+    }
     if (d.update_data && !prepareData()) {
         qWarning("prepair output data error");
         return false;
@@ -225,6 +230,8 @@ bool ImageConverter::prepareData()
     if (s < 0)
         return false;
     d.data_out.resize(s + kAlign-1);
+    MemoryAccounting::add(MemoryAccounting::ConverterBuffers, d.data_out.size() - d.accounted_bytes);
+    d.accounted_bytes = d.data_out.size();
     d.out_offset = (kAlign - ((uintptr_t)d.data_out.constData() & (kAlign-1))) & (kAlign-1);
     AV_ENSURE(av_image_fill_pointers((uint8_t**)d.bits.constData(), d.fmt_out, d.h_out, (uint8_t*)d.data_out.constData()+d.out_offset, d.pitchs.constData()), false);
     // TODO: special formats
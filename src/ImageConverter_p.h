@@ -24,6 +24,7 @@
 #define QTAV_IMAGECONVERTER_P_H
 
 #include <QtAV/private/AVCompat.h>
+#include <QtAV/MemoryAccounting.h>
 #include <QtCore/QVector>
 
 namespace QtAV {
@@ -44,10 +45,14 @@ public:
         , saturation(0)
         , update_data(true)
         , out_offset(0)
+        , accounted_bytes(0)
     {
         bits.reserve(8);
         pitchs.reserve(8);
     }
+    virtual ~ImageConverterPrivate() {
+        MemoryAccounting::add(MemoryAccounting::ConverterBuffers, -accounted_bytes);
+    }
     virtual bool setupColorspaceDetails(bool force = true) {
         Q_UNUSED(force);
         return true;
@@ -60,6 +65,7 @@ public:
     bool update_data;
     int out_offset;
     QByteArray data_out;
+    qint64 accounted_bytes; // data_out size counted in MemoryAccounting
     QVector<quint8*> bits;
     QVector<int> pitchs;
 };
@@ -0,0 +1,182 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#include "QtAV/MemoryAccounting.h"
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+
+namespace QtAV {
+namespace {
+class Counters
+{
+public:
+    Counters() {
+        for (int i = 0; i <= MemoryAccounting::Total; ++i) {
+            bytes[i] = 0;
+            peak[i] = 0;
+            budget[i] = 0;
+        }
+    }
+    struct OwnerBytes {
+        OwnerBytes() {
+            for (int i = 0; i < MemoryAccounting::CategoryCount; ++i)
+                bytes[i] = 0;
+        }
+        qint64 bytes[MemoryAccounting::CategoryCount];
+    };
+
+    QMutex mutex;
+    qint64 bytes[MemoryAccounting::Total+1];
+    qint64 peak[MemoryAccounting::Total+1];
+    qint64 budget[MemoryAccounting::Total+1];
+    QHash<const void*, OwnerBytes> owners;
+};
+
+Counters& counters()
+{
+    static Counters c;
+    return c;
+}
+
+bool isValid(MemoryAccounting::Category category)
+{
+    return category >= MemoryAccounting::Packets && category <= MemoryAccounting::Total;
+}
+} //namespace
+
+void MemoryAccounting::add(Category category, qint64 bytes, const void *owner)
+{
+    if (!bytes || category < Packets || category >= CategoryCount)
+        return;
+    Counters &c = counters();
+    QMutexLocker lock(&c.mutex);
+    Q_UNUSED(lock);
+    c.bytes[category] += bytes;
+    c.bytes[Total] += bytes;
+    if (c.bytes[category] > c.peak[category])
+        c.peak[category] = c.bytes[category];
+    if (c.bytes[Total] > c.peak[Total])
+        c.peak[Total] = c.bytes[Total];
+    if (!owner)
+        return;
+    QHash<const void*, Counters::OwnerBytes>::iterator it = c.owners.find(owner);
+    if (it == c.owners.end())
+        it = c.owners.insert(owner, Counters::OwnerBytes());
+    it->bytes[category] += bytes;
+    for (int i = 0; i < CategoryCount; ++i) {
+        if (it->bytes[i])
+            return;
+    }
+    c.owners.erase(it); // owner released all memory. the pointer may be reused by another object
+}
+
+qint64 MemoryAccounting::bytes(Category category)
+{
+    if (!isValid(category))
+        return 0;
+    Counters &c = counters();
+    QMutexLocker lock(&c.mutex);
+    Q_UNUSED(lock);
+    return c.bytes[category];
+}
+
+qint64 MemoryAccounting::peakBytes(Category category)
+{
+    if (!isValid(category))
+        return 0;
+    Counters &c = counters();
+    QMutexLocker lock(&c.mutex);
+    Q_UNUSED(lock);
+    return c.peak[category];
+}
+
+void MemoryAccounting::resetPeak()
+{
+    Counters &c = counters();
+    QMutexLocker lock(&c.mutex);
+    Q_UNUSED(lock);
+    for (int i = 0; i <= Total; ++i)
+        c.peak[i] = c.bytes[i];
+}
+
+qint64 MemoryAccounting::ownerBytes(const void *owner, Category category)
+{
+    if (!owner || !isValid(category))
+        return 0;
+    Counters &c = counters();
+    QMutexLocker lock(&c.mutex);
+    Q_UNUSED(lock);
+    QHash<const void*, Counters::OwnerBytes>::const_iterator it = c.owners.constFind(owner);
+    if (it == c.owners.constEnd())
+        return 0;
+    if (category != Total)
+        return it->bytes[category];
+    qint64 s = 0;
+    for (int i = 0; i < CategoryCount; ++i)
+        s += it->bytes[i];
+    return s;
+}
+
+void MemoryAccounting::setBudget(Category category, qint64 bytes)
+{
+    if (!isValid(category))
+        return;
+    Counters &c = counters();
+    QMutexLocker lock(&c.mutex);
+    Q_UNUSED(lock);
+    c.budget[category] = qMax<qint64>(0, bytes);
+}
+
+qint64 MemoryAccounting::budget(Category category)
+{
+    if (!isValid(category))
+        return 0;
+    Counters &c = counters();
+    QMutexLocker lock(&c.mutex);
+    Q_UNUSED(lock);
+    return c.budget[category];
+}
+
+bool MemoryAccounting::isOverBudget(Category category)
+{
+    if (!isValid(category))
+        return false;
+    Counters &c = counters();
+    QMutexLocker lock(&c.mutex);
+    Q_UNUSED(lock);
+    if (c.budget[category] > 0 && c.bytes[category] >= c.budget[category])
+        return true;
+    return c.budget[Total] > 0 && c.bytes[Total] >= c.budget[Total];
+}
+
+const char* MemoryAccounting::name(Category category)
+{
+    switch (category) {
+    case Packets: return "packets";
+    case VideoFrames: return "video frames";
+    case AudioFrames: return "audio frames";
+    case ConverterBuffers: return "converter buffers";
+    case AudioOutputBuffers: return "audio output buffers";
+    case Total: return "total";
+    default: return "unknown";
+    }
+}
+} //namespace QtAV
@@ -21,9 +21,48 @@
 
 #include "PacketBuffer.h"
 #include <QtCore/QDateTime>
+#include <limits>
+#include "QtAV/MemoryAccounting.h"
 
 namespace QtAV {
 static const int kAvgSize = 16;
+static const qint64 kSpeedInterval = 500; // ms
+static const qreal kAdaptiveScale = 4.0;
+
+// bytes in all queues are counted by MemoryAccounting::Packets in steps, so the global mutex and budget are not used for every packet
+static const qint64 kAccountingStep = 64*1024;
+static QAtomicInt global_queues;
+// QAtomicInt value in Qt4 and Qt5
+static inline int atomicValue(const QAtomicInt& a) { return const_cast<QAtomicInt&>(a).fetchAndAddRelaxed(0); }
+
+PacketBuffer::Speed::Speed()
+{
+    reset();
+}
+
+void PacketBuffer::Speed::reset()
+{
+    v = t = 0;
+    dv = dt = 0;
+    speed = 0;
+}
+
+void PacketBuffer::Speed::update(qint64 value, qint64 time, bool count)
+{
+    const qint64 delta = value - v;
+    if (count && t > 0 && delta >= 0) { // delta < 0: seek, mode change etc.
+        dv += delta;
+        dt += time - t;
+        if (dt >= kSpeedInterval) {
+            const qreal s = qreal(dv)*1000.0/qreal(dt);
+            speed = speed > 0 ? (speed + s)*0.5 : s;
+            dv = dt = 0;
+        }
+    }
+    v = value;
+    t = time;
+}
+
 PacketBuffer::PacketBuffer()
     : m_mode(BufferTime)
     , m_buffering(true) // in buffering state at the beginning
@@ -32,16 +71,34 @@ PacketBuffer::PacketBuffer()
     , m_value0(0)
     , m_value1(0)
     , m_history(kAvgSize)
+    , m_bytes(0)
+    , m_bytes_max(0)
+    , m_owner(0)
+    , m_accounted(0)
+    , m_over_share(false)
+    , m_time0(0)
+    , m_time1(0)
+    , m_adaptive(false)
+    , m_adaptive_value(0)
+    , m_put(0)
+    , m_taken(0)
+    , m_throttled(false)
 {
+    global_queues.ref();
 }
 
 PacketBuffer::~PacketBuffer()
 {
+    global_queues.deref();
+    MemoryAccounting::add(MemoryAccounting::Packets, -m_accounted, m_owner);
 }
 
 void PacketBuffer::setBufferMode(BufferMode mode)
 {
     m_mode = mode;
+    m_put = m_taken = 0;
+    m_input.reset();
+    m_output.reset();
     if (queue.isEmpty()) {
         m_value0 = m_value1 = 0;
         return;
@@ -61,6 +118,7 @@ BufferMode PacketBuffer::bufferMode() const
 void PacketBuffer::setBufferValue(qint64 value)
 {
     m_buffer = value;
+    update_adaptive_value();
 }
 
 qint64 PacketBuffer::bufferValue() const
@@ -95,7 +153,7 @@ bool PacketBuffer::isBuffering() const
 
 qreal PacketBuffer::bufferProgress() const
 {
-    const qreal p = qreal(buffered())/qreal(bufferValue());
+    const qreal p = qreal(buffered())/qreal(adaptiveBufferValue());
     return qMax<qreal>(qMin<qreal>(p, 1.0), 0.0);
 }
 
@@ -109,18 +167,118 @@ qreal PacketBuffer::bufferSpeedInBytes() const
     return calc_speed(true);
 }
 
+void PacketBuffer::setBufferBytesMax(qint64 bytes)
+{
+    m_bytes_max = qMax<qint64>(0, bytes);
+}
+
+qint64 PacketBuffer::bufferBytesMax() const
+{
+    return m_bytes_max;
+}
+
+void PacketBuffer::setGlobalBufferBytesMax(qint64 bytes)
+{
+    MemoryAccounting::setBudget(MemoryAccounting::Packets, bytes);
+}
+
+qint64 PacketBuffer::globalBufferBytesMax()
+{
+    return MemoryAccounting::budget(MemoryAccounting::Packets);
+}
+
+qint64 PacketBuffer::globalBufferedBytes()
+{
+    return MemoryAccounting::bytes(MemoryAccounting::Packets);
+}
+
+void PacketBuffer::setOwner(const void *owner)
+{
+    if (m_owner == owner)
+        return;
+    MemoryAccounting::add(MemoryAccounting::Packets, -m_accounted, m_owner);
+    m_owner = owner;
+    MemoryAccounting::add(MemoryAccounting::Packets, m_accounted, m_owner);
+}
+
+const void* PacketBuffer::owner() const
+{
+    return m_owner;
+}
+
+void PacketBuffer::setAdaptive(bool value)
+{
+    m_adaptive = value;
+    update_adaptive_value();
+}
+
+bool PacketBuffer::isAdaptive() const
+{
+    return m_adaptive;
+}
+
+qint64 PacketBuffer::adaptiveBufferValue() const
+{
+    return m_adaptive ? m_adaptive_value : m_buffer;
+}
+
+qint64 PacketBuffer::bufferedBytes() const
+{
+    return atomicValue(m_bytes);
+}
+
+qint64 PacketBuffer::bufferedTime() const
+{
+    return qMax<qint64>(0, m_time1 - m_time0);
+}
+
+qreal PacketBuffer::inputSpeed() const
+{
+    return m_input.speed;
+}
+
+qreal PacketBuffer::outputSpeed() const
+{
+    return m_output.speed;
+}
+
 bool PacketBuffer::checkEnough() const
 {
-    return buffered() >= bufferValue();
+    if (m_bytes_max > 0 && bufferedBytes() >= m_bytes_max)
+        return true;
+    return buffered() >= adaptiveBufferValue();
 }
 
 bool PacketBuffer::checkFull() const
 {
-    return buffered() >= qint64(qreal(bufferValue())*bufferMax());
+    if (m_bytes_max > 0 && bufferedBytes() >= m_bytes_max)
+        return true;
+    if (m_over_share)
+        return true;
+    return buffered() >= qint64(qreal(adaptiveBufferValue())*bufferMax());
+}
+
+void PacketBuffer::update_accounting(bool force)
+{
+    const qint64 bytes = bufferedBytes();
+    if (!force && qAbs(bytes - m_accounted) < kAccountingStep)
+        return;
+    MemoryAccounting::add(MemoryAccounting::Packets, bytes - m_accounted, m_owner);
+    m_accounted = bytes;
+    m_over_share = false;
+    if (bytes > 0 && MemoryAccounting::isOverBudget(MemoryAccounting::Packets)) {
+        const int queues = qMax(1, atomicValue(global_queues));
+        // a queue holding at least an equal share can not grow
+        m_over_share = bytes*qint64(queues) >= MemoryAccounting::bytes(MemoryAccounting::Packets);
+    }
 }
 
 void PacketBuffer::onPut(const Packet &p)
 {
+    m_bytes.fetchAndAddRelaxed(p.data.size());
+    update_accounting();
+    m_time1 = qint64(p.pts*1000.0);
+    m_time0 = qint64(queue[0].pts*1000.0);
     if (m_mode == BufferTime) {
         m_value1 = qint64(p.pts*1000.0); // FIXME: what if no pts
         m_value0 = qint64(queue[0].pts*1000.0); // must compute here because it is reset to 0 if take from empty
@@ -131,6 +289,11 @@ void PacketBuffer::onPut(const Packet &p)
     } else {
         m_value1++;
     }
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    m_put += m_mode == BufferBytes ? p.data.size() : 1;
+    m_input.update(m_mode == BufferTime ? m_value1 : m_put, now, !m_throttled);
+    m_throttled = false;
+    update_adaptive_value();
     if (!m_buffering)
         return;
     if (checkEnough()) {
@@ -145,20 +308,33 @@ void PacketBuffer::onPut(const Packet &p)
     if (!m_history.empty())
         bi.bytes += m_history.back().bytes;
     bi.v = m_value1;
-    bi.t = QDateTime::currentMSecsSinceEpoch();
+    bi.t = now;
     m_history.push_back(bi);
 }
 
 void PacketBuffer::onTake(const Packet &p)
 {
+    // demuxer may wait in put() if the queue was full. the next put is limited by consumption speed
+    m_throttled = m_throttled || checkFull();
+    m_bytes.fetchAndAddRelaxed(-p.data.size());
     if (checkEmpty()) {
         m_buffering = true;
     }
     if (queue.isEmpty()) {
+        // clear()
+        m_bytes.fetchAndStoreRelaxed(0);
+        update_accounting(true);
+        m_time0 = m_time1 = 0;
         m_value0 = 0;
         m_value1 = 0;
         return;
     }
+    update_accounting();
+    m_time0 = qint64(queue[0].pts*1000.0);
+    if (p.isValid()) {
+        m_taken += m_mode == BufferBytes ? p.data.size() : 1;
+        m_output.update(m_mode == BufferTime ? qint64(p.pts*1000.0) : m_taken, QDateTime::currentMSecsSinceEpoch(), true);
+    }
     if (m_mode == BufferTime) {
         m_value0 = qint64(queue[0].pts*1000.0);
         //if (isBuffering())
@@ -171,6 +347,19 @@ void PacketBuffer::onTake(const Packet &p)
     }
 }
 
+void PacketBuffer::update_adaptive_value()
+{
+    m_adaptive_value = m_buffer;
+    if (!m_adaptive || m_buffer == std::numeric_limits<qint64>::max()) // max: never enough. see AVDemuxThread
+        return;
+    const qreal in = m_input.speed;
+    const qreal out = m_output.speed;
+    if (in <= 0 || out <= 0) // not measured yet
+        return;
+    const qreal r = qBound<qreal>(1.0/kAdaptiveScale, out/in, kAdaptiveScale);
+    m_adaptive_value = qMax<qint64>(1LL, qint64(qreal(m_buffer)*r));
+}
+
 qreal PacketBuffer::calc_speed(bool use_bytes) const
 {
     if (m_history.empty())
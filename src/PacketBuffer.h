@@ -22,6 +22,7 @@
 #ifndef QTAV_PACKETBUFFER_H
 #define QTAV_PACKETBUFFER_H
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QQueue>
 #include <QtAV/Packet.h>
 #include "utils/BlockingQueue.h"
@@ -77,6 +78,46 @@ public:
      */
     qreal bufferSpeed() const;
     qreal bufferSpeedInBytes() const;
+    /*!
+     * \brief setBufferBytesMax
+     * Hard limit of bytes in the queue whatever bufferMode() is. The queue is full (and enough) if reached.
+     * \param bytes <=0: no limit
+     */
+    void setBufferBytesMax(qint64 bytes);
+    qint64 bufferBytesMax() const;
+    /*!
+     * \brief setGlobalBufferBytesMax
+     * Hard limit of bytes in all queues in current process, i.e. the budget of MemoryAccounting::Packets.
+     * If the budget of packets or total memory is exceeded, a queue is full if it holds at least an equal share.
+     * Queue bytes are counted and the budget is checked each time a queue grows or shrinks by 64KB, not for every packet.
+     * \param bytes <=0: no limit
+     */
+    static void setGlobalBufferBytesMax(qint64 bytes);
+    static qint64 globalBufferBytesMax();
+    static qint64 globalBufferedBytes();
+    /// tag used to count packet bytes of an object, e.g. the player, in MemoryAccounting
+    void setOwner(const void* owner);
+    const void* owner() const;
+    /*!
+     * \brief setAdaptive
+     * Scale bufferValue() by the ratio of consumption speed to input speed. Fast input (local file, fast network)
+     * needs a smaller buffer, slow input needs a larger one.
+     * The real value is in [bufferValue()/kAdaptiveScale, bufferValue()*kAdaptiveScale]
+     */
+    void setAdaptive(bool value);
+    bool isAdaptive() const;
+    /// the real buffer value used to check enough and full. It's bufferValue() if not adaptive
+    qint64 adaptiveBufferValue() const;
+    /// thread safe
+    qint64 bufferedBytes() const;
+    /// buffered msecs whatever bufferMode() is
+    qint64 bufferedTime() const;
+    /*!
+     * \brief inputSpeed outputSpeed
+     * Measured put/take speed. Depending on BufferMode, the result is delta_pts(ms)/s, packets/s or bytes/s
+     */
+    qreal inputSpeed() const;
+    qreal outputSpeed() const;
 protected:
     bool checkEnough() const Q_DECL_OVERRIDE;
     bool checkFull() const Q_DECL_OVERRIDE;
@@ -91,6 +132,9 @@ protected:
 
 private:
     qreal calc_speed(bool use_bytes) const;
+    void update_adaptive_value();
+    /// add the bytes changed since the last call to MemoryAccounting if more than a step, and check the budget
+    void update_accounting(bool force = false);
 
     BufferMode m_mode;
     bool m_buffering;
@@ -104,6 +148,28 @@ private:
         qint64 t;
     } BufferInfo;
     ring<BufferInfo> m_history;
+    // bytes in queue and msecs of the queue head and tail whatever the mode is
+    QAtomicInt m_bytes; // modified with the queue locked, read by other threads
+    qint64 m_bytes_max;
+    const void* m_owner;
+    qint64 m_accounted; // bytes added to MemoryAccounting
+    bool m_over_share; // memory budget is exceeded and the queue holds at least an equal share
+    qint64 m_time0, m_time1;
+    bool m_adaptive;
+    qint64 m_adaptive_value;
+    class Speed {
+    public:
+        Speed();
+        void reset();
+        // v: total value put/taken in current mode, or pts for BufferTime. t: ms
+        void update(qint64 v, qint64 t, bool count);
+        qint64 v, t;
+        qint64 dv, dt; // accumulated
+        qreal speed;
+    };
+    Speed m_input, m_output;
+    qint64 m_put, m_taken; // bytes or packets
+    bool m_throttled; // put may be blocked by a full queue, it's not the real input speed
 };
 
 } //namespace QtAV
@@ -97,6 +97,19 @@ public:
      * Current readFrame() readed stream index.
      */
     int stream() const;
+    /*!
+     * \brief prefetch
+     * Read at most \a count packets of the selected streams ahead, e.g. prime a media before it is played.
+     * readFrame() returns the prefetched packets first. They are discarded by seek() and unload().
+     * \return number of prefetched packets
+     */
+    int prefetch(int count);
+    /*!
+     * \brief swap
+     * Exchange the loaded media, streams and options with \a other. Both demuxers must not be reading.
+     * Signal connections are not changed.
+     */
+    void swap(AVDemuxer& other);
 
     bool isSeekable() const; // TODO: change in unload?
     void setSeekUnit(SeekUnit unit);
@@ -178,6 +191,19 @@ public:
      *                   0: no interrupt
      */
     void setInterruptStatus(int interrupt);
+    /*!
+     * \brief setProbeCacheEnabled
+     * Stream info found by avformat_find_stream_info() is cached process wide if enabled. The key is (path, size, modified time)
+     * for local files, a hash of the first 64KB and size for seekable MediaIO, and the url for other protocols.
+     * When a cached media is loaded again, probing reads at most 64KB and 0.2s of data, and the parameters not found are restored
+     * from the cache. If the stream layout does not match the cached one, a full probing is performed.
+     * probesize and analyzeduration set by setOptions() are kept if they are smaller. Default is false.
+     */
+    void setProbeCacheEnabled(bool value);
+    bool isProbeCacheEnabled() const;
+    /// true if stream info of current media is restored from the probe cache
+    bool isProbeCached() const;
+    static void clearProbeCache();
     /*!
      * \brief setOptions
      * libav's AVDictionary. we can ignore the flags used in av_dict_xxx because we can use hash api.
@@ -76,9 +76,11 @@ class Q_AV_EXPORT AVPlayer : public QObject
     Q_PROPERTY(qint64 interruptTimeout READ interruptTimeout WRITE setInterruptTimeout NOTIFY interruptTimeoutChanged)
     Q_PROPERTY(bool interruptOnTimeout READ isInterruptOnTimeout WRITE setInterruptOnTimeout NOTIFY interruptOnTimeoutChanged)
     Q_PROPERTY(int notifyInterval READ notifyInterval WRITE setNotifyInterval NOTIFY notifyIntervalChanged)
+    Q_PROPERTY(qint64 liveLatency READ liveLatency WRITE setLiveLatency NOTIFY liveLatencyChanged)
     Q_PROPERTY(int brightness READ brightness WRITE setBrightness NOTIFY brightnessChanged)
     Q_PROPERTY(int contrast READ contrast WRITE setContrast NOTIFY contrastChanged)
     Q_PROPERTY(int saturation READ saturation WRITE setSaturation NOTIFY saturationChanged)
+    Q_PROPERTY(int hue READ hue WRITE setHue NOTIFY hueChanged)
     Q_PROPERTY(State state READ state WRITE setState NOTIFY stateChanged)
     Q_PROPERTY(QtAV::MediaStatus mediaStatus READ mediaStatus NOTIFY mediaStatusChanged)
     Q_PROPERTY(QtAV::MediaEndAction mediaEndAction READ mediaEndAction WRITE setMediaEndAction NOTIFY mediaEndActionChanged)
@@ -117,6 +119,17 @@ public:
      */
     void setFile(const QString& path);
     QString file() const;
+    /*!
+     * \brief setNextFile
+     * Set the media to play after current media (gapless playback). It's opened, its decoders are opened and the first
+     * packets are read in a loader thread while current media is playing. When current media ends and repeat() is finished,
+     * the preloaded media becomes current source (sourceChanged() is emitted, stopped() is not) and playback goes on without
+     * reopening the AudioOutput if audio format is not changed. Renderers are kept.
+     * If preloading failed or not finished when current media ends, playback stops as usual.
+     * An empty path cancels the preloading. nextFile() is cleared when it becomes current source.
+     */
+    void setNextFile(const QString& path);
+    QString nextFile() const;
     /*!
      * \brief setIODevice
      * Play media stream from QIODevice. AVPlayer does not take the ownership. You have to manage device lifetime.
@@ -326,6 +339,13 @@ public:
      */
     void setInterruptOnTimeout(bool value);
     bool isInterruptOnTimeout() const;
+    /*!
+     * \brief setProbeCacheEnabled
+     * Cache stream info of loaded media and shorten probing when the same media is loaded again.
+     * See AVDemuxer::setProbeCacheEnabled(). Time saved is in Statistics::load_only. Default is false.
+     */
+    void setProbeCacheEnabled(bool value);
+    bool isProbeCacheEnabled() const;
     /*!
      * \brief setFrameRate
      * Force the (video) frame rate to a given value.
@@ -374,7 +394,7 @@ public:
      */
     int brightness() const;
     int contrast() const;
-    int hue() const; //not implemented
+    int hue() const;
     int saturation() const;
     unsigned int chapters() const;
     /*!
@@ -524,6 +544,46 @@ public Q_SLOTS:
      */
     void setBufferValue(qint64 value);
     int bufferValue() const;
+    /*!
+     * \brief setLiveLatency
+     * Live mode for network streams, e.g. rtsp, udp and rtmp. Playback is kept at about the given latency behind the
+     * latest received packet. The packet buffer is time based and its value is the target latency in live mode.
+     * If the latency grows, e.g. after network jitter, playback becomes a little faster until the target latency is reached.
+     * If the latency is too large, non-reference video frames are dropped too.
+     * Latency stats are in statistics().live_only
+     * \param ms target latency. <=0: disable live mode (default)
+     */
+    void setLiveLatency(qint64 ms);
+    qint64 liveLatency() const;
+    /*!
+     * \brief setBufferBytesMax
+     * Hard limit of buffered bytes for each stream, whatever bufferMode() is. Useful for high bitrate streams,
+     * where a few seconds can be hundreds of MB.
+     * Buffered bytes and time are in statistics().audio/video
+     * \param bytes <=0: no limit (default)
+     */
+    void setBufferBytesMax(qint64 bytes);
+    qint64 bufferBytesMax() const;
+    /*!
+     * \brief setGlobalBufferBytesMax
+     * Hard limit of buffered bytes of all players in current process.
+     * \param bytes <=0: no limit (default)
+     */
+    static void setGlobalBufferBytesMax(qint64 bytes);
+    static qint64 globalBufferBytesMax();
+    /*!
+     * \brief memoryUsage
+     * Bytes of buffered packets, frames allocated or converted by its decoding threads and the audio output queue owned by this player.
+     * Process wide usage and budgets are in MemoryAccounting
+     */
+    qint64 memoryUsage() const;
+    /*!
+     * \brief setAdaptiveBuffer
+     * If true, the real buffer value is computed from bufferValue() and the measured input speed against consumption speed.
+     * Less data is buffered if input is fast, e.g. local files. Default is false
+     */
+    void setAdaptiveBuffer(bool value);
+    bool isAdaptiveBuffer() const;
 
     /*!
      * \brief setNotifyInterval
@@ -537,7 +597,7 @@ public Q_SLOTS:
     // for all renderers. val: [-100, 100]. other value changes nothing
     void setBrightness(int val);
     void setContrast(int val);
-    void setHue(int val);  //not implemented
+    void setHue(int val);
     void setSaturation(int val);
 
 Q_SIGNALS:
@@ -581,6 +641,7 @@ Q_SIGNALS:
     void interruptTimeoutChanged();
     void interruptOnTimeoutChanged();
     void notifyIntervalChanged();
+    void liveLatencyChanged();
     void brightnessChanged(int val);
     void contrastChanged(int val);
     void hueChanged(int val);
@@ -610,6 +671,7 @@ private Q_SLOTS:
     void loadInternal(); // simply load
     void playInternal(); // simply play
     void stopFromDemuxerThread();
+    void playNextInternal(); // play the preloaded next media
     void aboutToQuitApp();
     // start/stop notify timer in this thread. use QMetaObject::invokeMethod
     void startNotifyTimer();
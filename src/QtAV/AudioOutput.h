@@ -204,6 +204,13 @@ public:
     DeviceFeatures supportedDeviceFeatures() const;
     qreal timestamp() const;
     // timestamp of current playing data
+    /*!
+     * \brief rebaseTimestamps
+     * Internal use. Shift timestamps of the queued data so that it ends at \a end, e.g. the start time of the next media
+     * when switching without reopening (gapless). Thread safe. The shift is done when the next data is queued, so call it
+     * after the data to shift is queued and before the data of the next media.
+     */
+    void rebaseTimestamps(qreal end);
 Q_SIGNALS:
     void volumeChanged(qreal);
     void muteChanged(bool);
@@ -222,6 +229,7 @@ private Q_SLOTS:
     void reportMute(bool value);
 private:
     void onCallback();
+    int pullData(char* data, int maxBytes);
     friend class AudioOutputBackend;
     Q_DISABLE_COPY(AudioOutput)
 };
@@ -97,6 +97,12 @@ public:
     bool prepareContext(VideoFilterContext*& ctx, Statistics* statistics = 0, VideoFrame* frame = 0); //internal use
 protected:
     VideoFilter(VideoFilterPrivate& d, QObject *parent = 0);
+    /*!
+     * \brief canProcessFrame
+     * Return true if process() draws on \a frame data directly. Then prepareContext() will not convert the frame
+     * to a QImage compatible format for the painter context. Default is false
+     */
+    virtual bool canProcessFrame(const VideoFrame& frame) const;
     virtual void process(Statistics* statistics, VideoFrame* frame = 0) = 0;
 };
 
@@ -62,6 +62,7 @@ public:
     int bytesPerLine(int plane = 0) const;
     // the whole frame data. may be empty unless clone() or allocate is called
     // real data starts with dataAlignment() aligned address
+    // data from FrameAllocator is not copied, it's valid while the frame is alive
     QByteArray frameData() const;
     int dataAlignment() const;
     uchar* frameDataPtr(int* size = NULL) const {
@@ -98,9 +99,23 @@ public:
     QVariantMap availableMetaData() const;
     QVariant metaData(const QString& key) const;
     void setMetaData(const QString &key, const QVariant &value);
+    /*!
+     * \brief isDataWritable
+     * true if the data is allocated by this frame, e.g. by clone() or VideoFrame::allocate(), and neither the frame nor the data
+     * is shared, so the data can be modified in place. Decoded frames reference the decoder's buffers and are not writable
+     */
+    bool isDataWritable() const;
+    /*!
+     * \brief setMemoryOwner
+     * Count the data allocated by this frame as memory of \a owner, e.g. an AVPlayer. See MemoryAccounting::ownerBytes().
+     * Set it before VideoFrame::allocate() to tag the new data. Decoded frames referencing the decoder's buffers are not counted
+     */
+    void setMemoryOwner(const void* owner);
     void setTimestamp(qreal ts);
     qreal timestamp() const;
     inline void swap(Frame &other) { qSwap(d_ptr, other.d_ptr); }
+    /// true if \a other is a copy of this frame, i.e. they share the same data and properties. data pointers can be reused by other frames
+    bool isSharedWith(const Frame& other) const { return d_ptr == other.d_ptr;}
 
 protected:
     Frame(FramePrivate *d);
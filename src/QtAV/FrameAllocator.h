@@ -0,0 +1,96 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#ifndef QTAV_FRAMEALLOCATOR_H
+#define QTAV_FRAMEALLOCATOR_H
+
+#include <QtAV/QtAV_Global.h>
+#include <QtCore/QScopedPointer>
+
+namespace QtAV {
+/*!
+ * \brief The FrameAllocator class
+ * Allocates the data of frames created by QtAV, e.g. VideoFrame::clone(), VideoFrame::allocate(), converted frames and frames copied
+ * from hardware decoders. Memory is not initialized.
+ */
+class Q_AV_EXPORT FrameAllocator
+{
+public:
+    enum { DefaultAlignment = 64 };
+    virtual ~FrameAllocator() {}
+    /*!
+     * \brief allocate
+     * \return uninitialized memory of at least \a size bytes aligned to \a alignment (power of 2). null if failed
+     */
+    virtual void* allocate(int size, int alignment = DefaultAlignment) = 0;
+    /// \a size and \a alignment are the values passed to allocate()
+    virtual void deallocate(void* ptr, int size, int alignment = DefaultAlignment) = 0;
+    /// the allocator used by new frames. Default is FramePool::instance()
+    static FrameAllocator* current();
+    /*!
+     * \brief setCurrent
+     * Memory is always released by the allocator it's allocated from, so \a allocator must be alive until all frames allocated
+     * by it are destroyed. null: use FramePool::instance()
+     */
+    static void setCurrent(FrameAllocator* allocator);
+};
+
+/*!
+ * \brief The FramePool class
+ * The default FrameAllocator. Released buffers are kept in free lists of size classes (8 classes for each power of 2, so at most
+ * 12.5% is wasted) and reused by later allocations of the same size class, e.g. frames of the same video.
+ * All functions are thread safe.
+ */
+class Q_AV_EXPORT FramePool : public FrameAllocator
+{
+public:
+    static FramePool* instance();
+    FramePool();
+    ~FramePool();
+    void* allocate(int size, int alignment = DefaultAlignment) Q_DECL_OVERRIDE;
+    void deallocate(void* ptr, int size, int alignment = DefaultAlignment) Q_DECL_OVERRIDE;
+    /*!
+     * \brief setMaxPooledBytes
+     * Max bytes of free buffers kept in the pool. Default is 64MB. 0: no pooling
+     */
+    void setMaxPooledBytes(qint64 bytes);
+    qint64 maxPooledBytes() const;
+    /*!
+     * \brief setHugePagesEnabled
+     * Buffers of at least 2MB are aligned to 2MB and advised to use transparent huge pages. Linux only. Default is false
+     */
+    void setHugePagesEnabled(bool value);
+    bool isHugePagesEnabled() const;
+    /// release all free buffers
+    void clear();
+    /// bytes of free buffers in the pool
+    qint64 pooledBytes() const;
+    qint64 allocations() const;
+    /// allocations served by a free buffer in the pool
+    qint64 hits() const;
+    qreal hitRate() const;
+    void resetStatistics();
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+} //namespace QtAV
+#endif // QTAV_FRAMEALLOCATOR_H
@@ -0,0 +1,72 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#ifndef QTAV_MEMORYACCOUNTING_H
+#define QTAV_MEMORYACCOUNTING_H
+
+#include <QtAV/QtAV_Global.h>
+
+namespace QtAV {
+/*!
+ * \brief The MemoryAccounting class
+ * Process wide counters of memory allocated by QtAV. Only memory owned by QtAV objects is counted, e.g. packet data
+ * in demuxer queues, frame data allocated by clone() and converters, converter output buffers and audio output queues.
+ * Frames referencing decoder buffers are not counted. Data shared by a frame and a converter is counted in both categories.
+ * A budget can be set for each category and for Total. If exceeded, the producers apply back-pressure: demuxer queues
+ * stop growing and video threads drop non-key frames until memory is released.
+ * All functions are thread safe.
+ */
+class Q_AV_EXPORT MemoryAccounting
+{
+public:
+    enum Category {
+        Packets,
+        VideoFrames,
+        AudioFrames,
+        ConverterBuffers,
+        AudioOutputBuffers,
+        Total,
+        CategoryCount = Total
+    };
+    /*!
+     * \brief add
+     * Add \a bytes (can be negative) to \a category. \a owner is an optional tag to query the usage of an object,
+     * for example an AVPlayer or AudioOutput. Category Total can not be used.
+     */
+    static void add(Category category, qint64 bytes, const void* owner = 0);
+    static qint64 bytes(Category category);
+    /// max bytes since startup or resetPeak()
+    static qint64 peakBytes(Category category);
+    static void resetPeak();
+    /// bytes added with \a owner. Sum of all categories if \a category is Total
+    static qint64 ownerBytes(const void* owner, Category category = Total);
+    /*!
+     * \brief setBudget
+     * \param bytes <=0: no limit
+     */
+    static void setBudget(Category category, qint64 bytes);
+    static qint64 budget(Category category);
+    /// true if bytes of \a category or Total exceeds the budget
+    static bool isOverBudget(Category category);
+    static const char* name(Category category);
+};
+} //namespace QtAV
+#endif // QTAV_MEMORYACCOUNTING_H
@@ -71,6 +71,13 @@ public:
      */
     void setOpenGLContext(QOpenGLContext *ctx);
     QOpenGLContext* openGLContext();
+    /*!
+     * \brief prepareFrame
+     * Copy host memory planes of \a frame to a persistently mapped pixel buffer in the calling thread, e.g. video thread in VideoRenderer::receiveFrame(),
+     * so that setCurrentFrame() with the same frame only issues texture uploads from the buffer. Thread safe.
+     * It's optional, and does nothing if no free buffer or not supported by the context.
+     */
+    void prepareFrame(const VideoFrame& frame);
     void setCurrentFrame(const VideoFrame& frame);
     void fill(const QColor& color);
     /*!
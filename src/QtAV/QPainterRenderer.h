@@ -34,13 +34,31 @@ class Q_AV_EXPORT QPainterRenderer : public VideoRenderer
 public:
     QPainterRenderer();
     bool isSupported(VideoFormat::PixelFormat pixfmt) const Q_DECL_OVERRIDE;
+    /*!
+     * \brief setPrescale
+     * If true, frames are scaled to videoRect() size in preparePixmap(), i.e. in video thread for most renderers, and
+     * the paint thread only copies the pixmap without scaling. The current frame is scaled again when the renderer is resized.
+     * Not used if orientation is not 0 or region of interest is not the whole frame. Default is false.
+     * Planar 8 bit yuv frames are supported in this mode, and they are converted to rgb, scaled and adjusted by the equalizer
+     * (brightness etc.) in a single pass.
+     */
+    void setPrescale(bool value);
+    bool isPrescale() const;
 protected:
     bool preparePixmap(const VideoFrame& frame);
     void drawBackground() Q_DECL_OVERRIDE;
     //draw the current frame using the current paint engine. called by paintEvent()
     void drawFrame() Q_DECL_OVERRIDE;
+    void onResizeRenderer(int width, int height) Q_DECL_OVERRIDE;
 
     QPainterRenderer(QPainterRendererPrivate& d);
+private:
+    bool onSetBrightness(qreal b) Q_DECL_OVERRIDE;
+    bool onSetContrast(qreal c) Q_DECL_OVERRIDE;
+    bool onSetHue(qreal h) Q_DECL_OVERRIDE;
+    bool onSetSaturation(qreal s) Q_DECL_OVERRIDE;
+    // prepare the current frame again with new equalizer values
+    void updateEQ(qreal b, qreal c, qreal h, qreal s);
 };
 
 } //namespace QtAV
@@ -61,6 +61,7 @@
 #include <QtAV/VideoFormat.h>
 #include <QtAV/VideoFrame.h>
 #include <QtAV/VideoFrameExtractor.h>
+#include <QtAV/ThumbnailService.h>
 #include <QtAV/VideoRenderer.h>
 #include <QtAV/VideoOutput.h>
 //The following renderer headers can be removed
@@ -72,5 +73,7 @@
 #include <QtAV/SubtitleFilter.h>
 
 #include <QtAV/MediaIO.h>
+#include <QtAV/MemoryAccounting.h>
+#include <QtAV/FrameAllocator.h>
 
 #endif // QTAV_H
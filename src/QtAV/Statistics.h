@@ -26,6 +26,7 @@
 #include <QtCore/QHash>
 #include <QtCore/QTime>
 #include <QtCore/QSharedData>
+#include <QtCore/QVector>
 
 /*!
  * values from functions are dynamically calculated
@@ -56,6 +57,8 @@ public:
         int bit_rate;
         qint64 frames;
         qreal frame_rate; // average fps stored in media stream information
+        qint64 buffered_bytes; // packets in queue
+        qint64 buffered_time; // ms
         //union member with ctor, dtor, copy ctor only works in c++11
         /*union {
             audio_only audio;
@@ -113,6 +116,101 @@ public:
         class Private;
         QExplicitlySharedDataPointer<Private> d;
     } video_only;
+    // live stream latency control. see AVPlayer::setLiveLatency()
+    class Q_AV_EXPORT LiveOnly {
+    public:
+        LiveOnly();
+        qint64 target_latency; ///< ms. 0: live mode is disabled
+        /**
+         * Stream time (ms) received but not played yet, i.e. the last demuxed timestamp - current playback position
+         */
+        qint64 latency;
+        qint64 max_latency;
+        qreal catch_up_speed; ///< speed ratio applied to catch up. 1.0: not catching up
+        bool frame_drop; ///< true if non-reference video frames are dropped to catch up
+        int catch_up_count; ///< how many times catching up started
+    } live_only;
+    // media open and startup timing measured by AVPlayer. see AVDemuxer::setProbeCacheEnabled()
+    class Q_AV_EXPORT LoadOnly {
+    public:
+        LoadOnly();
+        qint64 start; ///< Pipeline::now() when loading started
+        qint64 open_time; ///< ms. opening the media and finding stream info
+        bool probe_cached; ///< stream info probing is shortened by the probe cache
+        /**
+         * Time to first frame in ms, from loading started to the first video frame (or audio frame if no video) is rendered.
+         * -1: not rendered yet
+         */
+        qint64 first_frame_time;
+    } load_only;
+    /*!
+     * \brief The Histogram class
+     * A snapshot of latency distribution of a pipeline stage. Values are in microseconds.
+     * Buckets are log-linear: 8 sub-buckets for each power of 2, so the relative error is less than 12.5%.
+     */
+    class Q_AV_EXPORT Histogram {
+    public:
+        Histogram();
+        qint64 count;
+        qint64 min, max;
+        QVector<qint64> buckets; ///< number of values in each bucket
+        /// \param p [0, 100]
+        qint64 percentile(qreal p) const;
+        /// estimated from bucket values
+        qreal mean() const;
+        static int bucketCount();
+        static int bucketIndex(qint64 value);
+        /// the lower bound of bucket \a index
+        static qint64 bucketValue(int index);
+    };
+    /*!
+     * \brief The Pipeline class
+     * Per stage timing recorded by demux, decode and output threads. Recording is lock free, so it is always enabled.
+     * Trace events for chromeTrace() are recorded only if setTraceEnabled(true).
+     */
+    class Q_AV_EXPORT Pipeline {
+    public:
+        enum Stage {
+            DemuxRead,
+            AudioQueueWait, ///< time waiting for packets, i.e. queue is starving
+            AudioDecode,
+            AudioFilter, ///< filters and resampling
+            AudioOutput, ///< writing to audio output, including waiting for a free buffer
+            VideoQueueWait,
+            VideoDecode,
+            VideoFilter,
+            VideoConvert, ///< conversion in deliverVideoFrame()
+            VideoPresent, ///< delivering to renderers
+            StageCount
+        };
+        Pipeline();
+        Pipeline(const Pipeline&);
+        Pipeline& operator =(const Pipeline&);
+        ~Pipeline();
+        static const char* stageName(Stage stage);
+        /// monotonic time in microseconds. use it as start time of record()
+        static qint64 now();
+        /// record the duration of \a stage from \a start to now()
+        void record(Stage stage, qint64 start);
+        void videoFrameDropped();
+        void videoFrameLate();
+        qint64 droppedVideoFrames() const;
+        /// frames presented later than sync threshold
+        qint64 lateVideoFrames() const;
+        Histogram histogram(Stage stage) const;
+        /// clear all values. recording threads can be running
+        void reset();
+        void setTraceEnabled(bool value);
+        bool isTraceEnabled() const;
+        /*!
+         * \brief chromeTrace
+         * Recent trace events in Chrome trace event format (JSON). Open it in chrome://tracing
+         */
+        QByteArray chromeTrace() const;
+    private:
+        class Private;
+        QExplicitlySharedDataPointer<Private> d;
+    } pipeline;
 };
 
 } //namespace QtAV
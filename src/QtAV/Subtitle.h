@@ -210,6 +210,15 @@ Q_SIGNALS:
     void fontFileChanged();
     void fontsDirChanged();
     void fontFileForcedChanged();
+    /*!
+     * \brief fontCacheReady
+     * The process wide font cache used by the renderer (e.g. fontconfig for libass) is ready. Before that, canRender()
+     * is false and only text is available if the font cache is required.
+     * \param elapsed warm-up time in ms
+     */
+    void fontCacheReady(qint64 elapsed);
+private Q_SLOTS:
+    void onFontCacheReady(qint64 elapsed);
 private:
     void checkCapability();
     class Private;
@@ -113,6 +113,8 @@ Q_SIGNALS:
     void fontFileForcedChanged();
 
 protected:
+    // burn in yuv frames directly
+    bool canProcessFrame(const VideoFrame& frame) const Q_DECL_OVERRIDE;
     void process(Statistics* statistics, VideoFrame* frame) Q_DECL_OVERRIDE;
 };
 
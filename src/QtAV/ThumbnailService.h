@@ -0,0 +1,87 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#ifndef QTAV_THUMBNAILSERVICE_H
+#define QTAV_THUMBNAILSERVICE_H
+
+#include <QtCore/QObject>
+#include <QtAV/VideoFrame.h>
+
+namespace QtAV {
+class ThumbnailServicePrivate;
+/*!
+ * \brief The ThumbnailService class
+ * Process wide video thumbnails shared by all previews, e.g. VideoPreviewWidget and QuickVideoPreview.
+ * Requests are served by a bounded pool of worker threads. Each worker keeps its demuxer and decoder open for the last file,
+ * and a worker prefers requests of its current file, so many previews of the same file do not open it again.
+ * Queued requests with a larger priority are served first. A new request of a client cancels the client's queued request,
+ * so only the latest position of a hovered preview is decoded. Results are kept in a frame cache shared by all clients.
+ * Frames are Format_RGB32 scaled to fit the requested size with the aspect ratio kept.
+ * Functions are thread safe. Signals are emitted in the thread of instance(), i.e. the thread calling it first.
+ */
+class Q_AV_EXPORT ThumbnailService : public QObject
+{
+    Q_OBJECT
+    DPTR_DECLARE_PRIVATE(ThumbnailService)
+public:
+    /// created when called the first time and never deleted. workers stop when the application quits
+    static ThumbnailService* instance();
+    /*!
+     * \brief setMaxWorkers
+     * Max decoding threads. Workers are started when requests are queued and no worker is idle. Default is half of the cpu
+     * cores, at least 1 and at most 4.
+     */
+    void setMaxWorkers(int value);
+    int maxWorkers() const;
+    /*!
+     * \brief setCacheSize
+     * Max bytes of cached frames. 0: no cache. Default is 32MB
+     */
+    void setCacheSize(qint64 bytes);
+    qint64 cacheSize() const;
+    void clearCache();
+    /*!
+     * \brief request
+     * Request a frame of \a file near \a position (ms) scaled to fit \a size. The result is delivered by frameReady() or error()
+     * with the returned id, even if it is in the cache already.
+     * \param client the requester, e.g. a preview widget. Its queued request is cancelled. can be null
+     * \param priority larger is served first, e.g. 1 for visible previews and 0 for hidden ones
+     * \param size the frame is decoded in a lower resolution if size is small. see VideoFrameExtractor::setTargetSize()
+     */
+    int request(const void* client, const QString& file, qint64 position, const QSize& size, int priority = 0);
+    /// cancel queued requests of \a client. Results of requests being decoded are dropped
+    void cancel(const void* client);
+    /// change the priority of queued requests of \a client, e.g. when it becomes visible
+    void setPriority(const void* client, int priority);
+Q_SIGNALS:
+    void frameReady(int id, const QtAV::VideoFrame& frame);
+    void error(int id, const QString& message);
+private Q_SLOTS:
+    void deliver();
+    void handleAppQuit();
+private:
+    ThumbnailService();
+    ~ThumbnailService();
+protected:
+    DPTR_DECLARE(ThumbnailService)
+};
+} //namespace QtAV
+#endif // QTAV_THUMBNAILSERVICE_H
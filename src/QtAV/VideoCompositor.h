@@ -0,0 +1,108 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#ifndef QTAV_VIDEOCOMPOSITOR_H
+#define QTAV_VIDEOCOMPOSITOR_H
+#ifndef QT_NO_OPENGL
+#include <QtCore/QObject>
+#include <QtGui/QColor>
+#include <QtGui/QOpenGLWindow>
+#include <QtAV/VideoRenderer.h>
+
+namespace QtAV {
+/*!
+ * \brief The VideoCompositor class
+ * Draw videos of many players in one render pass into the current OpenGL context, e.g. a video wall.
+ * Each player outputs to a tile created by addTile(). Tiles are laid out in a grid, or in the rects set by setTileRect().
+ * A received frame only requests one update (updateRequested()) no matter how many tiles received frames, so all tiles are presented with a single swap.
+ * All tiles share the shader programs and texture pool of the context(see ShaderManager), and are drawn ordered by pixel format to reduce program switches.
+ * Tiles are VideoRenderers, so aspect ratio mode, orientation, ROI and equalizer can be set for each one.
+ */
+class Q_AV_EXPORT VideoCompositor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit VideoCompositor(QObject *parent = 0);
+    ~VideoCompositor();
+    /*!
+     * \brief addTile
+     * Create a tile and use it as a player's renderer, e.g. player->setRenderer(compositor->addTile()). Owned by compositor.
+     */
+    VideoRenderer* addTile();
+    /// Remove and delete \a tile. Remove it from the player first.
+    void removeTile(VideoRenderer* tile);
+    int tileCount() const;
+    VideoRenderer* tile(int index) const;
+    /*!
+     * \brief setGridSize
+     * Columns and rows of the layout. Invalid size(default): ceil(sqrt(tileCount())) columns
+     */
+    void setGridSize(const QSize& value);
+    QSize gridSize() const;
+    /*!
+     * \brief setTileRect
+     * Normalized rect of \a tile in the viewport, e.g. (0.5, 0, 0.5, 0.5) is the top right quarter. Invalid rect(default) is the grid cell of the tile.
+     */
+    void setTileRect(VideoRenderer* tile, const QRectF& rect);
+    QRectF tileRect(VideoRenderer* tile) const;
+    /// gap between grid cells in pixels
+    void setSpacing(int value);
+    int spacing() const;
+    void setBackgroundColor(const QColor& c);
+    QColor backgroundColor() const;
+    /*!
+     * \brief render
+     * Draw all tiles into the current context's framebuffer. A context and a viewport size in pixels are required.
+     * All tiles must be rendered in the same context(share group).
+     */
+    void render(const QSize& viewport);
+    /// time of the last render() in ns, excluding gpu execution
+    qint64 renderTime() const;
+Q_SIGNALS:
+    /// Emitted once in the compositor's thread after tiles receive new frames, until render() is called.
+    void updateRequested();
+private Q_SLOTS:
+    void resetGL();
+private:
+    void requestUpdate();
+    friend class CompositorTile;
+    class Private;
+    Private *d;
+};
+
+/*!
+ * \brief The VideoCompositorWindow class
+ * A window presenting a VideoCompositor with one swap for all tiles
+ */
+class Q_AV_EXPORT VideoCompositorWindow : public QOpenGLWindow
+{
+    Q_OBJECT
+public:
+    explicit VideoCompositorWindow(QWindow *parent = 0);
+    VideoCompositor* compositor() const;
+protected:
+    void paintGL() Q_DECL_OVERRIDE;
+private:
+    VideoCompositor *m_compositor;
+};
+} //namespace QtAV
+#endif //QT_NO_OPENGL
+#endif // QTAV_VIDEOCOMPOSITOR_H
@@ -65,6 +65,14 @@ public:
      * Deep copy. Given the format, width and height, plane addresses and line sizes.
      */
     VideoFrame clone() const;
+    /*!
+     * \brief allocate
+     * Allocate uninitialized frame data from FrameAllocator::current() and set plane addresses. Each plane is 64 bytes aligned.
+     * bytesPerLine() of a plane is kept if already set, otherwise it's aligned to 64 bytes.
+     * \param surfaceHeight allocated height of luma plane if it's larger than height(), e.g. a hardware decoder surface
+     * \return false if format or size is invalid, or allocation failed
+     */
+    bool allocate(int surfaceHeight = 0);
     VideoFormat format() const;
     VideoFormat::PixelFormat pixelFormat() const;
     QImage::Format imageFormat() const;
@@ -136,17 +144,28 @@ public:
     ~VideoFrameConverter();
     /// value out of [-100, 100] will be ignored
     void setEq(int brightness, int contrast, int saturation);
+    /// tag of converted frames in MemoryAccounting, e.g. the player. See Frame::setMemoryOwner()
+    void setMemoryOwner(const void* owner);
     /*!
      * \brief convert
      * return a frame with a given format from a given source frame. The result frame data is always on host memory.
+     * \param dstSize scale to dstSize if valid. The scaler context is reused while input and output parameters do not change.
+     */
+    VideoFrame convert(const VideoFrame& frame, const VideoFormat& fmt, const QSize& dstSize = QSize()) const;
+    VideoFrame convert(const VideoFrame& frame, VideoFormat::PixelFormat fmt, const QSize& dstSize = QSize()) const;
+    VideoFrame convert(const VideoFrame& frame, QImage::Format fmt, const QSize& dstSize = QSize()) const;
+    VideoFrame convert(const VideoFrame& frame, int fffmt, const QSize& dstSize = QSize()) const;
+    /*!
+     * \brief convert
+     * Convert a host memory frame into planes \a dst with strides \a dstStride allocated by the caller, e.g. a shared memory
+     * image of a renderer. No intermediate frame is allocated, so the frame data is written to the destination only once.
      */
-    VideoFrame convert(const VideoFrame& frame, const VideoFormat& fmt) const;
-    VideoFrame convert(const VideoFrame& frame, VideoFormat::PixelFormat fmt) const;
-    VideoFrame convert(const VideoFrame& frame, QImage::Format fmt) const;
-    VideoFrame convert(const VideoFrame& frame, int fffmt) const;
+    bool convert(const VideoFrame& frame, const VideoFormat& fmt, quint8 *const dst[], const int dstStride[], const QSize& dstSize = QSize()) const;
 private:
+    bool prepare(const VideoFrame& frame, int fffmt, const QSize& dstSize) const;
     mutable ImageConverter *m_cvt;
     int m_eq[3];
+    const void* m_owner;
 };
 } //namespace QtAV
 
@@ -37,6 +37,7 @@ class Q_AV_EXPORT VideoFrameExtractor : public QObject
     Q_PROPERTY(bool async READ async WRITE setAsync NOTIFY asyncChanged)
     Q_PROPERTY(int precision READ precision WRITE setPrecision NOTIFY precisionChanged)
     Q_PROPERTY(qint64 position READ position WRITE setPosition NOTIFY positionChanged)
+    Q_PROPERTY(QSize targetSize READ targetSize WRITE setTargetSize NOTIFY targetSizeChanged)
 public:
     explicit VideoFrameExtractor(QObject *parent = 0);
     /*!
@@ -66,6 +67,16 @@ public:
     int precision() const;
     void setPosition(qint64 value);
     qint64 position() const;
+    /*!
+     * \brief setTargetSize
+     * Size of the frames to display, e.g. a preview widget size. If it is at most 1/2 or 1/4 of the video size, frames are
+     * decoded in a lower resolution (lowres) if the codec supports it, otherwise in a lower quality (loop filter and idct
+     * skipping). The extracted frames can be smaller than the video then. The new value is used by the next extraction, and
+     * the stream is not reopened.
+     * Default is an invalid size, i.e. full resolution and quality.
+     */
+    void setTargetSize(const QSize& value);
+    QSize targetSize() const;
 
 Q_SIGNALS:
     void frameExtracted(const QtAV::VideoFrame& frame); // parameter: VideoFrame, bool changed?
@@ -80,6 +91,7 @@ Q_SIGNALS:
      */
     void positionChanged();
     void precisionChanged();
+    void targetSizeChanged();
 
 public Q_SLOTS:
     /*!
@@ -128,6 +128,13 @@ public:
     int rendererHeight() const;
     //geometry size of current video frame. can not use frameSize because qwidget use it
     QSize videoFrameSize() const;
+    /*!
+     * \brief framesReceived
+     * Number of frames received by receive(). framesPainted() is the number of them actually painted. A frame is not
+     * painted if a newer one arrives before the ui is updated, and a repeated frame(same data and timestamp) is not painted again.
+     */
+    qint64 framesReceived() const;
+    qint64 framesPainted() const;
 
     /*!
      * \brief orientation
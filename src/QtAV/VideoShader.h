@@ -271,6 +271,7 @@ public:
 protected:
     VideoMaterial(VideoMaterialPrivate &d);
     DPTR_DECLARE(VideoMaterial)
+    friend class OpenGLVideo; // upload from OpenGLVideo's pixel buffer ring
 };
 } //namespace QtAV
 #endif // QTAV_VIDEOSHADER_H
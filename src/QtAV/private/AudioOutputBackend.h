@@ -71,11 +71,19 @@ public:
         OffsetIndex = 1 << 5, //current playing offset
         OffsetBytes = 1 << 6, //current playing offset by bytes
         WritableBytes = 1 << 7,
+        Pull = 1 << 8, // backend reads queued data by pull() in its own callback. write() is not called
     };
     virtual BufferControl bufferControl() const = 0;
     // called by callback with Callback control
     virtual void onCallback();
     virtual void acquireNextBuffer() {}
+    /*!
+     * \brief pull
+     * Used by Pull control backends in the device callback. Reads at most \a bytes queued bytes to \a data and fills the rest
+     * with silence. Never blocks, so it's safe to call in a realtime thread.
+     * \return bytes of queued data read
+     */
+    int pull(char* data, int bytes);
     //default return -1. means not the control
     virtual int getPlayedCount() {return -1;} //PlayedCount
     /*!
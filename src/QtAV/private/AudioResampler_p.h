@@ -41,10 +41,30 @@ public:
         out_format.setSampleFormat(AudioFormat::SampleFormat_Float);
     }
 
+    /*!
+     * \brief outBuffer
+     * Returns data_out resized to \a size bytes. data_out is shared with the frame returned last time, writing to it directly
+     * detaches (reallocates) for every frame. So 2 buffers are used in turn, and a new one is allocated only if both are
+     * still referenced.
+     */
+    uchar* outBuffer(int size) {
+        if (!data_out.isDetached()) {
+            qSwap(data_out, spare_out); // spare_out keeps the previous output until it's released by the frame
+            if (!data_out.isDetached())
+                data_out = QByteArray(); // no need to copy the old data
+        }
+        if (size > data_out.size())
+            data_out.resize(size);
+        return (uchar*)data_out.data();
+    }
+
     int in_samples_per_channel, out_samples_per_channel;
     qreal speed;
     AudioFormat in_format, out_format;
+    // formats set by user. in_format and out_format may be completed by prepare()
+    AudioFormat in_format_requested, out_format_requested;
     QByteArray data_out;
+    QByteArray spare_out;
 };
 
 } //namespace QtAV
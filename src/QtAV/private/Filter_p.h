@@ -47,8 +47,10 @@ class Q_AV_PRIVATE_EXPORT VideoFilterPrivate : public FilterPrivate
 public:
     VideoFilterPrivate() :
         context(0)
+      , frame_target(false)
     {}
     VideoFilterContext *context; //used only when is necessary
+    bool frame_target; // prepareContext() got a decoded frame, i.e. applied in VideoThread but not on a renderer
 };
 
 class Q_AV_PRIVATE_EXPORT AudioFilterPrivate : public FilterPrivate
@@ -23,6 +23,8 @@
 #define QTAV_FRAME_P_H
 
 #include <QtAV/QtAV_Global.h>
+#include <QtAV/MemoryAccounting.h>
+#include <QtAV/FrameAllocator.h>
 #include <QtCore/QVector>
 #include <QtCore/QVariant>
 #include <QtCore/QSharedData>
@@ -30,6 +32,27 @@
 namespace QtAV {
 
 class Frame;
+/// memory from FrameAllocator, released when the last frame referencing it is destroyed
+class FrameBuffer : public QSharedData
+{
+    Q_DISABLE_COPY(FrameBuffer)
+public:
+    FrameBuffer(int bytes, int align)
+        : allocator(FrameAllocator::current())
+        , size(bytes)
+        , alignment(align)
+        , data((uchar*)allocator->allocate(bytes, align))
+    {}
+    ~FrameBuffer() {
+        if (data)
+            allocator->deallocate(data, size, alignment);
+    }
+    FrameAllocator *allocator;
+    int size;
+    int alignment;
+    uchar *data;
+};
+
 class FramePrivate : public QSharedData
 {
     Q_DISABLE_COPY(FramePrivate)
@@ -37,15 +60,53 @@ public:
     FramePrivate()
         : timestamp(0)
         , data_align(1)
+        , accounted_bytes(0)
+        , accounted_category(MemoryAccounting::Total)
+        , accounted_owner(0)
     {}
-    virtual ~FramePrivate() {}
+    virtual ~FramePrivate() {
+        MemoryAccounting::add(accounted_category, -accounted_bytes, accounted_owner);
+    }
+    /// count data owned by the frame in MemoryAccounting. call it after data is changed
+    void accountData(MemoryAccounting::Category category) {
+        MemoryAccounting::add(accounted_category, -accounted_bytes, accounted_owner);
+        accounted_category = category;
+        accounted_bytes = data.size();
+        MemoryAccounting::add(accounted_category, accounted_bytes, accounted_owner);
+    }
+    void setAccountedOwner(const void* owner) {
+        if (accounted_owner == owner)
+            return;
+        MemoryAccounting::add(accounted_category, -accounted_bytes, accounted_owner);
+        accounted_owner = owner;
+        MemoryAccounting::add(accounted_category, accounted_bytes, accounted_owner);
+    }
+    /*!
+     * allocate uninitialized \a bytes from FrameAllocator::current(). data references the buffer without copy,
+     * so it's valid while the frame is alive. return null if failed
+     */
+    uchar* allocateData(int bytes, int align, MemoryAccounting::Category category) {
+        buffer = new FrameBuffer(bytes, align);
+        if (!buffer->data) {
+            buffer.reset();
+            return 0;
+        }
+        data = QByteArray::fromRawData((const char*)buffer->data, bytes);
+        data_align = align;
+        accountData(category);
+        return buffer->data;
+    }
 
     QVector<uchar*> planes; //slice
     QVector<int> line_sizes; //stride
     QVariantMap metadata;
     QByteArray data;
+    QExplicitlySharedDataPointer<FrameBuffer> buffer; // owns data if allocated by allocateData()
     qreal timestamp;
     int data_align;
+    qint64 accounted_bytes;
+    MemoryAccounting::Category accounted_category;
+    const void* accounted_owner;
 };
 
 } //namespace QtAV
@@ -0,0 +1,51 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#ifndef QTAV_FUSEDCONVERT_H
+#define QTAV_FUSEDCONVERT_H
+
+#include <QtAV/QtAV_Global.h>
+
+QT_BEGIN_NAMESPACE
+class QMatrix4x4;
+class QSize;
+QT_END_NAMESPACE
+namespace QtAV {
+class VideoFormat;
+class VideoFrame;
+/*!
+ * \brief canFusedConvert
+ * true if \a format is a planar yuv format of 8 bits, with any chroma subsampling. An alpha plane is ignored.
+ */
+Q_AV_PRIVATE_EXPORT bool canFusedConvert(const VideoFormat& format);
+/*!
+ * \brief fusedConvertRGB32
+ * Convert a yuv frame in host memory to Format_RGB32 of \a dstSize in one pass, i.e. color conversion, bilinear scaling and
+ * color adjustment are done together. Each source row is scaled horizontally once into a small row buffer, and each
+ * destination row is written once, so no intermediate frame is allocated.
+ * \param m yuv to rgb matrix of normalized components, e.g. ColorTransform::matrixRef() with yuv input and rgb output.
+ * brightness, contrast, saturation and hue of the ColorTransform are included for free.
+ * \param dst destination pixels, at least dstStride*dstSize.height() bytes
+ * \return false if not supported
+ */
+Q_AV_PRIVATE_EXPORT bool fusedConvertRGB32(const VideoFrame& frame, const QMatrix4x4& m, uchar* dst, int dstStride, const QSize& dstSize);
+} //namespace QtAV
+#endif //QTAV_FUSEDCONVERT_H
@@ -34,6 +34,8 @@ class Q_AV_PRIVATE_EXPORT QPainterRendererPrivate : public VideoRendererPrivate
 public:
     QPainterRendererPrivate():
         painter(0)
+      , prescale(false)
+      , pixmap_scaled(false)
     {}
     virtual ~QPainterRendererPrivate(){
         if (painter) {
@@ -62,6 +64,14 @@ public:
     // drawPixmap() is faster for on screen painting
     QPixmap pixmap;
     QPainter *painter;
+    bool prescale;
+    bool pixmap_scaled; // pixmap is the whole frame scaled to out_rect size when prepared
+    VideoFrame frame_orig; // unscaled frame to prepare again when resized or the equalizer changes
+    VideoFrameConverter conv; // guarded by img_mutex
+    VideoFrame scaled_frame; // converter output for the prescaled pixmap. video_frame is always the source frame
+    QImage fused_image; // yuv frame converted, scaled and adjusted by fusedConvertRGB32(). guarded by img_mutex
+    VideoFrame adjusted_frame; // rgb frame adjusted by colorAdjust() without prescale. guarded by img_mutex
+
 };
 
 } //namespace QtAV
@@ -0,0 +1,96 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#ifndef QTAV_SUBIMAGEBLEND_H
+#define QTAV_SUBIMAGEBLEND_H
+
+#include <QtAV/QtAV_Global.h>
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+class QImage;
+class QPoint;
+QT_END_NAMESPACE
+namespace QtAV {
+struct SubImageSet;
+class VideoFormat;
+class VideoFrame;
+/*!
+ * \brief BlendASSFunc
+ * Blend an ASS bitmap (8 bit coverage per pixel) of a solid color into ARGB32 pixels.
+ * \param dstStride, srcStride bytes per line
+ * \param color 0xAARRGGBB, AA is the opacity, i.e. 255 - alpha of ASS_Image.color
+ * For each pixel, k = coverage*AA/255 (truncated). Pixels with k == 0 are not changed. A transparent pixel becomes (RR, GG, BB, k),
+ * otherwise each channel is blended to the color with (k*c + (255-k)*C)/255 where alpha blends to AA.
+ * Other divisions by 255 are rounded. All kernels give the same result.
+ */
+typedef void (*BlendASSFunc)(quint32 *dst, int dstStride, const quint8 *src, int srcStride, int w, int h, quint32 color);
+enum BlendASSKernel {
+    BlendASS_Auto, ///< the fastest kernel available on current cpu
+    BlendASS_C,
+    BlendASS_SSE2,
+    BlendASS_AVX2,
+    BlendASS_NEON
+};
+/// return 0 if \a kernel is not built or not supported by current cpu
+Q_AV_PRIVATE_EXPORT BlendASSFunc blendASSFunc(BlendASSKernel kernel = BlendASS_Auto);
+
+/*!
+ * \brief canBlendYUV
+ * true if \a format is a 3 plane YUV format (420, 422, 444, 411 and 410) of 8~16 bits in host byte order,
+ * then blendSubImagesYUV() and blendImageYUV() can draw on frames of \a format
+ */
+Q_AV_PRIVATE_EXPORT bool canBlendYUV(const VideoFormat& format);
+/*!
+ * \brief blendSubImagesYUV
+ * Burn ASS images into a YUV frame in place. Only the pixels covered by the images are changed. Images are converted to
+ * YUV using the color space and range of the frame. A chroma sample is blended with the average alpha and color of the
+ * luma pixels it covers.
+ * The frame data must be writable, i.e. not shared with a decoder.
+ * \param set images rendered at frame size
+ * \return false if frame format is not supported or \a set is not ASS
+ */
+Q_AV_PRIVATE_EXPORT bool blendSubImagesYUV(VideoFrame* frame, const SubImageSet& set);
+/// blend an ARGB32 or ARGB32_Premultiplied image at \a pos in frame. see blendSubImagesYUV()
+Q_AV_PRIVATE_EXPORT bool blendImageYUV(VideoFrame* frame, const QImage& image, const QPoint& pos);
+/*!
+ * \brief The YUVImage struct
+ * Alpha and YUV planes of an image converted by convertImageYUV(). An image drawn on many frames is converted only once
+ */
+struct YUVImage {
+    YUVImage() : width(0), height(0), color_space(ColorSpace_Unknown), full_range(false) {}
+    bool isNull() const { return planes.isEmpty();}
+    QVector<quint8> planes; // alpha, y, u, v. width*height each
+    int width, height;
+    ColorSpace color_space; // used by conversion, BT601 or BT709
+    bool full_range;
+};
+/*!
+ * \brief convertImageYUV
+ * Convert an ARGB32 or ARGB32_Premultiplied image to YUV in the color space and range of \a frame.
+ * If \a yuv is already converted from \a image for frames like \a frame, nothing is done
+ * \param imageChanged true if \a image is not the one \a yuv is converted from
+ */
+Q_AV_PRIVATE_EXPORT bool convertImageYUV(const VideoFrame& frame, const QImage& image, bool imageChanged, YUVImage* yuv);
+/// blend \a image converted by convertImageYUV() for frames like \a frame at \a pos in frame
+Q_AV_PRIVATE_EXPORT bool blendImageYUV(VideoFrame* frame, const YUVImage& image, const QPoint& pos);
+} //namespace QtAV
+#endif //QTAV_SUBIMAGEBLEND_H
@@ -22,7 +22,9 @@
 #ifndef QTAV_SUBTITLEPROCESSOR_H
 #define QTAV_SUBTITLEPROCESSOR_H
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QList>
+#include <QtCore/QObject>
 #include <QtGui/QImage>
 #include <QtAV/QtAV_Global.h>
 #include <QtAV/Subtitle.h>
@@ -109,5 +111,30 @@ private:
     int m_width, m_height;
 };
 
+/*!
+ * \brief The SubtitleFontCache class
+ * Process wide font cache state. Font providers (e.g. fontconfig) may scan all fonts for seconds at the first time,
+ * so the cache is warmed up once in a background thread and shared by all processors. A processor requires the cache
+ * renders nothing until ready, and Subtitle falls back to plain text.
+ */
+class Q_AV_PRIVATE_EXPORT SubtitleFontCache : public QObject
+{
+    Q_OBJECT
+public:
+    static SubtitleFontCache* instance();
+    /// return true for the first call only, then the caller must start warming up and call endWarmup() when finished
+    bool beginWarmup();
+    void endWarmup(qint64 elapsed);
+    bool isReady() const;
+    /// warm-up time in ms. -1 if not ready
+    qint64 warmupTime() const;
+Q_SIGNALS:
+    void ready(qint64 elapsed);
+private:
+    SubtitleFontCache();
+    mutable QAtomicInt m_state;
+    qint64 m_elapsed;
+};
+
 } //namespace QtAV
 #endif // QTAV_SUBTITLEPROCESSOR_H
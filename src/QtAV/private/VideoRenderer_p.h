@@ -24,6 +24,7 @@
 
 #include <QtAV/private/AVOutput_p.h>
 #include <QtAV/VideoRenderer.h>
+#include <QtCore/QAtomicInt>
 #include <QtCore/QMutex>
 #include <QtCore/QRect>
 #include <QtAV/VideoFrame.h>
@@ -61,6 +62,9 @@ public:
       , hue(0)
       , saturation(0)
       , bg_color(0, 0, 0)
+      , frames_received(0)
+      , frames_painted(0)
+      , frame_dirty(false)
       , orientation(0)
     {
         //conv.setInFormat(PIX_FMT_YUV420P);
@@ -76,7 +80,10 @@ public:
         if (out_aspect_ratio_mode == VideoRenderer::RendererAspectRatio) {
             out_aspect_ratio = rendererAspectRatio;
             out_rect = QRect(0, 0, renderer_width, renderer_height);
-            return out_rect0 != out_rect;
+            if (out_rect0 == out_rect)
+                return false;
+            update_background = true;
+            return true;
         }
         // dar: displayed aspect ratio in video renderer orientation
         int rotate = orientation;
@@ -98,7 +105,10 @@ public:
         }
         out_aspect_ratio = outAspectRatio;
         //qDebug("%f %dx%d <<<<<<<<", out_aspect_ratio, out_rect.width(), out_rect.height());
-        return out_rect0 != out_rect;
+        if (out_rect0 == out_rect)
+            return false;
+        update_background = true; // letterbox area changed
+        return true;
     }
     virtual void setupQuality() {}
     int rotation() const {
@@ -130,6 +140,14 @@ public:
 
     qreal brightness, contrast, hue, saturation;
     QColor bg_color;
+    /*!
+     * an update posted by updateUi() and not painted yet. 1: video rect, 2: whole renderer.
+     * updates from receiveFrame() are coalesced until handlePaintEvent()
+     */
+    QAtomicInt update_pending;
+    // guarded by img_mutex
+    qint64 frames_received, frames_painted;
+    bool frame_dirty; // received but not painted
 private:
     int orientation;
     friend class VideoRenderer;
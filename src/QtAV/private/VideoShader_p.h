@@ -52,6 +52,7 @@ enum ShaderType {
 };
 
 class VideoShader;
+class VideoMaterial;
 class Q_AV_PRIVATE_EXPORT VideoShaderPrivate : public DPtrPrivate<VideoShader>
 {
 public:
@@ -67,6 +68,7 @@ public:
         , u_c(-1)
         , material_type(0)
         , texture_target(GL_TEXTURE_2D)
+        , last_type(0)
     {}
     virtual ~VideoShaderPrivate() {
         if (owns_program && program) {
@@ -97,9 +99,17 @@ public:
     mutable QByteArray planar_frag, packed_frag;
     mutable QByteArray vert;
     QVector<Uniform> user_uniforms[ShaderTypeCount];
+    // shader is shared by materials(ShaderManager). builtin uniforms must be updated if they differ from the values of the last material
+    qint32 last_type;
+    QMatrix4x4 last_color_matrix, last_channel_map;
+    QVector2D last_to8;
+    QVector<QVector2D> last_texel_size, last_texture_size;
 };
 
 class VideoMaterial;
+class PixelBufferRing;
+class TexturePool;
+class TextureSet;
 class VideoMaterialPrivate : public DPtrPrivate<VideoMaterial>
 {
 public:
@@ -115,6 +125,10 @@ public:
         , target(GL_TEXTURE_2D)
         , dirty(true)
         , try_pbo(true)
+        , ring(0)
+        , ring_slot(-1)
+        , tex_pool(0)
+        , tex_set(0)
     {
         v_texel_size.reserve(4);
         textures.reserve(4);
@@ -134,8 +148,12 @@ public:
     bool initTexture(GLuint tex, GLint internal_format, GLenum format, GLenum dataType, int width, int height);
     bool updateTextureParameters(const VideoFormat& fmt);
     void uploadPlane(int p, bool updateTexture = true);
+    void texSubImage(int p, const void* data);
     bool ensureResources();
     bool ensureTextures();
+    bool ensurePooledTextures(bool *upload);
+    void releasePooledTextures();
+    QByteArray textureKey() const;
     void setupQuality();
 
     bool update_texure; // reduce upload/map times. true: new frame not bound. false: current frame is bound
@@ -169,6 +187,12 @@ public:
     ColorTransform colorTransform;
     bool try_pbo;
     QVector<QOpenGLBuffer> pbo;
+    // set by OpenGLVideo. upload the current frame from ring slot if ring_slot >= 0
+    PixelBufferRing *ring;
+    int ring_slot;
+    // set by OpenGLVideo. textures of host memory frames are from the pool
+    TexturePool *tex_pool;
+    TextureSet *tex_set;
     QVector2D vec_to8; //TODO: vec3 to support both RG and LA (.rga, vec_to8)
     QMatrix4x4 channel_map;
     QVector<QVector2D> v_texel_size;
@@ -20,6 +20,11 @@
 ******************************************************************************/
 
 #include "QtAV/Statistics.h"
+#include <QtCore/QAtomicInt>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+#include <QtCore/QScopedPointer>
+#include <limits>
 #include "utils/ring.h"
 
 namespace QtAV {
@@ -29,6 +34,8 @@ Statistics::Common::Common():
   , bit_rate(0)
   , frames(0)
   , frame_rate(0)
+  , buffered_bytes(0)
+  , buffered_time(0)
 {
 }
 
@@ -40,6 +47,24 @@ Statistics::AudioOnly::AudioOnly():
 {
 }
 
+Statistics::LiveOnly::LiveOnly():
+    target_latency(0)
+  , latency(0)
+  , max_latency(0)
+  , catch_up_speed(1.0)
+  , frame_drop(false)
+  , catch_up_count(0)
+{
+}
+
+Statistics::LoadOnly::LoadOnly():
+    start(0)
+  , open_time(0)
+  , probe_cached(false)
+  , first_frame_time(-1)
+{
+}
+
 class Statistics::VideoOnly::Private : public QSharedData {
 public:
     Private()
@@ -114,6 +139,272 @@ qreal Statistics::VideoOnly::currentDisplayFPS() const
     return (qreal)d->history.size()/dt;
 }
 
+static const int kSubBits = 3;
+static const int kSubBuckets = 1 << kSubBits;
+static const int kMaxExp = 30; // values are stored in QAtomicInt
+static const qint64 kMaxValue = (1LL << (kMaxExp + 1)) - 1;
+static const int kBucketCount = (kMaxExp - kSubBits + 2)*kSubBuckets;
+static const int kTraceEvents = 16384;
+
+Statistics::Histogram::Histogram()
+    : count(0)
+    , min(0)
+    , max(0)
+{
+}
+
+int Statistics::Histogram::bucketCount()
+{
+    return kBucketCount;
+}
+
+int Statistics::Histogram::bucketIndex(qint64 value)
+{
+    if (value < 0)
+        value = 0;
+    else if (value > kMaxValue)
+        value = kMaxValue;
+    if (value < kSubBuckets)
+        return int(value);
+    int e = 0; // most significant bit
+    for (qint64 v = value; v > 1; v >>= 1)
+        ++e;
+    return (e - kSubBits + 1)*kSubBuckets + int((value >> (e - kSubBits)) & (kSubBuckets - 1));
+}
+
+qint64 Statistics::Histogram::bucketValue(int index)
+{
+    if (index < kSubBuckets)
+        return qMax(0, index);
+    if (index >= kBucketCount)
+        return kMaxValue + 1;
+    const int e = index/kSubBuckets + kSubBits - 1;
+    return qint64(kSubBuckets + index % kSubBuckets) << (e - kSubBits);
+}
+
+qint64 Statistics::Histogram::percentile(qreal p) const
+{
+    if (count <= 0 || buckets.isEmpty())
+        return 0;
+    const qint64 target = qMax<qint64>(1, qint64(qreal(count)*qBound<qreal>(0, p, 100)/100.0 + 0.5));
+    qint64 n = 0;
+    for (int i = 0; i < buckets.size(); ++i) {
+        n += buckets.at(i);
+        if (n >= target)
+            return qBound(min, bucketValue(i), max);
+    }
+    return max;
+}
+
+qreal Statistics::Histogram::mean() const
+{
+    if (count <= 0 || buckets.isEmpty())
+        return 0;
+    qreal s = 0;
+    for (int i = 0; i < buckets.size(); ++i) {
+        if (!buckets.at(i))
+            continue;
+        const qreal v = 0.5*qreal(bucketValue(i) + bucketValue(i + 1) - 1);
+        s += v*qreal(buckets.at(i));
+    }
+    return qBound<qreal>(min, s/qreal(count), max);
+}
+
+namespace {
+// QAtomicInt value in Qt4 and Qt5
+inline int atomicValue(const QAtomicInt& a) { return const_cast<QAtomicInt&>(a).fetchAndAddRelaxed(0); }
+class MonotonicClock {
+public:
+    MonotonicClock() { timer.start(); }
+    qint64 now() const { return timer.nsecsElapsed()/1000LL; }
+private:
+    QElapsedTimer timer;
+};
+static MonotonicClock clock_us;
+} //namespace
+
+class Statistics::Pipeline::Private : public QSharedData {
+public:
+    Private() {
+        reset();
+    }
+    void reset() {
+        for (int s = 0; s < StageCount; ++s) {
+            for (int i = 0; i < kBucketCount; ++i)
+                buckets[s][i].fetchAndStoreRelaxed(0);
+            min[s].fetchAndStoreRelaxed(std::numeric_limits<int>::max());
+            max[s].fetchAndStoreRelaxed(0);
+        }
+        dropped.fetchAndStoreRelaxed(0);
+        late.fetchAndStoreRelaxed(0);
+        QMutexLocker lock(&trace_mutex);
+        Q_UNUSED(lock);
+        events.reset(); // allocated by the next traced event
+    }
+
+    struct TraceEvent {
+        TraceEvent() : stage(0), ts(0), dur(0) {}
+        int stage;
+        qint64 ts, dur;
+    };
+    QAtomicInt buckets[StageCount][kBucketCount];
+    QAtomicInt min[StageCount], max[StageCount];
+    QAtomicInt dropped, late;
+    QAtomicInt trace;
+    QMutex trace_mutex;
+    QScopedPointer<ring<TraceEvent> > events; // null until tracing is enabled and an event is recorded
+};
+
+Statistics::Pipeline::Pipeline()
+    : d(new Private())
+{
+}
+
+Statistics::Pipeline::Pipeline(const Pipeline &other)
+    : d(other.d)
+{
+}
+
+Statistics::Pipeline& Statistics::Pipeline::operator =(const Pipeline &other)
+{
+    d = other.d;
+    return *this;
+}
+
+Statistics::Pipeline::~Pipeline()
+{
+}
+
+const char* Statistics::Pipeline::stageName(Stage stage)
+{
+    static const char* names[] = {
+        "DemuxRead",
+        "AudioQueueWait",
+        "AudioDecode",
+        "AudioFilter",
+        "AudioOutput",
+        "VideoQueueWait",
+        "VideoDecode",
+        "VideoFilter",
+        "VideoConvert",
+        "VideoPresent"
+    };
+    if (stage < DemuxRead || stage >= StageCount)
+        return "Unknown";
+    return names[stage];
+}
+
+qint64 Statistics::Pipeline::now()
+{
+    return clock_us.now();
+}
+
+void Statistics::Pipeline::record(Stage stage, qint64 start)
+{
+    if (stage < DemuxRead || stage >= StageCount)
+        return;
+    const qint64 t = now();
+    const int v = int(qBound<qint64>(0, t - start, kMaxValue));
+    d->buckets[stage][Histogram::bucketIndex(v)].fetchAndAddRelaxed(1);
+    int m = atomicValue(d->min[stage]);
+    while (v < m && !d->min[stage].testAndSetRelaxed(m, v))
+        m = atomicValue(d->min[stage]);
+    m = atomicValue(d->max[stage]);
+    while (v > m && !d->max[stage].testAndSetRelaxed(m, v))
+        m = atomicValue(d->max[stage]);
+    if (!atomicValue(d->trace))
+        return;
+    Private::TraceEvent e;
+    e.stage = stage;
+    e.ts = start;
+    e.dur = v;
+    QMutexLocker lock(&d->trace_mutex);
+    Q_UNUSED(lock);
+    if (!d->events)
+        d->events.reset(new ring<Private::TraceEvent>(kTraceEvents));
+    d->events->push_back(e);
+}
+
+void Statistics::Pipeline::videoFrameDropped()
+{
+    d->dropped.fetchAndAddRelaxed(1);
+}
+
+void Statistics::Pipeline::videoFrameLate()
+{
+    d->late.fetchAndAddRelaxed(1);
+}
+
+qint64 Statistics::Pipeline::droppedVideoFrames() const
+{
+    return atomicValue(d->dropped);
+}
+
+qint64 Statistics::Pipeline::lateVideoFrames() const
+{
+    return atomicValue(d->late);
+}
+
+Statistics::Histogram Statistics::Pipeline::histogram(Stage stage) const
+{
+    Histogram h;
+    if (stage < DemuxRead || stage >= StageCount)
+        return h;
+    h.buckets.resize(kBucketCount);
+    for (int i = 0; i < kBucketCount; ++i) {
+        h.buckets[i] = atomicValue(d->buckets[stage][i]);
+        h.count += h.buckets[i];
+    }
+    if (h.count > 0) {
+        h.min = atomicValue(d->min[stage]);
+        h.max = atomicValue(d->max[stage]);
+    }
+    return h;
+}
+
+void Statistics::Pipeline::reset()
+{
+    d->reset();
+}
+
+void Statistics::Pipeline::setTraceEnabled(bool value)
+{
+    d->trace.fetchAndStoreRelaxed(value);
+}
+
+bool Statistics::Pipeline::isTraceEnabled() const
+{
+    return !!atomicValue(d->trace);
+}
+
+QByteArray Statistics::Pipeline::chromeTrace() const
+{
+    QByteArray json("{\"traceEvents\":[");
+    {
+        QMutexLocker lock(&d->trace_mutex);
+        Q_UNUSED(lock);
+        const size_t n = d->events ? d->events->size() : 0;
+        for (size_t i = 0; i < n; ++i) {
+            const Private::TraceEvent &e = d->events->at(i);
+            // one thread id for each thread type
+            const int tid = e.stage == DemuxRead ? 1 : (e.stage < VideoQueueWait ? 2 : 3);
+            if (i > 0)
+                json += ',';
+            json += "{\"name\":\"";
+            json += stageName(Stage(e.stage));
+            json += "\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+            json += QByteArray::number(tid);
+            json += ",\"ts\":";
+            json += QByteArray::number(e.ts);
+            json += ",\"dur\":";
+            json += QByteArray::number(e.dur);
+            json += '}';
+        }
+    }
+    json += "],\"displayTimeUnit\":\"ms\"}";
+    return json;
+}
+
 Statistics::Statistics()
 {
 }
@@ -129,6 +420,9 @@ void Statistics::reset()
     video = Common();
     audio_only = AudioOnly();
     video_only = VideoOnly();
+    live_only = LiveOnly();
+    load_only = LoadOnly();
+    pipeline.reset(); // shared with running threads
     metadata.clear();
 }
 
@@ -0,0 +1,420 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#include "QtAV/ThumbnailService.h"
+#include <QtCore/QCache>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QSet>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+#include "QtAV/VideoFrameExtractor.h"
+#include "utils/Logger.h"
+
+namespace QtAV {
+namespace {
+// requested positions in the same bucket share a cached frame. previews can not tell the difference
+const qint64 kPositionBucket = 200;
+const qint64 kDefaultCacheSize = 32*1024*1024;
+
+struct ThumbnailRequest {
+    int id;
+    const void* client;
+    QString file;
+    qint64 position;
+    QSize size;
+    int priority;
+};
+
+struct ThumbnailResult {
+    int id;
+    VideoFrame frame;
+    QString error;
+};
+
+QString cacheKey(const QString& file, qint64 position, const QSize& size)
+{
+    return QString::fromLatin1("%1|%2x%3|%4").arg(file).arg(size.width()).arg(size.height()).arg(position/kPositionBucket);
+}
+} //namespace
+
+// extractor signals are emitted in the worker thread because extract() is synchronous
+class ThumbnailReceiver : public QObject
+{
+    Q_OBJECT
+public:
+    bool ok;
+    VideoFrame frame;
+    QString error;
+public Q_SLOTS:
+    void onFrame(const QtAV::VideoFrame& f) {
+        ok = true;
+        frame = f;
+    }
+    void onError(const QString& message) {
+        ok = false;
+        error = message;
+    }
+};
+
+class ThumbnailWorker;
+class ThumbnailServicePrivate : public DPtrPrivate<ThumbnailService>
+{
+public:
+    ThumbnailServicePrivate()
+        : q(0)
+        , max_workers(qBound(1, QThread::idealThreadCount()/2, 4))
+        , idle(0)
+        , next_id(0)
+        , stop(false)
+        , deliver_posted(false)
+    {
+        cache.setMaxCost(int(kDefaultCacheSize/1024));
+    }
+    // the highest priority first. a request of the worker's open file is preferred for the same priority
+    bool take(const QString& source, ThumbnailRequest* r) {
+        int best = -1;
+        for (int i = 0; i < queue.size(); ++i) {
+            if (best < 0 || queue.at(i).priority > queue.at(best).priority) {
+                best = i;
+                continue;
+            }
+            if (queue.at(i).priority == queue.at(best).priority && queue.at(best).file != source && queue.at(i).file == source)
+                best = i;
+        }
+        if (best < 0)
+            return false;
+        *r = queue.takeAt(best);
+        return true;
+    }
+    void cancelClient(const void* client) {
+        for (int i = queue.size() - 1; i >= 0; --i) {
+            if (queue.at(i).client == client)
+                queue.removeAt(i);
+        }
+        QHash<int, const void*>::const_iterator it = running.constBegin();
+        for (; it != running.constEnd(); ++it) {
+            if (it.value() == client)
+                cancelled.insert(it.key());
+        }
+    }
+    // lock required
+    void postResult(const ThumbnailResult& r) {
+        ready.append(r);
+        if (deliver_posted)
+            return;
+        deliver_posted = true;
+        QMetaObject::invokeMethod(q, "deliver", Qt::QueuedConnection);
+    }
+    void finish(int id, const VideoFrame& frame, const QString& error) {
+        QMutexLocker lock(&mutex);
+        Q_UNUSED(lock);
+        running.remove(id);
+        if (cancelled.remove(id))
+            return;
+        ThumbnailResult r;
+        r.id = id;
+        r.frame = frame;
+        r.error = error;
+        postResult(r);
+    }
+    void cacheFrame(const QString& key, const VideoFrame& frame) {
+        // cost in KB so that a large cache fits in int
+        const int cost = qMax(1, frame.width()*frame.height()*4/1024);
+        QMutexLocker lock(&mutex);
+        Q_UNUSED(lock);
+        cache.insert(key, new VideoFrame(frame), cost);
+    }
+    bool cachedFrame(const QString& key, VideoFrame* frame) {
+        VideoFrame *f = cache.object(key);
+        if (!f)
+            return false;
+        *frame = *f;
+        return true;
+    }
+
+    ThumbnailService *q;
+    QMutex mutex;
+    QWaitCondition cond;
+    QList<ThumbnailRequest> queue;
+    QList<ThumbnailWorker*> workers;
+    QList<ThumbnailWorker*> retired; // exited because of setMaxWorkers()
+    int max_workers;
+    int idle;
+    int next_id;
+    bool stop;
+    bool deliver_posted;
+    QHash<int, const void*> running;
+    QSet<int> cancelled;
+    QList<ThumbnailResult> ready;
+    QCache<QString, VideoFrame> cache;
+};
+
+class ThumbnailWorker : public QThread
+{
+public:
+    ThumbnailWorker(ThumbnailServicePrivate* p) : QThread(0), d(p) {}
+protected:
+    void run() {
+        // created in this thread so that signals of synchronous extract() are delivered directly
+        VideoFrameExtractor extractor;
+        extractor.setAsync(false);
+        extractor.setAutoExtract(false);
+        ThumbnailReceiver receiver;
+        connect(&extractor, SIGNAL(frameExtracted(QtAV::VideoFrame)), &receiver, SLOT(onFrame(QtAV::VideoFrame)), Qt::DirectConnection);
+        connect(&extractor, SIGNAL(error(QString)), &receiver, SLOT(onError(QString)), Qt::DirectConnection);
+        connect(&extractor, SIGNAL(aborted(QString)), &receiver, SLOT(onError(QString)), Qt::DirectConnection);
+        ThumbnailRequest r;
+        while (next(extractor.source(), &r)) {
+            const QString key(cacheKey(r.file, r.position, r.size));
+            VideoFrame frame;
+            bool cached = false;
+            {
+                QMutexLocker lock(&d->mutex);
+                Q_UNUSED(lock);
+                cached = d->cachedFrame(key, &frame); // decoded by another worker while queued
+            }
+            if (cached) {
+                d->finish(r.id, frame, QString());
+                continue;
+            }
+            extractor.setSource(r.file); // demuxer and decoder are reused for the same file
+            extractor.setTargetSize(r.size);
+            extractor.setPosition(r.position);
+            receiver.ok = false;
+            receiver.error = QString::fromLatin1("No frame");
+            extractor.extract();
+            if (receiver.ok)
+                frame = scaled(receiver.frame, r.size);
+            receiver.frame = VideoFrame();
+            if (!frame.isValid()) {
+                d->finish(r.id, VideoFrame(), receiver.ok ? QString::fromLatin1("Cannot convert frame") : receiver.error);
+                continue;
+            }
+            d->cacheFrame(key, frame);
+            d->finish(r.id, frame, QString());
+        }
+    }
+private:
+    bool next(const QString& source, ThumbnailRequest* r) {
+        QMutexLocker lock(&d->mutex);
+        Q_UNUSED(lock);
+        while (!d->stop) {
+            if (d->workers.size() > d->max_workers) {
+                d->workers.removeOne(this);
+                d->retired.append(this);
+                return false;
+            }
+            if (d->take(source, r)) {
+                d->running.insert(r->id, r->client);
+                return true;
+            }
+            d->idle++;
+            d->cond.wait(&d->mutex);
+            d->idle--;
+        }
+        return false;
+    }
+    static VideoFrame scaled(const VideoFrame& frame, const QSize& size) {
+        QSize s(frame.size());
+        if (size.isValid() && !size.isEmpty())
+            s.scale(size, Qt::KeepAspectRatio);
+        if (s.isEmpty())
+            return VideoFrame();
+        if (frame.pixelFormat() == VideoFormat::Format_RGB32 && frame.size() == s)
+            return frame;
+        return frame.to(VideoFormat::Format_RGB32, s);
+    }
+
+    ThumbnailServicePrivate *d;
+};
+
+ThumbnailService* ThumbnailService::instance()
+{
+    static ThumbnailService *s = new ThumbnailService(); // not deleted because widgets may use it until the end
+    return s;
+}
+
+ThumbnailService::ThumbnailService()
+    : QObject(0)
+{
+    DPTR_D(ThumbnailService);
+    d.q = this;
+    if (qApp)
+        connect(qApp, SIGNAL(aboutToQuit()), SLOT(handleAppQuit()), Qt::DirectConnection);
+}
+
+ThumbnailService::~ThumbnailService()
+{
+    handleAppQuit();
+}
+
+void ThumbnailService::setMaxWorkers(int value)
+{
+    DPTR_D(ThumbnailService);
+    QMutexLocker lock(&d.mutex);
+    Q_UNUSED(lock);
+    d.max_workers = qMax(1, value);
+    d.cond.wakeAll(); // surplus workers exit
+}
+
+int ThumbnailService::maxWorkers() const
+{
+    DPTR_D(const ThumbnailService);
+    return d.max_workers;
+}
+
+void ThumbnailService::setCacheSize(qint64 bytes)
+{
+    DPTR_D(ThumbnailService);
+    QMutexLocker lock(&d.mutex);
+    Q_UNUSED(lock);
+    d.cache.setMaxCost(int(qMax<qint64>(0, bytes)/1024));
+}
+
+qint64 ThumbnailService::cacheSize() const
+{
+    DPTR_D(const ThumbnailService);
+    return qint64(d.cache.maxCost())*1024;
+}
+
+void ThumbnailService::clearCache()
+{
+    DPTR_D(ThumbnailService);
+    QMutexLocker lock(&d.mutex);
+    Q_UNUSED(lock);
+    d.cache.clear();
+}
+
+int ThumbnailService::request(const void *client, const QString &file, qint64 position, const QSize &size, int priority)
+{
+    DPTR_D(ThumbnailService);
+    QMutexLocker lock(&d.mutex);
+    Q_UNUSED(lock);
+    const int id = ++d.next_id;
+    if (client)
+        d.cancelClient(client);
+    VideoFrame frame;
+    if (d.cachedFrame(cacheKey(file, position, size), &frame)) {
+        ThumbnailResult r;
+        r.id = id;
+        r.frame = frame;
+        d.postResult(r);
+        return id;
+    }
+    if (d.stop) {
+        ThumbnailResult r;
+        r.id = id;
+        r.error = QString::fromLatin1("Thumbnail service is stopped");
+        d.postResult(r);
+        return id;
+    }
+    ThumbnailRequest r;
+    r.id = id;
+    r.client = client;
+    r.file = file;
+    r.position = position;
+    r.size = size;
+    r.priority = priority;
+    d.queue.append(r);
+    if (d.idle > 0) {
+        d.cond.wakeOne();
+        return id;
+    }
+    foreach (ThumbnailWorker *w, d.retired) {
+        if (!w->isFinished())
+            continue;
+        d.retired.removeOne(w);
+        delete w;
+    }
+    if (d.workers.size() < d.max_workers) {
+        ThumbnailWorker *w = new ThumbnailWorker(&d);
+        d.workers.append(w);
+        w->start();
+    }
+    return id;
+}
+
+void ThumbnailService::cancel(const void *client)
+{
+    if (!client)
+        return;
+    DPTR_D(ThumbnailService);
+    QMutexLocker lock(&d.mutex);
+    Q_UNUSED(lock);
+    d.cancelClient(client);
+}
+
+void ThumbnailService::setPriority(const void *client, int priority)
+{
+    if (!client)
+        return;
+    DPTR_D(ThumbnailService);
+    QMutexLocker lock(&d.mutex);
+    Q_UNUSED(lock);
+    for (int i = 0; i < d.queue.size(); ++i) {
+        if (d.queue.at(i).client == client)
+            d.queue[i].priority = priority;
+    }
+}
+
+void ThumbnailService::deliver()
+{
+    DPTR_D(ThumbnailService);
+    QList<ThumbnailResult> results;
+    {
+        QMutexLocker lock(&d.mutex);
+        Q_UNUSED(lock);
+        results.swap(d.ready);
+        d.deliver_posted = false;
+    }
+    foreach (const ThumbnailResult& r, results) {
+        if (r.frame.isValid())
+            Q_EMIT frameReady(r.id, r.frame);
+        else
+            Q_EMIT error(r.id, r.error);
+    }
+}
+
+void ThumbnailService::handleAppQuit()
+{
+    DPTR_D(ThumbnailService);
+    QList<ThumbnailWorker*> workers;
+    {
+        QMutexLocker lock(&d.mutex);
+        Q_UNUSED(lock);
+        d.stop = true;
+        d.queue.clear();
+        d.cond.wakeAll();
+        workers = d.workers + d.retired;
+        d.workers.clear();
+        d.retired.clear();
+    }
+    foreach (ThumbnailWorker *w, workers) {
+        w->wait();
+        delete w;
+    }
+    d.cache.clear();
+}
+} //namespace QtAV
+#include "ThumbnailService.moc"
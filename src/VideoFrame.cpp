@@ -21,6 +21,7 @@
 
 #include "QtAV/VideoFrame.h"
 #include "QtAV/private/Frame_p.h"
+#include "QtAV/FrameAllocator.h"
 #include "QtAV/SurfaceInterop.h"
 #include "ImageConverter.h"
 #include <QtCore/QSharedPointer>
@@ -62,27 +63,14 @@ VideoFrame VideoFrame::fromGPU(const VideoFormat& fmt, int width, int height, in
     }
     VideoFrame frame;
     if (optimized) {
-        int yuv_size = 0;
-        for (int i = 0; i < nb_planes; ++i) {
-            yuv_size += pitch[i]*h[i];
-        }
-        // additional 15 bytes to ensure 16 bytes aligned
-        QByteArray buf(15 + yuv_size, 0);
-        const int offset_16 = (16 - ((uintptr_t)buf.constData() & 0x0f)) & 0x0f;
-        // plane 1, 2... is aligned?
-        uchar* plane_ptr = (uchar*)buf.constData() + offset_16;
-        QVector<uchar*> dst(nb_planes, 0);
+        frame = VideoFrame(width, height, fmt);
+        // pitch instead of surface_width
+        frame.setBytesPerLine(pitch);
+        if (!frame.allocate(surface_h))
+            return VideoFrame();
         for (int i = 0; i < nb_planes; ++i) {
-            dst[i] = plane_ptr;
-            // TODO: add VideoFormat::planeWidth/Height() ?
-            // pitch instead of surface_width
-            plane_ptr += pitch[i] * h[i];
-            gpu_memcpy(dst[i], src[i], pitch[i]*h[i]);
-
+            gpu_memcpy(frame.bits(i), src[i], pitch[i]*h[i]);
         }
-        frame = VideoFrame(width, height, fmt, buf);
-        frame.setBits(dst);
-        frame.setBytesPerLine(pitch);
     } else {
         frame = VideoFrame(width, height, fmt);
         frame.setBits(src);
@@ -160,6 +148,7 @@ VideoFrame::VideoFrame(int width, int height, const VideoFormat &format, const Q
     Q_D(VideoFrame);
     d->data = data;
     d->data_align = alignment;
+    d->accountData(MemoryAccounting::VideoFrames);
 }
 
 VideoFrame::VideoFrame(const QImage& image)
@@ -219,21 +208,15 @@ VideoFrame VideoFrame::clone() const
         f.setDisplayAspectRatio(d->displayAspectRatio);
         return f;
     }
-    int bytes = 0;
-    for (int i = 0; i < d->format.planeCount(); ++i) {
-        bytes += bytesPerLine(i)*planeHeight(i);
-    }
-
-    QByteArray buf(bytes, 0);
-    char *dst = buf.data(); //must before buf is shared, otherwise data will be detached.
-    VideoFrame f(width(), height(), d->format, buf);
+    VideoFrame f(width(), height(), d->format);
     const int nb_planes = d->format.planeCount();
     for (int i = 0; i < nb_planes; ++i) {
-        f.setBits((quint8*)dst, i);
         f.setBytesPerLine(bytesPerLine(i), i);
-        const int plane_size = bytesPerLine(i)*planeHeight(i);
-        memcpy(dst, constBits(i), plane_size);
-        dst += plane_size;
+    }
+    if (!f.allocate())
+        return VideoFrame();
+    for (int i = 0; i < nb_planes; ++i) {
+        memcpy(f.bits(i), constBits(i), bytesPerLine(i)*planeHeight(i));
     }
     f.d_ptr->metadata = d->metadata; // need metadata?
     f.setTimestamp(d->timestamp);
@@ -243,6 +226,30 @@ VideoFrame VideoFrame::clone() const
     return f;
 }
 
+bool VideoFrame::allocate(int surfaceHeight)
+{
+    Q_D(VideoFrame);
+    if (!d->format.isValid() || d->width <= 0 || d->height <= 0)
+        return false;
+    const int align = FrameAllocator::DefaultAlignment;
+    const int h = qMax(surfaceHeight, d->height);
+    const int nb_planes = d->format.planeCount();
+    int bytes = 0;
+    for (int i = 0; i < nb_planes; ++i) {
+        if (d->line_sizes[i] <= 0)
+            d->line_sizes[i] = FFALIGN(d->format.bytesPerLine(d->width, i), align);
+        bytes += FFALIGN(d->line_sizes[i]*d->format.height(h, i), align);
+    }
+    uchar *p = d->allocateData(bytes, align, MemoryAccounting::VideoFrames);
+    if (!p)
+        return false;
+    for (int i = 0; i < nb_planes; ++i) {
+        d->planes[i] = p;
+        p += FFALIGN(d->line_sizes[i]*d->format.height(h, i), align);
+    }
+    return true;
+}
+
 VideoFormat VideoFrame::format() const
 {
     return d_func()->format;
@@ -392,13 +399,13 @@ VideoFrame VideoFrame::to(const VideoFormat &fmt, const QSize& dstSize, const QR
     conv.setInSize(width(), height());
     conv.setOutSize(w, h);
     conv.setInRange(colorRange());
-    if (!conv.convert(d->planes.constData(), d->line_sizes.constData())) {
+    VideoFrame f(w, h, fmt);
+    if (!f.allocate())
+        return VideoFrame();
+    if (!conv.convert(d->planes.constData(), d->line_sizes.constData(), f.d_ptr->planes.constData(), f.d_ptr->line_sizes.constData())) {
         qWarning() << "VideoFrame::to error: " << format() << "=>" << fmt;
         return VideoFrame();
     }
-    VideoFrame f(w, h, fmt, conv.outData(), ImageConverter::DataAlignment);
-    f.setBits(conv.outPlanes());
-    f.setBytesPerLine(conv.outLineSizes());
     if (fmt.isRGB()) {
         f.setColorSpace(fmt.isPlanar() ? ColorSpace_GBR : ColorSpace_RGB);
     } else {
@@ -459,6 +466,7 @@ void* VideoFrame::createInteropHandle(void* handle, SurfaceType type, int plane)
 
 VideoFrameConverter::VideoFrameConverter()
     : m_cvt(0)
+    , m_owner(0)
 {
     memset(m_eq, 0, sizeof(m_eq));
 }
@@ -481,60 +489,92 @@ void VideoFrameConverter::setEq(int brightness, int contrast, int saturation)
         m_eq[2] = saturation;
 }
 
-VideoFrame VideoFrameConverter::convert(const VideoFrame& frame, const VideoFormat &fmt) const
+void VideoFrameConverter::setMemoryOwner(const void *owner)
 {
-    return convert(frame, fmt.pixelFormatFFmpeg());
+    m_owner = owner;
 }
 
-VideoFrame VideoFrameConverter::convert(const VideoFrame &frame, VideoFormat::PixelFormat fmt) const
+VideoFrame VideoFrameConverter::convert(const VideoFrame& frame, const VideoFormat &fmt, const QSize &dstSize) const
 {
-    return convert(frame, VideoFormat::pixelFormatToFFmpeg(fmt));
+    return convert(frame, fmt.pixelFormatFFmpeg(), dstSize);
 }
 
-VideoFrame VideoFrameConverter::convert(const VideoFrame& frame, QImage::Format fmt) const
+VideoFrame VideoFrameConverter::convert(const VideoFrame &frame, VideoFormat::PixelFormat fmt, const QSize &dstSize) const
 {
-    return convert(frame, VideoFormat::pixelFormatFromImageFormat(fmt));
+    return convert(frame, VideoFormat::pixelFormatToFFmpeg(fmt), dstSize);
 }
 
-VideoFrame VideoFrameConverter::convert(const VideoFrame &frame, int fffmt) const
+VideoFrame VideoFrameConverter::convert(const VideoFrame& frame, QImage::Format fmt, const QSize &dstSize) const
 {
-    if (!frame.isValid() || fffmt == QTAV_PIX_FMT_C(NONE))
-        return VideoFrame();
-    if (!frame.constBits(0)) // hw surface
-        return frame.to(VideoFormat::pixelFormatFromFFmpeg(fffmt));
-    const VideoFormat format(frame.format());
-    //if (fffmt == format.pixelFormatFFmpeg())
-      //  return *this;
+    return convert(frame, VideoFormat::pixelFormatFromImageFormat(fmt), dstSize);
+}
+
+bool VideoFrameConverter::prepare(const VideoFrame &frame, int fffmt, const QSize &dstSize) const
+{
+    if (!frame.isValid() || !frame.constBits(0) || fffmt == QTAV_PIX_FMT_C(NONE))
+        return false;
     if (!m_cvt) {
         m_cvt = new ImageConverterSWS();
     }
     m_cvt->setBrightness(m_eq[0]);
     m_cvt->setContrast(m_eq[1]);
     m_cvt->setSaturation(m_eq[2]);
-    m_cvt->setInFormat(format.pixelFormatFFmpeg());
+    m_cvt->setInFormat(frame.format().pixelFormatFFmpeg());
     m_cvt->setOutFormat(fffmt);
     m_cvt->setInSize(frame.width(), frame.height());
-    m_cvt->setOutSize(frame.width(), frame.height());
+    m_cvt->setOutSize(dstSize.width() > 0 ? dstSize.width() : frame.width(), dstSize.height() > 0 ? dstSize.height() : frame.height());
     m_cvt->setInRange(frame.colorRange());
+    return true;
+}
+
+static void framePlanes(const VideoFrame& frame, QVector<const uchar*>& pitch, QVector<int>& stride, QByteArray& paldata)
+{
+    const VideoFormat format(frame.format());
     const int pal = format.hasPalette();
-    QVector<const uchar*> pitch(format.planeCount() + pal);
-    QVector<int> stride(format.planeCount() + pal);
+    pitch.resize(format.planeCount() + pal);
+    stride.resize(format.planeCount() + pal);
     for (int i = 0; i < format.planeCount(); ++i) {
         pitch[i] = frame.constBits(i);
         stride[i] = frame.bytesPerLine(i);
     }
-    const QByteArray paldata(frame.metaData(QStringLiteral("pallete")).toByteArray());
+    paldata = frame.metaData(QStringLiteral("pallete")).toByteArray();
     if (pal > 0) {
         pitch[1] = (const uchar*)paldata.constData();
         stride[1] = paldata.size();
     }
-    if (!m_cvt->convert(pitch.constData(), stride.constData())) {
+}
+
+VideoFrame VideoFrameConverter::convert(const VideoFrame &frame, int fffmt, const QSize &dstSize) const
+{
+    if (!frame.isValid() || fffmt == QTAV_PIX_FMT_C(NONE))
+        return VideoFrame();
+    if (!frame.constBits(0)) // hw surface
+        return frame.to(VideoFormat::pixelFormatFromFFmpeg(fffmt), dstSize);
+    //if (fffmt == format.pixelFormatFFmpeg())
+      //  return *this;
+    if (!prepare(frame, fffmt, dstSize))
+        return VideoFrame();
+    QVector<const uchar*> pitch;
+    QVector<int> stride;
+    QByteArray paldata;
+    framePlanes(frame, pitch, stride, paldata);
+    const int w = dstSize.width() > 0 ? dstSize.width() : frame.width();
+    const int h = dstSize.height() > 0 ? dstSize.height() : frame.height();
+    const VideoFormat fmt(fffmt);
+    // a new buffer for each frame. the converter's buffer is overwritten by the next conversion while the frame can still be in use
+    VideoFrame f(w, h, fmt);
+    f.setMemoryOwner(m_owner);
+    if (!f.allocate())
+        return VideoFrame();
+    QVector<quint8*> dst(fmt.planeCount());
+    QVector<int> dst_stride(fmt.planeCount());
+    for (int i = 0; i < dst.size(); ++i) {
+        dst[i] = f.bits(i);
+        dst_stride[i] = f.bytesPerLine(i);
+    }
+    if (!m_cvt->convert(pitch.constData(), stride.constData(), dst.constData(), dst_stride.constData())) {
         return VideoFrame();
     }
-    const VideoFormat fmt(fffmt);
-    VideoFrame f(frame.width(), frame.height(), fmt, m_cvt->outData());
-    f.setBits(m_cvt->outPlanes());
-    f.setBytesPerLine(m_cvt->outLineSizes());
     f.setTimestamp(frame.timestamp());
     f.setDisplayAspectRatio(frame.displayAspectRatio());
     // metadata?
@@ -547,4 +587,15 @@ VideoFrame VideoFrameConverter::convert(const VideoFrame &frame, int fffmt) cons
     return f;
 }
 
+bool VideoFrameConverter::convert(const VideoFrame &frame, const VideoFormat &fmt, quint8 *const dst[], const int dstStride[], const QSize &dstSize) const
+{
+    if (!prepare(frame, fmt.pixelFormatFFmpeg(), dstSize))
+        return false;
+    QVector<const uchar*> pitch;
+    QVector<int> stride;
+    QByteArray paldata;
+    framePlanes(frame, pitch, stride, paldata);
+    return m_cvt->convert(pitch.constData(), stride.constData(), dst, dstStride);
+}
+
 } //namespace QtAV
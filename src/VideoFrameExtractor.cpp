@@ -32,6 +32,7 @@
 #include "QtAV/VideoDecoder.h"
 #include "QtAV/AVDemuxer.h"
 #include "QtAV/Packet.h"
+#include "QtAV/private/AVCompat.h"
 #include "utils/BlockingQueue.h"
 #include "utils/Logger.h"
 
@@ -128,6 +129,7 @@ public:
         , position(-2*kDefaultPrecision)
         , precision(kDefaultPrecision)
         , decoder(0)
+        , lowres(0)
     {
         QVariantHash opt;
         opt[QString::fromLatin1("skip_frame")] = 8; // 8 for "avcodec", "NoRef" for "FFmpeg". see AVDiscard
@@ -166,6 +168,7 @@ public:
             return true;
         seek_count = 0;
         decoder.reset(0);
+        lowres = 0;
         if (!loaded || demuxer.atEnd()) {
             demuxer.unload();
             demuxer.setMedia(source);
@@ -194,6 +197,7 @@ public:
             decoder.reset(vd);
             AVCodecContext *cctx = demuxer.videoCodecContext();
             if (cctx) decoder->setCodecContext(demuxer.videoCodecContext());
+            setDecodeLevel(0);
             if (!cctx || !decoder->open()) {
                 decoder.reset(0);
                 continue;
@@ -208,6 +212,61 @@ public:
         return !!decoder;
     }
 
+    /*!
+     * \brief decodeLevel
+     * 1: target size is at most 1/2 of video size, 2: at most 1/4. 0 otherwise
+     */
+    int decodeLevel() {
+        QMutexLocker lock(&target_mutex);
+        Q_UNUSED(lock);
+        const AVCodecContext *cctx = demuxer.videoCodecContext();
+        if (!cctx || target_size.isEmpty() || cctx->width <= 0 || cctx->height <= 0)
+            return 0;
+        const qreal f = qMin(qreal(cctx->width)/qreal(target_size.width()), qreal(cctx->height)/qreal(target_size.height()));
+        return f >= 4.0 ? 2 : f >= 2.0 ? 1 : 0;
+    }
+    /*!
+     * \brief setDecodeLevel
+     * Use lowres if the codec supports it, otherwise skip the loop filter (and idct of non-reference frames for level 2).
+     * The decoder must be closed if lowres changes.
+     */
+    void setDecodeLevel(int level) {
+        const AVCodecContext *cctx = demuxer.videoCodecContext();
+        const AVCodec *codec = cctx ? avcodec_find_decoder(cctx->codec_id) : 0;
+        lowres = codec ? qMin<int>(level, codec->max_lowres) : 0;
+        const int rest = level - lowres;
+        QVariantHash *dicts[] = { &dec_opt_normal, &dec_opt_framedrop };
+        for (int i = 0; i < 2; ++i) {
+            QVariantHash opt(dicts[i]->value(QString::fromLatin1("avcodec")).toHash());
+            opt[QString::fromLatin1("lowres")] = lowres;
+            // 48: AVDISCARD_ALL. framedrop skips the loop filter of non-ref frames(8) already
+            opt[QString::fromLatin1("skip_loop_filter")] = rest > 0 ? 48 : (dicts[i] == &dec_opt_framedrop ? 8 : 0);
+            opt[QString::fromLatin1("skip_idct")] = rest > 1 ? 8 : 0;
+            (*dicts[i])[QString::fromLatin1("avcodec")] = opt;
+        }
+        decoder->setOptions(dec_opt_normal);
+    }
+    // lowres is used when the decoder opens, so only the decoder is reopened if it changes. the demuxer is not touched
+    // return false if the decoder can not be opened even without lowres
+    bool adaptDecoder() {
+        const int level = decodeLevel();
+        const int lowres_old = lowres;
+        setDecodeLevel(level);
+        if (lowres == lowres_old && decoder->isOpen()) // not open if failed last time
+            return true;
+        qDebug("VideoFrameExtractor: reopen decoder with lowres %d", lowres);
+        decoder->setCodecContext(demuxer.videoCodecContext());
+        if (decoder->open())
+            return true;
+        qWarning("VideoFrameExtractor: failed to reopen decoder with lowres %d", lowres);
+        setDecodeLevel(0);
+        decoder->setCodecContext(demuxer.videoCodecContext());
+        if (decoder->open())
+            return true;
+        qWarning("VideoFrameExtractor: failed to reopen decoder");
+        return false;
+    }
+
     // return the key frame position
     bool extractInPrecision(qint64 value, int range, QString & err, bool & aborted) {
         abort_seek = false;
@@ -263,6 +322,11 @@ public:
             err = QString().sprintf("failed to get a packet at %lld",value);
             return false;
         }
+        // decoding restarts from a key frame, so lowres can change here
+        if (!adaptDecoder()) {
+            err = "failed to reopen decoder";
+            return false;
+        }
         decoder->flush(); //must flush otherwise old frames will be decoded at the beginning
         decoder->setOptions(dec_opt_normal);
         // must decode key frame
@@ -395,17 +459,17 @@ public:
     VideoFrame frame; ///< important: we only allow the extract thread to modify this value
     QStringList codecs;
     ExtractThread thread;
-    static QVariantHash dec_opt_framedrop, dec_opt_normal;
+    // per extractor because lowres and skip options depend on the target size
+    QVariantHash dec_opt_framedrop, dec_opt_normal;
+    int lowres; // lowres of the open decoder. only used in extractor thread
+    QMutex target_mutex;
+    QSize target_size; ///< written by this->thread(), read by extractor thread
 };
 
-QVariantHash VideoFrameExtractorPrivate::dec_opt_framedrop;
-QVariantHash VideoFrameExtractorPrivate::dec_opt_normal;
-
 VideoFrameExtractor::VideoFrameExtractor(QObject *parent) :
     QObject(parent)
 {
-    DPTR_D(VideoFrameExtractor);
-    d.thread.start();
+    // the extract thread is started by the first async extract()
 }
 
 void VideoFrameExtractor::setSource(const QString url)
@@ -416,7 +480,11 @@ void VideoFrameExtractor::setSource(const QString url)
     d.source = url;
     d.has_video = true;
     Q_EMIT sourceChanged();
-    d.safeReleaseResource();
+    // resources are only used in the extract thread if it is running, otherwise in this thread
+    if (d.thread.isRunning())
+        d.safeReleaseResource();
+    else
+        d.releaseResourceInternal();
 }
 
 QString VideoFrameExtractor::source() const
@@ -491,6 +559,27 @@ int VideoFrameExtractor::precision() const
     return d_func().precision;
 }
 
+void VideoFrameExtractor::setTargetSize(const QSize &value)
+{
+    DPTR_D(VideoFrameExtractor);
+    {
+        QMutexLocker lock(&d.target_mutex);
+        Q_UNUSED(lock);
+        if (d.target_size == value)
+            return;
+        d.target_size = value;
+    }
+    Q_EMIT targetSizeChanged();
+}
+
+QSize VideoFrameExtractor::targetSize() const
+{
+    DPTR_D(const VideoFrameExtractor);
+    QMutexLocker lock(&const_cast<VideoFrameExtractorPrivate&>(d).target_mutex);
+    Q_UNUSED(lock);
+    return d.target_size;
+}
+
 void VideoFrameExtractor::extract()
 {
     DPTR_D(VideoFrameExtractor);
@@ -518,6 +607,8 @@ void VideoFrameExtractor::extract()
     // (called by extractInternal()) and if true, method returns early.
     // Note if seek/decode is aborted, aborted() signal will be emitted.
     d.abort_seek = true;
+    if (!d.thread.isRunning())
+        d.thread.start();
     d.thread.addTask(new ExtractTask(this, position()));
 }
 
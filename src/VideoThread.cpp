@@ -27,11 +27,14 @@
 #include "QtAV/VideoDecoder.h"
 #include "QtAV/VideoRenderer.h"
 #include "QtAV/Statistics.h"
+#include "QtAV/MemoryAccounting.h"
 #include "QtAV/Filter.h"
 #include "QtAV/FilterContext.h"
 #include "output/OutputSet.h"
 #include "QtAV/private/AVCompat.h"
+#include "ColorTransform.h"
 #include <QtCore/QFileInfo>
+#include "utils/ColorAdjust.h"
 #include "utils/Logger.h"
 
 namespace QtAV {
@@ -46,6 +49,7 @@ public:
       , capture(0)
       , filter_context(0)
     {
+        eq[0] = eq[1] = eq[2] = eq[3] = 0;
     }
     ~VideoThreadPrivate() {
         //not neccesary context is managed by filters.
@@ -64,6 +68,9 @@ public:
     VideoCapture *capture;
     VideoFilterContext *filter_context;//TODO: use own smart ptr. QSharedPointer "=" is ugly
     VideoFrame displayed_frame;
+    // brightness, contrast, saturation, hue. [-100, 100]. applied by colorAdjust() if supported, otherwise by the converter
+    int eq[4];
+    ColorTransform eq_transform;
 };
 
 VideoThread::VideoThread(QObject *parent) :
@@ -153,30 +160,45 @@ void VideoThread::setSaturation(int val)
     setEQ(101, 101, val);
 }
 
-void VideoThread::setEQ(int b, int c, int s)
+void VideoThread::setHue(int val)
+{
+    setEQ(101, 101, 101, val);
+}
+
+void VideoThread::setEQ(int b, int c, int s, int h)
 {
     class EQTask : public QRunnable {
     public:
-        EQTask(VideoFrameConverter *c)
+        EQTask(VideoThreadPrivate *d)
             : brightness(0)
             , contrast(0)
             , saturation(0)
-            , conv(c)
+            , hue(0)
+            , d(d)
         {
             //qDebug("EQTask tid=%p", QThread::currentThread());
         }
         void run() {
-            conv->setEq(brightness, contrast, saturation);
+            const int v[] = { brightness, contrast, saturation, hue };
+            for (int i = 0; i < 4; ++i) {
+                if (v[i] >= -100 && v[i] <= 100)
+                    d->eq[i] = v[i];
+            }
+            d->eq_transform.setBrightness(qreal(d->eq[0])/100.0);
+            d->eq_transform.setContrast(qreal(d->eq[1])/100.0);
+            d->eq_transform.setSaturation(qreal(d->eq[2])/100.0);
+            d->eq_transform.setHue(qreal(d->eq[3])/100.0);
         }
-        int brightness, contrast, saturation;
+        int brightness, contrast, saturation, hue;
     private:
-        VideoFrameConverter *conv;
+        VideoThreadPrivate *d;
     };
     DPTR_D(VideoThread);
-    EQTask *task = new EQTask(&d.conv);
+    EQTask *task = new EQTask(&d);
     task->brightness = b;
     task->contrast = c;
     task->saturation = s;
+    task->hue = h;
     if (isRunning()) {
         scheduleTask(task);
     } else {
@@ -215,6 +237,7 @@ bool VideoThread::deliverVideoFrame(VideoFrame &frame)
     VideoRenderer *vo = 0;
     if (!outputs.isEmpty())
         vo = static_cast<VideoRenderer*>(outputs.first());
+    bool converted = false;
     if (vo && (!vo->isSupported(frame.pixelFormat())
             || (vo->isPreferredPixelFormatForced() && vo->preferredPixelFormat() != frame.pixelFormat())
             )) {
@@ -223,15 +246,65 @@ bool VideoThread::deliverVideoFrame(VideoFrame &frame)
             fmt = VideoFormat::Format_RGB32;
         else
             fmt = vo->preferredPixelFormat();
+        const qint64 t_conv = Statistics::Pipeline::now();
+        // the converter applies the eq only if colorAdjust() can not, e.g. hue is not supported by the converter
+        if (colorAdjustSupported(fmt))
+            d.conv.setEq(0, 0, 0);
+        else
+            d.conv.setEq(d.eq[0], d.eq[1], d.eq[2]);
+        d.conv.setMemoryOwner(d.packets.owner()); // the player
         VideoFrame outFrame(d.conv.convert(frame, fmt));
+        if (d.statistics)
+            d.statistics->pipeline.record(Statistics::Pipeline::VideoConvert, t_conv);
         if (!outFrame.isValid()) {
             d.outputSet->unlock();
             return false;
         }
         frame = outFrame;
+        converted = true;
+    }
+    // gl renderers apply the eq while drawing, see VideoRenderer::setBrightness() etc.
+    bool gl_outputs = !outputs.isEmpty();
+    foreach (AVOutput *output, outputs) {
+        if (!static_cast<VideoRenderer*>(output)->opengl()) {
+            gl_outputs = false;
+            break;
+        }
+    }
+    if ((d.eq[0] || d.eq[1] || d.eq[2] || d.eq[3]) && !gl_outputs && frame.constBits(0) && colorAdjustSupported(frame.format())) {
+        const qint64 t_eq = Statistics::Pipeline::now();
+        const VideoFormat fmt(frame.format());
+        const ColorSpace cs = fmt.isRGB() ? ColorSpace_RGB : (frame.colorSpace() == ColorSpace_BT709 ? ColorSpace_BT709 : ColorSpace_BT601);
+        d.eq_transform.setInputColorSpace(cs);
+        d.eq_transform.setOutputColorSpace(cs);
+        d.eq_transform.setInputColorRange(ColorRange_Full); // components are adjusted in their own range
+        d.eq_transform.setOutputColorRange(ColorRange_Full);
+        if (converted || frame.isDataWritable()) { // our own buffer. decoded frames may be referenced by the decoder
+            colorAdjust(frame, frame, d.eq_transform.matrixRef());
+        } else {
+            // data is from FrameAllocator::current(), i.e. a reused buffer of FramePool by default
+            VideoFrame adjusted(frame.width(), frame.height(), fmt);
+            adjusted.setMemoryOwner(d.packets.owner());
+            if (adjusted.allocate() && colorAdjust(frame, adjusted, d.eq_transform.matrixRef())) {
+                adjusted.setTimestamp(frame.timestamp());
+                adjusted.setDisplayAspectRatio(frame.displayAspectRatio());
+                adjusted.setColorSpace(frame.colorSpace());
+                adjusted.setColorRange(frame.colorRange());
+                frame = adjusted;
+            }
+        }
+        if (d.statistics)
+            d.statistics->pipeline.record(Statistics::Pipeline::VideoConvert, t_eq);
     }
+    const qint64 t_present = Statistics::Pipeline::now();
     d.outputSet->sendVideoFrame(frame); //TODO: group by format, convert group by group
     d.outputSet->unlock();
+    if (d.statistics) {
+        d.statistics->pipeline.record(Statistics::Pipeline::VideoPresent, t_present);
+        Statistics::LoadOnly &lo = d.statistics->load_only;
+        if (lo.first_frame_time < 0 && lo.start > 0)
+            lo.first_frame_time = (Statistics::Pipeline::now() - lo.start)/1000LL;
+    }
 
     Q_EMIT frameDelivered();
     return true;
@@ -308,7 +381,11 @@ void VideoThread::run()
             }
         }
         if(!pkt.isValid() && !pkt.isEOF()) { // can't seek back if eof packet is read
+            const qint64 t_wait = Statistics::Pipeline::now();
             pkt = d.packets.take(); //wait to dequeue
+            d.statistics->pipeline.record(Statistics::Pipeline::VideoQueueWait, t_wait);
+            d.statistics->video.buffered_bytes = d.packets.bufferedBytes();
+            d.statistics->video.buffered_time = d.packets.bufferedTime();
            // TODO: push pts history here and reorder
         }
         if (pkt.isEOF()) {
@@ -434,6 +511,11 @@ void VideoThread::run()
                 skip_render = false;
             }
         }
+        // frames are not released fast enough by renderers and filters. drop non-key frames until memory is back under budget
+        if (!skip_render && !seeking && !pkt.hasKeyFrame && MemoryAccounting::isOverBudget(MemoryAccounting::VideoFrames))
+            skip_render = true;
+        if (!seeking && diff < -kSyncThreshold)
+            d.statistics->pipeline.videoFrameLate();
         //audio packet not cleaned up?
         if (diff > 0 && diff < 1.0 && !seeking) {
             // can not change d.delay here! we need it to comapre to next loop
@@ -486,6 +568,7 @@ void VideoThread::run()
         }
         if (dec_opt != dec_opt_old)
             dec->setOptions(*dec_opt);
+        const qint64 t_dec = Statistics::Pipeline::now();
         if (!dec->decode(pkt)) {
             d.pts_history.push_back(d.pts_history.back());
             //qWarning("Decode video failed. undecoded: %d/%d", dec->undecodedSize(), pkt.data.size());
@@ -512,6 +595,8 @@ void VideoThread::run()
         if (!pkt.isEOF())
             pkt.skip(pkt.data.size() - dec->undecodedSize());
         VideoFrame frame = dec->frame();
+        frame.setMemoryOwner(d.packets.owner()); // e.g. copied from hw decoder
+        d.statistics->pipeline.record(Statistics::Pipeline::VideoDecode, t_dec);
         if (!frame.isValid()) {
             qWarning("invalid video frame from decoder. undecoded data size: %d", pkt.data.size());
             if (pkt_data == pkt.data.constData()) //FIXME: for libav9. what about other versions?
@@ -545,13 +630,16 @@ void VideoThread::run()
         }
         if (skip_render) {
             qDebug("skip rendering @%.3f", pts);
+            d.statistics->pipeline.videoFrameDropped();
             pkt = Packet();
             v_a = 0;
             continue;
         }
         Q_ASSERT(d.statistics);
         d.statistics->video.current_time = QTime(0, 0, 0).addMSecs(int(pts * 1000.0)); //TODO: is it expensive?
+        const qint64 t_filter = Statistics::Pipeline::now();
         applyFilters(frame);
+        d.statistics->pipeline.record(Statistics::Pipeline::VideoFilter, t_filter);
 
         //while can pause, processNextTask, not call outset.puase which is deperecated
         while (d.outputSet->canPauseThread()) {
@@ -45,7 +45,9 @@ public:
     void setBrightness(int val);
     void setContrast(int val);
     void setSaturation(int val);
-    void setEQ(int b, int c, int s);
+    void setHue(int val);
+    // [-100, 100]. other values are ignored
+    void setEQ(int b, int c, int s, int h = 101);
 
 public Q_SLOTS:
     void addCaptureTask();
@@ -434,23 +434,9 @@ VideoFrame VideoDecoderCedarv::frame()
     const int display_h_align = FFALIGN(d.cedarPicture.display_height, 2); // already aligned to 8!
     const int display_w_align = FFALIGN(d.cedarPicture.display_width, 16);
     const int dst_y_stride = display_w_align;
-    const int dst_y_size = dst_y_stride * display_h_align;
     const int dst_c_stride = FFALIGN(d.cedarPicture.display_width/2, 16);
-    const int dst_c_size = dst_c_stride * (display_h_align/2);
-    const int alloc_size = dst_y_size + dst_c_size * 2;
-    const unsigned int offset_y = 0;
-    const unsigned int offset_u = offset_y + dst_y_size;
-    const unsigned int offset_v = offset_u + dst_c_size;
 
     const bool nv12 = outputPixelFormat() == NV12;
-    QByteArray buf(alloc_size, 0);
-    buf.reserve(alloc_size);
-    quint8 *dst = reinterpret_cast<quint8*>(buf.data());
-    quint8 *plane[] = {
-        dst + offset_y,
-        dst + offset_u,
-        dst + offset_v
-    };
     int pitch[] = {
         dst_y_stride,
         dst_c_stride,
@@ -458,17 +444,20 @@ VideoFrame VideoDecoderCedarv::frame()
     };
     if (nv12)
         pitch[1] = dst_y_stride;
-
-    d.map_y(d.cedarPicture.y, plane[0], display_w_align, pitch[0], display_h_align);
+    const VideoFormat fmt(nv12 ? VideoFormat::Format_NV12 : VideoFormat::Format_YUV420P);
+    VideoFrame frame(display_w_align, display_h_align, fmt);
+    frame.setBytesPerLine(pitch);
+    if (!frame.allocate()) {
+        d.cedarv->display_release(d.cedarv, d.cedarPicture.id);
+        d.cedarPicture.id = 0;
+        return VideoFrame();
+    }
+    d.map_y(d.cedarPicture.y, frame.bits(0), display_w_align, pitch[0], display_h_align);
     if (nv12)
-        d.map_y(d.cedarPicture.u, plane[1], pitch[1], display_w_align, display_h_align/2);
+        d.map_y(d.cedarPicture.u, frame.bits(1), pitch[1], display_w_align, display_h_align/2);
     else
-        d.map_c(d.cedarPicture.u, plane[1], plane[2], pitch[1], display_w_align, display_h_align/2); //vdpau use w, h/2
+        d.map_c(d.cedarPicture.u, frame.bits(1), frame.bits(2), pitch[1], display_w_align, display_h_align/2); //vdpau use w, h/2
 
-    const VideoFormat fmt(nv12 ? VideoFormat::Format_NV12 : VideoFormat::Format_YUV420P);
-    VideoFrame frame(display_w_align, display_h_align, fmt, buf);
-    frame.setBits(plane);
-    frame.setBytesPerLine(pitch);
     frame.setTimestamp(qreal(d.cedarPicture.pts)/1000.0);
     d.cedarv->display_release(d.cedarv, d.cedarPicture.id);
     d.cedarPicture.id = 0;
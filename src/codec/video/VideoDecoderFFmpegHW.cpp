@@ -300,26 +300,14 @@ VideoFrame VideoDecoderFFmpegHW::copyToFrame(const VideoFormat& fmt, int surface
     }
     VideoFrame frame;
     if (copyMode() == VideoDecoderFFmpegHW::OptimizedCopy && d.gpu_mem.isReady()) {
-        int yuv_size = 0;
-        for (int i = 0; i < nb_planes; ++i) {
-            yuv_size += pitch[i]*h[i];
-        }
-        // additional 15 bytes to ensure 16 bytes aligned
-        QByteArray buf(15 + yuv_size, 0);
-        const int offset_16 = (16 - ((uintptr_t)buf.data() & 0x0f)) & 0x0f;
-        // plane 1, 2... is aligned?
-        uchar* plane_ptr = (uchar*)buf.data() + offset_16;
-        QVector<uchar*> dst(nb_planes, 0);
+        frame = VideoFrame(d.width, d.height, fmt);
+        // pitch instead of surface_width
+        frame.setBytesPerLine(pitch);
+        if (!frame.allocate(surface_h))
+            return VideoFrame();
         for (int i = 0; i < nb_planes; ++i) {
-            dst[i] = plane_ptr;
-            // TODO: add VideoFormat::planeWidth/Height() ?
-            // pitch instead of surface_width
-            plane_ptr += pitch[i] * h[i];
-            d.gpu_mem.copyFrame(src[i], dst[i], pitch[i], h[i], pitch[i]);
+            d.gpu_mem.copyFrame(src[i], frame.bits(i), pitch[i], h[i], pitch[i]);
         }
-        frame = VideoFrame(d.width, d.height, fmt, buf);
-        frame.setBits(dst);
-        frame.setBytesPerLine(pitch);
     } else {
         frame = VideoFrame(d.width, d.height, fmt);
         frame.setBits(src);
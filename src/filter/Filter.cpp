@@ -24,6 +24,7 @@
 #include "QtAV/Statistics.h"
 #include "QtAV/AVOutput.h"
 #include "QtAV/AVPlayer.h"
+#include "QtAV/VideoFrame.h"
 #include "filter/FilterManager.h"
 #include "utils/Logger.h"
 
@@ -124,6 +125,12 @@ bool VideoFilter::isSupported(VideoFilterContext::Type ct) const
     return VideoFilterContext::None == ct;
 }
 
+bool VideoFilter::canProcessFrame(const VideoFrame &frame) const
+{
+    Q_UNUSED(frame);
+    return false;
+}
+
 bool VideoFilter::installTo(AVPlayer *player)
 {
     return player->installFilter(this);
@@ -144,6 +151,7 @@ bool VideoFilter::installTo(AVOutput *output)
 bool VideoFilter::prepareContext(VideoFilterContext *&ctx, Statistics *statistics, VideoFrame *frame)
 {
     DPTR_D(VideoFilter);
+    d.frame_target = !!frame;
     if (!ctx || !isSupported(ctx->type())) {
         //qDebug("no context: %p, or context type %d is not supported", ctx, ctx? ctx->type() : 0);
         return isSupported(VideoFilterContext::None);
@@ -169,6 +177,8 @@ bool VideoFilter::prepareContext(VideoFilterContext *&ctx, Statistics *statistic
     d.context->video_height = statistics->video_only.height;
     ctx->video_width = statistics->video_only.width;
     ctx->video_height = statistics->video_only.height;
+    if (frame && frame->isValid() && canProcessFrame(*frame))
+        return true;
 
     // share common data
     d.context->shareFrom(ctx);
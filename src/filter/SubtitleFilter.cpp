@@ -22,9 +22,12 @@
 #include "QtAV/SubtitleFilter.h"
 #include "QtAV/private/Filter_p.h"
 #include "QtAV/private/PlayerSubtitle.h"
+#include "QtAV/private/SubImageBlend.h"
 #include "QtAV/Subtitle.h"
 #include "QtAV/VideoFrame.h"
 #include <QtCore/QScopedPointer>
+#include <QtGui/QFontMetrics>
+#include <QtGui/QPainter>
 #include "utils/Logger.h"
 
 namespace QtAV {
@@ -36,6 +39,7 @@ public:
         : player_sub(new PlayerSubtitle(0))
         , rect(0.0, 0.0, 1.0, 0.9)
         , color(Qt::white)
+        , image_key(0)
     {
         font.setPointSize(22);
     }
@@ -68,11 +72,89 @@ public:
         }
         return r;
     }
+    /*!
+     * \brief burnYUV
+     * Draw subtitle on yuv frame data without converting the whole frame to rgb. Only the subtitle area is touched.
+     * Plain text is rendered once to an image of the text bounding rect. Images are converted to yuv once until changed.
+     */
+    void burnYUV(VideoFrame *frame) {
+        Subtitle *sub = player_sub->subtitle();
+        const int w = frame->width();
+        const int h = frame->height();
+        if (sub->canRender()) {
+            const SubImageSet set(sub->getSubImages(w, h));
+            if (set.images.isEmpty())
+                return;
+            if (set.format() == SubImageSet::ASS) {
+                detach(frame);
+                blendSubImagesYUV(frame, set);
+                return;
+            }
+            QRect r;
+            const QImage img(sub->getImage(w, h, &r));
+            if (img.isNull())
+                return;
+            const bool changed = img.cacheKey() != image_key;
+            image_key = img.cacheKey();
+            if (!convertImageYUV(*frame, img, changed, &image_yuv))
+                return;
+            detach(frame);
+            blendImageYUV(frame, image_yuv, r.topLeft());
+            return;
+        }
+        const QString text(sub->getText());
+        if (text.isEmpty())
+            return;
+        const QRect r(realRect(w, h));
+        const bool changed = text != text_cache || r != text_rect || font != text_font || color != text_color;
+        if (changed) {
+            text_cache = text;
+            text_rect = r;
+            text_font = font;
+            text_color = color;
+            const int flags = Qt::AlignHCenter | Qt::AlignBottom;
+            QImage device(1, 1, QImage::Format_ARGB32_Premultiplied); // metrics on the same kind of device as QPainterFilterContext
+            QRect br = QFontMetrics(font, &device).boundingRect(r, flags, text);
+            br = br.adjusted(-2, -2, 2, 2) & QRect(0, 0, w, h); // antialiasing may exceed the bounding rect
+            text_image = QImage(br.size(), QImage::Format_ARGB32_Premultiplied);
+            text_image.fill(0);
+            text_pos = br.topLeft();
+            if (!text_image.isNull()) {
+                QPainter p(&text_image);
+                p.setFont(font);
+                p.setPen(color);
+                p.translate(-br.topLeft());
+                p.drawText(r, flags, text);
+            }
+        }
+        if (text_image.isNull())
+            return;
+        if (!convertImageYUV(*frame, text_image, changed, &text_yuv))
+            return;
+        detach(frame);
+        blendImageYUV(frame, text_yuv, text_pos);
+    }
+    // decoded frames may reference decoder buffers used to decode other frames
+    static void detach(VideoFrame *frame) {
+        if (frame->data().isEmpty())
+            *frame = frame->clone();
+    }
 
     QScopedPointer<PlayerSubtitle> player_sub;
     QRectF rect;
     QFont font;
     QColor color;
+    // rendered plain text for yuv frames
+    QString text_cache;
+    QRect text_rect;
+    QFont text_font;
+    QColor text_color;
+    QImage text_image;
+    QPoint text_pos;
+    YUVImage text_yuv; // text_image in yuv
+    // image from subtitle processor in yuv
+    qint64 image_key;
+    YUVImage image_yuv;
 };
 
 SubtitleFilter::SubtitleFilter(QObject *parent) :
@@ -165,11 +247,23 @@ QString SubtitleFilter::subtitleText(qreal t) const
     return d.player_sub->subtitle()->getText();
 }
 
+bool SubtitleFilter::canProcessFrame(const VideoFrame &frame) const
+{
+    return frame.constBits(0) && canBlendYUV(frame.format()); // not hw frames
+}
+
 void SubtitleFilter::process(Statistics *statistics, VideoFrame *frame)
 {
     Q_UNUSED(statistics);
     Q_UNUSED(frame);
     DPTR_D(SubtitleFilter);
+    // renderer filters are applied on a frame already displayed, so only the player's frames are burned
+    if (d.frame_target && frame && frame->isValid() && canProcessFrame(*frame)) {
+        if (frame->timestamp() > 0.0)
+            d.player_sub->subtitle()->setTimestamp(frame->timestamp());
+        d.burnYUV(frame);
+        return;
+    }
     if (!context()->paint_device) {
         qWarning("no paint device!");
         return;
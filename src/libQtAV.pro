@@ -22,6 +22,7 @@ config_libcedarv: CONFIG *= neon config_simd #need by qt4 addSimdCompiler(). neo
 ## sse2 sse4_1 may be defined in Qt5 qmodule.pri but is not included. Qt4 defines sse and sse2
 sse4_1|config_sse4_1|contains(TARGET_ARCH_SUB, sse4.1): CONFIG *= sse4_1 config_simd
 sse2|config_sse2|contains(TARGET_ARCH_SUB, sse2): CONFIG *= sse2 config_simd
+avx2|config_avx2|contains(TARGET_ARCH_SUB, avx2): CONFIG *= avx2 config_simd
 CONFIG(debug, debug|release): DEFINES += DEBUG
 #release: DEFINES += QT_NO_DEBUG_OUTPUT
 #var with '_' can not pass to pri?
@@ -83,6 +84,11 @@ sse2 {
   !config_simd: CONFIG *= simd
   SSE2_SOURCES += utils/CopyFrame_SSE2.cpp
 }
+avx2 {
+  DEFINES += QTAV_HAVE_AVX2=1
+  !config_simd: CONFIG *= simd
+  AVX2_SOURCES += subtitle/BlendASS_AVX2.cpp
+}
 
 win32 {
 # cross build, old vc etc.
@@ -373,6 +379,8 @@ config_gl|config_opengl {
     opengl/OpenGLHelper.h \
     opengl/SubImagesGeometry.h \
     opengl/SubImagesRenderer.h \
+    opengl/PixelBufferRing.h \
+    opengl/TexturePool.h \
     opengl/ShaderManager.h
   SOURCES *= \
     filter/GLSLFilter.cpp \
@@ -386,13 +394,17 @@ config_gl|config_opengl {
     opengl/OpenGLVideo.cpp \
     opengl/VideoShaderObject.cpp \
     opengl/VideoShader.cpp \
+    opengl/PixelBufferRing.cpp \
+    opengl/TexturePool.cpp \
     opengl/ShaderManager.cpp \
     opengl/ConvolutionShader.cpp \
     opengl/OpenGLHelper.cpp
 }
 config_openglwindow {
-  SDK_HEADERS *= QtAV/OpenGLWindowRenderer.h
-  SOURCES *= output/video/OpenGLWindowRenderer.cpp
+  SDK_HEADERS *= QtAV/OpenGLWindowRenderer.h \
+                 QtAV/VideoCompositor.h
+  SOURCES *= output/video/OpenGLWindowRenderer.cpp \
+             output/video/VideoCompositor.cpp
 }
 config_libass {
 #link against libass instead of dynamic load
@@ -433,12 +445,17 @@ SOURCES += \
     AVCompat.cpp \
     QtAV_Global.cpp \
     subtitle/SubImage.cpp \
+    subtitle/BlendASS_SSE2.cpp \
+    subtitle/BlendASS_NEON.cpp \
+    subtitle/SubImageYUV.cpp \
     subtitle/CharsetDetector.cpp \
     subtitle/PlainText.cpp \
     subtitle/PlayerSubtitle.cpp \
     subtitle/Subtitle.cpp \
     subtitle/SubtitleProcessor.cpp \
     subtitle/SubtitleProcessorFFmpeg.cpp \
+    utils/ColorAdjust.cpp \
+    utils/FusedConvert.cpp \
     utils/GPUMemCopy.cpp \
     utils/Logger.cpp \
     AudioThread.cpp \
@@ -470,6 +487,8 @@ SOURCES += \
     ImageConverterFF.cpp \
     Packet.cpp \
     PacketBuffer.cpp \
+    MemoryAccounting.cpp \
+    FrameAllocator.cpp \
     AVError.cpp \
     AVPlayer.cpp \
     AVPlayerPrivate.cpp \
@@ -483,6 +502,7 @@ SOURCES += \
     output/audio/AudioOutput.cpp \
     output/audio/AudioOutputBackend.cpp \
     output/audio/AudioOutputNull.cpp \
+    output/audio/AudioOutputMixer.cpp \
     output/video/VideoRenderer.cpp \
     output/video/VideoOutput.cpp \
     output/video/QPainterRenderer.cpp \
@@ -496,7 +516,8 @@ SOURCES += \
     codec/video/VideoEncoder.cpp \
     codec/video/VideoEncoderFFmpeg.cpp \
     VideoThread.cpp \
-    VideoFrameExtractor.cpp
+    VideoFrameExtractor.cpp \
+    ThumbnailService.cpp
 
 SDK_HEADERS *= \
     QtAV/QtAV \
@@ -528,6 +549,8 @@ SDK_HEADERS *= \
     QtAV/VideoRenderer.h \
     QtAV/VideoOutput.h \
     QtAV/MediaIO.h \
+    QtAV/MemoryAccounting.h \
+    QtAV/FrameAllocator.h \
     QtAV/AVOutput.h \
     QtAV/AVClock.h \
     QtAV/VideoDecoder.h \
@@ -535,6 +558,7 @@ SDK_HEADERS *= \
     QtAV/VideoFormat.h \
     QtAV/VideoFrame.h \
     QtAV/VideoFrameExtractor.h \
+    QtAV/ThumbnailService.h \
     QtAV/FactoryDefine.h \
     QtAV/Statistics.h \
     QtAV/SubImage.h \
@@ -561,7 +585,9 @@ SDK_PRIVATE_HEADERS *= \
     QtAV/private/Frame_p.h \
     QtAV/private/VideoShader_p.h \
     QtAV/private/VideoRenderer_p.h \
-    QtAV/private/QPainterRenderer_p.h
+    QtAV/private/QPainterRenderer_p.h \
+    QtAV/private/SubImageBlend.h \
+    QtAV/private/FusedConvert.h
 
 # QtAV/private/* may be used by developers to extend QtAV features without changing QtAV library
 # headers not in QtAV/ and it's subdirs are used only by QtAV internally
@@ -577,6 +603,7 @@ HEADERS *= \
     VideoThread.h \
     ImageConverter.h \
     ImageConverter_p.h \
+    subtitle/BlendASS_p.h \
     codec/video/VideoDecoderFFmpegBase.h \
     codec/video/VideoDecoderFFmpegHW.h \
     codec/video/VideoDecoderFFmpegHW_p.h \
@@ -584,6 +611,7 @@ HEADERS *= \
     subtitle/CharsetDetector.h \
     subtitle/PlainText.h \
     utils/BlockingQueue.h \
+    utils/ColorAdjust.h \
     utils/GPUMemCopy.h \
     utils/Logger.h \
     utils/SharedPtr.h \
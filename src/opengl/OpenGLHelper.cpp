@@ -283,6 +283,42 @@ bool isPBOSupported() {
     return support;
 }
 
+bool hasUnpackRowLength()
+{
+    static int has_row_length = -1;
+    if (has_row_length >= 0)
+        return !!has_row_length;
+    const QOpenGLContext *ctx = QOpenGLContext::currentContext();
+    if (!ctx)
+        return false;
+    if (!isOpenGLES() || ctx->format().majorVersion() > 2) {
+        has_row_length = 1;
+        return true;
+    }
+    static const char* exts[] = { "GL_EXT_unpack_subimage", NULL };
+    has_row_length = hasExtension(exts);
+    return !!has_row_length;
+}
+
+bool hasFenceSync()
+{
+    static int has_sync = -1;
+    if (has_sync >= 0)
+        return !!has_sync;
+    const QOpenGLContext *ctx = QOpenGLContext::currentContext();
+    if (!ctx)
+        return false;
+    const int major = ctx->format().majorVersion();
+    if (isOpenGLES()) {
+        has_sync = major >= 3;
+    } else {
+        static const char* exts[] = { "GL_ARB_sync", NULL };
+        has_sync = major*10 + ctx->format().minorVersion() >= 32 || hasExtension(exts);
+    }
+    has_sync = has_sync && gl().FenceSync && gl().ClientWaitSync && gl().WaitSync && gl().DeleteSync;
+    return !!has_sync;
+}
+
 typedef struct {
     GLint internal_format;
     GLenum format;
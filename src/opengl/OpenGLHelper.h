@@ -94,6 +94,10 @@ bool useDeprecatedFormats();
  */
 bool hasExtension(const char* exts[]);
 bool isPBOSupported();
+/// GL_UNPACK_ROW_LENGTH is supported. desktop GL, ES3 or GL_EXT_unpack_subimage
+bool hasUnpackRowLength();
+/// glFenceSync() etc. are supported. GL3.2, GL_ARB_sync or ES3
+bool hasFenceSync();
 /*!
  * \brief videoFormatToGL
  * \param fmt
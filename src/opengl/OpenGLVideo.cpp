@@ -29,7 +29,9 @@
 #endif //5.0
 #include "QtAV/SurfaceInterop.h"
 #include "QtAV/VideoShader.h"
+#include "QtAV/private/VideoShader_p.h"
 #include "ShaderManager.h"
+#include "PixelBufferRing.h"
 #include "QtAV/GeometryRenderer.h"
 #include "opengl/OpenGLHelper.h"
 #include "utils/Logger.h"
@@ -56,10 +58,13 @@ public:
     {
     }
     ~OpenGLVideoPrivate() {
+        ring.destroy();
         if (material) {
             delete material;
             material = 0;
         }
+        ShaderManager::release(manager); // after material because material textures are in manager's pool
+        manager = 0;
         delete geometry;
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0) || !defined(Q_COMPILER_LAMBDA)
         delete gr;
@@ -67,18 +72,18 @@ public:
     }
 
     void resetGL() {
+        ring.destroy();
         ctx = 0;
         if (gr)
             gr->updateGeometry(NULL);
         if (!manager)
             return;
-        manager->setParent(0);
-        delete manager;
-        manager = 0;
         if (material) {
             delete material;
             material = 0;
         }
+        ShaderManager::release(manager);
+        manager = 0;
     }
     // update geometry(vertex array) set attributes or bind VAO/VBO.
     void updateGeometry(VideoShader* shader, const QRectF& t, const QRectF& r);
@@ -98,6 +103,7 @@ public:
     OpenGLVideo::MeshType mesh_type;
     TexturedGeometry *geometry;
     GeometryRenderer* gr;
+    PixelBufferRing ring;
     QRectF rect;
     QMatrix4x4 matrix;
     VideoShader *user_shader;
@@ -199,6 +205,10 @@ void OpenGLVideo::setOpenGLContext(QOpenGLContext *ctx)
         delete d.material;
         d.material = 0;
     }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    if (d.ctx)
+        QObject::disconnect(d.ctx, SIGNAL(aboutToBeDestroyed()), this, SLOT(resetGL()));
+#endif
     d.resetGL(); //TODO: is it ok to destroygl resources in another context?
     d.ctx = ctx; // Qt4: set to null in resetGL()
     if (!ctx) {
@@ -209,20 +219,11 @@ void OpenGLVideo::setOpenGLContext(QOpenGLContext *ctx)
     d.material->setContrast(c);
     d.material->setHue(h);
     d.material->setSaturation(s);
+    d.manager = ShaderManager::acquire(ctx);
+    d.material->d_func().tex_pool = d.manager->texturePool();
 #if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
-    d.manager = ctx->findChild<ShaderManager*>(QStringLiteral("__qtav_shader_manager"));
-#endif
-    updateViewport();
-    if (d.manager)
-        return;
-    // TODO: what if ctx is delete?
-#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
-    d.manager = new ShaderManager(ctx);
     QObject::connect(ctx, SIGNAL(aboutToBeDestroyed()), this, SLOT(resetGL()), Qt::DirectConnection); // direct to make sure there is a valid context. makeCurrent in window.aboutToBeDestroyed()?
-#else
-    d.manager = new ShaderManager(this);
 #endif
-    d.manager->setObjectName(QStringLiteral("__qtav_shader_manager"));
     /// get gl info here because context is current(qt ensure it)
     //const QByteArray extensions(reinterpret_cast<const char *>(glGetString(GL_EXTENSIONS)));
     bool hasGLSL = QOpenGLShaderProgram::hasOpenGLShaderPrograms();
@@ -256,10 +257,24 @@ QOpenGLContext* OpenGLVideo::openGLContext()
     return d_func().ctx;
 }
 
+void OpenGLVideo::prepareFrame(const VideoFrame &frame)
+{
+    d_func().ring.write(frame);
+}
+
 void OpenGLVideo::setCurrentFrame(const VideoFrame &frame)
 {
-    d_func().material->setCurrentFrame(frame);
-    d_func().has_a = frame.format().hasAlpha();
+    DPTR_D(OpenGLVideo);
+    d.material->setCurrentFrame(frame);
+    d.has_a = frame.format().hasAlpha();
+    VideoMaterialPrivate &md = d.material->d_func();
+    md.ring = 0;
+    md.ring_slot = -1;
+    if (!d.ring.ensure(frame))
+        return;
+    d.ring.reclaim();
+    md.ring = &d.ring;
+    md.ring_slot = d.ring.take(frame);
 }
 
 void OpenGLVideo::setProjectionMatrixToRect(const QRectF &v)
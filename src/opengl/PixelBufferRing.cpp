@@ -0,0 +1,282 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#include "PixelBufferRing.h"
+#include <string.h>
+#include <QtCore/QThread>
+#include "QtAV/VideoFrame.h"
+#include "opengl/OpenGLHelper.h"
+#include "utils/Logger.h"
+
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_ALREADY_SIGNALED
+#define GL_ALREADY_SIGNALED 0x911A
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED 0x911B
+#endif
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+
+namespace QtAV {
+// offsets of planes in a slot. >= GL_UNPACK_ALIGNMENT and friendly to memcpy
+static const int kPlaneAlign = 64;
+
+static inline int alignUp(int v)
+{
+    return (v + kPlaneAlign - 1) & ~(kPlaneAlign - 1);
+}
+
+static inline int loadState(QAtomicInt &a)
+{
+    return a.fetchAndAddAcquire(0);
+}
+
+PixelBufferRing::PixelBufferRing()
+    : m_wanted(0)
+    , m_failed(false)
+    , m_buffer(QOpenGLBuffer::PixelUnpackBuffer)
+    , m_ptr(0)
+    , m_slot_size(0)
+{
+}
+
+PixelBufferRing::~PixelBufferRing()
+{
+    if (m_buffer.isCreated())
+        qWarning("PixelBufferRing: gl resources are not destroyed");
+}
+
+bool PixelBufferRing::isSupported()
+{
+    static const bool enabled = qgetenv("QTAV_PBO_RING").isEmpty() || qgetenv("QTAV_PBO_RING").toInt() > 0;
+    if (!enabled)
+        return false;
+    static int support = -1;
+    if (support >= 0)
+        return !!support;
+    const QOpenGLContext *ctx = QOpenGLContext::currentContext();
+    if (!ctx)
+        return false;
+    support = 0;
+    if (!OpenGLHelper::isPBOSupported())
+        return false;
+    bool storage = false;
+    if (OpenGLHelper::isOpenGLES()) {
+        static const char* exts[] = { "GL_EXT_buffer_storage", NULL };
+        storage = OpenGLHelper::hasExtension(exts);
+    } else {
+        static const char* exts[] = { "GL_ARB_buffer_storage", NULL };
+        storage = ctx->format().majorVersion()*10 + ctx->format().minorVersion() >= 44 || OpenGLHelper::hasExtension(exts);
+    }
+    support = storage && OpenGLHelper::hasFenceSync()
+            && gl().BufferStorage && gl().MapBufferRange && gl().UnmapBuffer;
+    qDebug("persistent mapped PBO ring: %d", support);
+    return !!support;
+}
+
+int PixelBufferRing::slotSize(const VideoFrame &frame)
+{
+    const int nb_planes = frame.planeCount();
+    if (nb_planes > MaxPlanes)
+        return 0;
+    int size = 0;
+    for (int i = 0; i < nb_planes; ++i) {
+        if (!frame.constBits(i) || frame.bytesPerLine(i) <= 0)
+            return 0;
+        size += alignUp(frame.bytesPerLine(i)*frame.planeHeight(i));
+    }
+    return size;
+}
+
+bool PixelBufferRing::ensure(const VideoFrame &frame)
+{
+    if (m_failed || !loadState(m_wanted))
+        return false;
+    const int size = slotSize(frame);
+    if (size <= 0)
+        return false;
+    if (size <= m_slot_size)
+        return true;
+    if (!isSupported()) {
+        m_failed = true;
+        return false;
+    }
+    destroy();
+    QMutexLocker lock(&m_mutex);
+    Q_UNUSED(lock);
+    if (!m_buffer.create() || !m_buffer.bind()) {
+        qWarning("PixelBufferRing: failed to create buffer");
+        m_buffer.destroy();
+        m_failed = true;
+        return false;
+    }
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    gl().BufferStorage(GL_PIXEL_UNPACK_BUFFER, (qptrdiff)size*SlotCount, NULL, flags);
+    uchar *ptr = (uchar*)gl().MapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (qptrdiff)size*SlotCount, flags);
+    m_buffer.release();
+    if (!ptr) {
+        qWarning("PixelBufferRing: failed to map buffer persistently. fallback to frame memory");
+        m_buffer.destroy();
+        m_failed = true;
+        return false;
+    }
+    qDebug("PixelBufferRing: %d slots of %d bytes", SlotCount, size);
+    m_ptr = ptr;
+    m_slot_size = size;
+    return true;
+}
+
+void PixelBufferRing::destroy()
+{
+    QMutexLocker lock(&m_mutex); // write() holds the mutex while copying
+    Q_UNUSED(lock);
+    const bool has_gl = !!QOpenGLContext::currentContext();
+    for (int i = 0; i < SlotCount; ++i) {
+        Slot &s = m_slots[i];
+        if (s.sync && has_gl)
+            gl().DeleteSync(s.sync);
+        s.sync = 0;
+        s.state.fetchAndStoreOrdered(Free);
+    }
+    if (!has_gl) {
+        if (m_buffer.isCreated())
+            qWarning("PixelBufferRing: no gl context. buffer is leaked");
+        m_buffer = QOpenGLBuffer(QOpenGLBuffer::PixelUnpackBuffer);
+    } else if (m_buffer.isCreated()) {
+        if (m_ptr && m_buffer.bind()) {
+            gl().UnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            m_buffer.release();
+        }
+        m_buffer.destroy();
+    }
+    m_ptr = 0;
+    m_slot_size = 0;
+}
+
+bool PixelBufferRing::write(const VideoFrame &frame)
+{
+    m_wanted.fetchAndStoreRelease(1);
+    if (!m_mutex.tryLock()) // being recreated in rendering thread
+        return false;
+    const int size = m_ptr ? slotSize(frame) : 0;
+    if (size <= 0 || size > m_slot_size) {
+        m_mutex.unlock();
+        return false;
+    }
+    Slot *slot = 0;
+    int index = 0;
+    for (; index < SlotCount; ++index) {
+        if (m_slots[index].state.testAndSetAcquire(Free, Writing)) {
+            slot = &m_slots[index];
+            break;
+        }
+    }
+    if (!slot) {
+        m_mutex.unlock();
+        return false;
+    }
+    uchar *dst = m_ptr + index*m_slot_size;
+    qptrdiff offset = index*m_slot_size;
+    for (int i = 0; i < frame.planeCount(); ++i) {
+        const int bytes = frame.bytesPerLine(i)*frame.planeHeight(i);
+        memcpy(dst, frame.constBits(i), bytes);
+        slot->offset[i] = offset;
+        dst += alignUp(bytes);
+        offset += alignUp(bytes);
+    }
+    slot->timestamp = frame.timestamp();
+    slot->bits = frame.constBits(0);
+    slot->state.fetchAndStoreRelease(Ready);
+    m_mutex.unlock();
+    return true;
+}
+
+int PixelBufferRing::take(const VideoFrame &frame)
+{
+    int taken = -1;
+    for (int i = 0; i < SlotCount; ++i) {
+        Slot &s = m_slots[i];
+        // a slot taken by the previous frame but never uploaded
+        s.state.testAndSetOrdered(Uploading, Free);
+        if (!s.state.testAndSetAcquire(Ready, Uploading))
+            continue;
+        if (taken < 0 && s.bits == frame.constBits(0) && s.timestamp == frame.timestamp()) {
+            taken = i;
+            continue;
+        }
+        s.state.fetchAndStoreRelease(Free);
+    }
+    return taken;
+}
+
+void PixelBufferRing::fence(int slot)
+{
+    if (slot < 0 || slot >= SlotCount)
+        return;
+    Slot &s = m_slots[slot];
+    s.sync = gl().FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    s.state.testAndSetRelease(Uploading, s.sync ? InFlight : Free);
+}
+
+void PixelBufferRing::reclaim()
+{
+    for (int i = 0; i < SlotCount; ++i) {
+        Slot &s = m_slots[i];
+        if (loadState(s.state) != InFlight)
+            continue;
+        const GLenum ret = gl().ClientWaitSync(s.sync, 0, 0);
+        if (ret == GL_TIMEOUT_EXPIRED)
+            continue;
+        // signaled, or GL_WAIT_FAILED which will never be signaled
+        gl().DeleteSync(s.sync);
+        s.sync = 0;
+        s.state.fetchAndStoreRelease(Free);
+    }
+}
+
+bool PixelBufferRing::bind()
+{
+    return m_buffer.bind();
+}
+
+void PixelBufferRing::release()
+{
+    m_buffer.release();
+}
+
+qptrdiff PixelBufferRing::offset(int slot, int plane) const
+{
+    return m_slots[slot].offset[plane];
+}
+} //namespace QtAV
@@ -0,0 +1,106 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#ifndef QTAV_PIXELBUFFERRING_H
+#define QTAV_PIXELBUFFERRING_H
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include "opengl/gl_api.h"
+
+namespace QtAV {
+class VideoFrame;
+/*!
+ * \brief The PixelBufferRing class
+ * Streams host memory frames to textures through one pixel unpack buffer which is persistently and coherently mapped
+ * and split into 3 slots. write() copies a frame into a free slot in any thread, e.g. the video thread. The rendering
+ * thread uploads textures from the slot and fences it, and the slot is reused after the fence is signaled, so neither
+ * thread waits for the other and no map/unmap is required per frame.
+ * Requires buffer storage (GL4.4, GL_ARB_buffer_storage or GL_EXT_buffer_storage) and sync objects (GL3.2, GL_ARB_sync or ES3).
+ * Set environment var QTAV_PBO_RING=0 to disable.
+ */
+class PixelBufferRing
+{
+public:
+    enum { SlotCount = 3, MaxPlanes = 4 };
+    PixelBufferRing();
+    ~PixelBufferRing();
+    /// Whether current context supports persistent mapping and fences
+    static bool isSupported();
+    /*!
+     * \brief ensure
+     * Rendering thread. Create or grow the buffer so that \a frame fits in a slot. The buffer is created only if write() was called before.
+     * \return false if the ring can not be used for \a frame, e.g. not supported or not in host memory
+     */
+    bool ensure(const VideoFrame& frame);
+    /// Rendering thread. Release gl resources. Waits for a running write()
+    void destroy();
+    /*!
+     * \brief write
+     * Copy planes of \a frame into a free slot. Thread safe.
+     * \return false if no slot is free or the frame does not fit. Textures are uploaded from frame memory then
+     */
+    bool write(const VideoFrame& frame);
+    /*!
+     * \brief take
+     * Rendering thread. Find the slot written for \a frame and mark it as being uploaded. Other written slots are dropped.
+     * \return slot index, or -1 if \a frame was not written
+     */
+    int take(const VideoFrame& frame);
+    /// Rendering thread. Insert a fence after the upload commands reading \a slot are issued
+    void fence(int slot);
+    /// Rendering thread. Release slots whose fences are signaled. Never blocks
+    void reclaim();
+    /// Rendering thread. Bind the buffer to GL_PIXEL_UNPACK_BUFFER
+    bool bind();
+    void release();
+    /// byte offset of \a plane of \a slot in the buffer. Use it as the data pointer of glTexSubImage2D()
+    qptrdiff offset(int slot, int plane) const;
+
+private:
+    enum State {
+        Free,
+        Writing, // copying in write()
+        Ready, // written, waiting for take()
+        Uploading, // taken, waiting for fence()
+        InFlight // fenced, waiting for gpu
+    };
+    struct Slot {
+        Slot() : state(Free), sync(0), timestamp(0), bits(0) {}
+        QAtomicInt state;
+        void *sync; // GLsync
+        // the frame written. only valid after Ready
+        qreal timestamp;
+        const uchar *bits;
+        qptrdiff offset[MaxPlanes];
+    };
+    static int slotSize(const VideoFrame& frame);
+
+    QMutex m_mutex; // guards m_ptr and m_slot_size against destroy()
+    QAtomicInt m_wanted;
+    bool m_failed;
+    QOpenGLBuffer m_buffer;
+    uchar *m_ptr;
+    int m_slot_size;
+    Slot m_slots[SlotCount];
+};
+} //namespace QtAV
+#endif // QTAV_PIXELBUFFERRING_H
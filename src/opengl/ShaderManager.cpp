@@ -1,10 +1,18 @@
 #include "ShaderManager.h"
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QPair>
+#include <QtCore/QThread>
 #include "QtAV/VideoShader.h"
+#include "TexturePool.h"
+#include "utils/Logger.h"
 
 namespace QtAV {
+typedef QPair<const void*, QThread*> ManagerKey;
 class ShaderManager::Private
 {
 public:
+    Private() : ref(0) {}
     ~Private() {
         // TODO: thread safe required?
         qDeleteAll(shader_cache.values());
@@ -12,8 +20,67 @@ public:
     }
 
     QHash<qint32, VideoShader*> shader_cache;
+    TexturePool texture_pool;
+    int ref;
+    ManagerKey key;
 };
 
+namespace {
+class Managers
+{
+public:
+    QMutex mutex;
+    QHash<ManagerKey, ShaderManager*> managers;
+};
+
+Managers& managers()
+{
+    static Managers m;
+    return m;
+}
+} //namespace
+
+ShaderManager* ShaderManager::acquire(QOpenGLContext *ctx)
+{
+    if (!ctx)
+        return 0;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    const void *group = ctx->shareGroup();
+#else
+    const void *group = ctx; // no share group api
+#endif
+    // a shared program can not be used by 2 threads because uniforms are program states
+    const ManagerKey key(group, QThread::currentThread());
+    Managers &m = managers();
+    QMutexLocker lock(&m.mutex);
+    Q_UNUSED(lock);
+    ShaderManager *manager = m.managers.value(key, 0);
+    if (!manager) {
+        manager = new ShaderManager();
+        manager->d->key = key;
+        m.managers.insert(key, manager);
+        qDebug("ShaderManager %p is created for share group %p", manager, group);
+    }
+    manager->d->ref++;
+    return manager;
+}
+
+void ShaderManager::release(ShaderManager *manager)
+{
+    if (!manager)
+        return;
+    Managers &m = managers();
+    {
+        QMutexLocker lock(&m.mutex);
+        Q_UNUSED(lock);
+        if (--manager->d->ref > 0)
+            return;
+        m.managers.remove(manager->d->key);
+    }
+    qDebug("ShaderManager %p is deleted", manager);
+    delete manager;
+}
+
 ShaderManager::ShaderManager(QObject *parent) :
     QObject(parent)
   , d(new Private())
@@ -38,4 +105,9 @@ VideoShader* ShaderManager::prepareMaterial(VideoMaterial *material, qint32 mate
     d->shader_cache[type] = shader;
     return shader;
 }
+
+TexturePool* ShaderManager::texturePool()
+{
+    return &d->texture_pool;
+}
 } //namespace QtAV
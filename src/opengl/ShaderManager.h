@@ -23,22 +23,33 @@
 #define QTAV_SHADERMANAGER_H
 
 #include <QtCore/QObject>
+#include "opengl/gl_api.h"
 
 namespace QtAV {
 class VideoShader;
 class VideoMaterial;
+class TexturePool;
 /*!
  * \brief The ShaderManager class
- * Cache VideoShader and shader programes for different video material type.
+ * Cache VideoShader and shader programes for different video material type, and video textures(TexturePool).
+ * Programs and textures are shared by contexts in a share group, so a manager is shared by all renderers using the same share group in the same thread.
  * TODO: ShaderManager does not change for a given vo, so we can expose VideoRenderer.shaderManager() to set custom shader. It's better than VideoRenderer.opengl() because OpenGLVideo exposes too many apis that may confuse user.
  */
 class ShaderManager : public QObject
 {
     Q_OBJECT
 public:
+    /*!
+     * \brief acquire
+     * Get the manager of \a ctx's share group and current thread, and add a reference. \a ctx must be current.
+     */
+    static ShaderManager* acquire(QOpenGLContext* ctx);
+    /// Remove a reference and delete \a manager if it's the last one. gl resources are released if a context is current
+    static void release(ShaderManager* manager);
     ShaderManager(QObject *parent = 0);
     ~ShaderManager();
     VideoShader* prepareMaterial(VideoMaterial *material, qint32 materialType = -1);
+    TexturePool* texturePool();
 //    void setCacheSize(int value);
 
 private:
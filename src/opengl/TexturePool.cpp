@@ -0,0 +1,177 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+
+#include "TexturePool.h"
+#include "opengl/OpenGLHelper.h"
+#include "utils/Logger.h"
+
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_TIMEOUT_IGNORED
+#define GL_TIMEOUT_IGNORED 0xFFFFFFFFFFFFFFFFull
+#endif
+
+namespace QtAV {
+// idle sets of the same key. more are deleted
+static const int kMaxIdle = 2;
+// idle sets of all keys, e.g. sizes not used any more after resizing or opening another video
+static const int kMaxIdleTotal = 6;
+
+TexturePool::TexturePool()
+    : m_released(0)
+{
+}
+
+TexturePool::~TexturePool()
+{
+    if (!QOpenGLContext::currentContext()) {
+        if (!m_sets.isEmpty() || !m_pending_syncs.isEmpty())
+            qWarning("TexturePool: no gl context. %d texture sets and %d syncs are leaked", m_sets.size(), m_pending_syncs.size());
+        qDeleteAll(m_sets);
+        m_sets.clear();
+        return;
+    }
+    while (!m_sets.isEmpty())
+        deleteSet(m_sets.first());
+    deletePendingSyncs();
+}
+
+bool TexturePool::hasContent(const TextureSet *set, const VideoFrame &frame)
+{
+    // the set holds the frame, so the shared data can not be reused by another frame
+    return frame.isValid() && set->frame.isSharedWith(frame);
+}
+
+TextureSet* TexturePool::find(const QByteArray &key, const VideoFrame &frame)
+{
+    const QOpenGLContext *ctx = QOpenGLContext::currentContext();
+    foreach (TextureSet *set, m_sets) {
+        if (set->ref <= 0 || set->key != key || !hasContent(set, frame))
+            continue;
+        if (set->ctx != ctx) {
+            // changes of a shared object are visible in another context after completion
+            if (!set->sync)
+                continue;
+            gl().WaitSync(set->sync, 0, GL_TIMEOUT_IGNORED);
+        }
+        set->ref++;
+        return set;
+    }
+    return 0;
+}
+
+TextureSet* TexturePool::acquire(const QByteArray &key, int planes, bool *created)
+{
+    QOpenGLContext *ctx = const_cast<QOpenGLContext*>(QOpenGLContext::currentContext()); //qt4 returns const
+    deletePendingSyncs();
+    foreach (TextureSet *set, m_sets) {
+        if (set->ref == 0 && set->ctx == ctx && set->key == key) {
+            set->ref = 1;
+            *created = false;
+            return set;
+        }
+    }
+    TextureSet *set = new TextureSet();
+    set->key = key;
+    set->textures.resize(planes);
+    DYGL(glGenTextures(planes, set->textures.data()));
+    set->ref = 1;
+    set->ctx = ctx;
+    m_sets.append(set);
+    *created = true;
+    qDebug("TexturePool: %d texture sets", m_sets.size());
+    return set;
+}
+
+void TexturePool::release(TextureSet *set)
+{
+    if (!set || --set->ref > 0)
+        return;
+    clearContent(set);
+    set->released = ++m_released;
+    if (!QOpenGLContext::currentContext())
+        return;
+    deletePendingSyncs();
+    int idle = 0;
+    foreach (const TextureSet *s, m_sets) {
+        if (s->ref == 0 && s->key == set->key)
+            ++idle;
+    }
+    if (idle > kMaxIdle) {
+        deleteSet(set);
+        return;
+    }
+    forever {
+        TextureSet *oldest = 0;
+        idle = 0;
+        foreach (TextureSet *s, m_sets) {
+            if (s->ref > 0)
+                continue;
+            ++idle;
+            if (!oldest || s->released < oldest->released)
+                oldest = s;
+        }
+        if (idle <= kMaxIdleTotal)
+            break;
+        deleteSet(oldest);
+    }
+}
+
+void TexturePool::setContent(TextureSet *set, const VideoFrame &frame)
+{
+    clearContent(set);
+    set->frame = frame;
+    set->ctx = const_cast<QOpenGLContext*>(QOpenGLContext::currentContext());
+    if (OpenGLHelper::hasFenceSync())
+        set->sync = gl().FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void TexturePool::clearContent(TextureSet *set)
+{
+    set->frame = VideoFrame();
+    if (set->sync) {
+        if (QOpenGLContext::currentContext())
+            gl().DeleteSync(set->sync);
+        else // sync is a share group object, delete it when any context is current
+            m_pending_syncs.append(set->sync);
+    }
+    set->sync = 0;
+}
+
+void TexturePool::deletePendingSyncs()
+{
+    foreach (void *sync, m_pending_syncs) {
+        gl().DeleteSync(sync);
+    }
+    m_pending_syncs.clear();
+}
+
+void TexturePool::deleteSet(TextureSet *set)
+{
+    clearContent(set);
+    // deleting in any context of the share group is fine
+    DYGL(glDeleteTextures(set->textures.size(), set->textures.constData()));
+    m_sets.removeOne(set);
+    delete set;
+}
+} //namespace QtAV
@@ -0,0 +1,90 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+
+#ifndef QTAV_TEXTUREPOOL_H
+#define QTAV_TEXTUREPOOL_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QVector>
+#include "QtAV/VideoFrame.h"
+#include "opengl/gl_api.h"
+
+namespace QtAV {
+/*!
+ * \brief The TextureSet class
+ * Textures of all planes of a video frame, owned by TexturePool
+ */
+class TextureSet
+{
+public:
+    TextureSet() : ref(0), ctx(0), sync(0), released(0) {}
+    QByteArray key; // target, plane formats and sizes. see VideoMaterialPrivate::textureKey()
+    QVector<GLuint> textures;
+    int ref;
+    QOpenGLContext *ctx; // context created in or uploaded in
+    VideoFrame frame; // uploaded content. holding it keeps the shared frame data, so Frame::isSharedWith() identifies the frame
+    void *sync; // GLsync after upload, for other contexts in the share group
+    qint64 released; // release order. the least recently released idle set is deleted first
+};
+
+/*!
+ * \brief The TexturePool class
+ * Video textures shared by materials rendering in the same context share group and thread. Owned by ShaderManager.
+ * A host memory frame uploaded by one material is reused by other materials rendering the same frame, e.g. a video wall
+ * showing one player on many renderers. Released textures are recycled by (target, format, size) instead of being recreated.
+ * Idle sets are limited per key and in total, the least recently released ones are deleted.
+ */
+class TexturePool
+{
+public:
+    TexturePool();
+    /// textures are deleted if a context is current
+    ~TexturePool();
+    /*!
+     * \brief find
+     * Find a set with content of \a frame. Reference is added.
+     * A set uploaded in another context is returned only if it's fenced, and current context waits for the fence on gpu.
+     */
+    TextureSet* find(const QByteArray& key, const VideoFrame& frame);
+    /*!
+     * \brief acquire
+     * Get an idle set created in current context, or create a set with new texture ids. Reference is added.
+     * \param created true if texture ids are new and storage must be initialized by caller
+     */
+    TextureSet* acquire(const QByteArray& key, int planes, bool *created);
+    void release(TextureSet* set);
+    /// Call after the textures of \a set are uploaded from \a frame in current context
+    void setContent(TextureSet* set, const VideoFrame& frame);
+    static bool hasContent(const TextureSet* set, const VideoFrame& frame);
+
+private:
+    void clearContent(TextureSet* set);
+    void deleteSet(TextureSet* set);
+    /// delete sync objects cleared without a current context
+    void deletePendingSyncs();
+    QList<TextureSet*> m_sets;
+    QList<void*> m_pending_syncs;
+    qint64 m_released;
+};
+} //namespace QtAV
+#endif // QTAV_TEXTUREPOOL_H
@@ -23,6 +23,8 @@
 #include "QtAV/private/VideoShader_p.h"
 #include "ColorTransform.h"
 #include "opengl/OpenGLHelper.h"
+#include "opengl/PixelBufferRing.h"
+#include "opengl/TexturePool.h"
 #include <cmath>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QFile>
@@ -387,9 +389,24 @@ bool VideoShader::update(VideoMaterial *material)
         }
     }
     // shader type changed, eq mat changed, or other material properties changed (e.g. texture, 8bit=>10bit)
-    if (!d.update_builtin_uniforms && !material->isDirty())
+    // compare values, a material may be deleted and another one created at the same address
+    const QVector<QVector2D> texel_size(material->texelSize());
+    const QVector<QVector2D> texture_size(material->textureSize());
+    const bool same_material = d.last_type == material->type()
+            && d.last_color_matrix == material->colorMatrix()
+            && d.last_channel_map == material->channelMap()
+            && d.last_to8 == material->vectorTo8bit()
+            && d.last_texel_size == texel_size
+            && d.last_texture_size == texture_size;
+    if (!d.update_builtin_uniforms && !material->isDirty() && same_material)
         return true;
     d.update_builtin_uniforms = false;
+    d.last_type = material->type();
+    d.last_color_matrix = material->colorMatrix();
+    d.last_channel_map = material->channelMap();
+    d.last_to8 = material->vectorTo8bit();
+    d.last_texel_size = texel_size;
+    d.last_texture_size = texture_size;
     // all texture ids should be binded when renderering even for packed plane!
     const int nb_planes = fmt.planeCount(); //number of texture id
     // TODO: sample2D array
@@ -410,9 +427,9 @@ bool VideoShader::update(VideoMaterial *material)
         program()->setUniformValue(channelMapLocation(), material->channelMap());
     //program()->setUniformValue(matrixLocation(), ); //what about sgnode? state.combindMatrix()?
     if (texelSizeLocation() >= 0)
-        program()->setUniformValueArray(texelSizeLocation(), material->texelSize().constData(), nb_planes);
+        program()->setUniformValueArray(texelSizeLocation(), texel_size.constData(), nb_planes);
     if (textureSizeLocation() >= 0)
-        program()->setUniformValueArray(textureSizeLocation(), material->textureSize().constData(), nb_planes);
+        program()->setUniformValueArray(textureSizeLocation(), texture_size.constData(), nb_planes);
     // uniform end. attribute begins
     return true;
 }
@@ -599,10 +616,18 @@ bool VideoMaterial::bind()
         return false;
     if (nb_planes > 4) //why?
         return false;
-    d.ensureTextures();
+    bool upload = d.update_texure;
+    if (!d.ensurePooledTextures(&upload))
+        d.ensureTextures();
     for (int i = 0; i < nb_planes; ++i) {
         const int p = (i + 1) % nb_planes; //0 must active at last?
-        d.uploadPlane(p, d.update_texure);
+        d.uploadPlane(p, upload);
+    }
+    if (upload && d.tex_set)
+        d.tex_pool->setContent(d.tex_set, d.frame);
+    if (d.update_texure && d.ring && d.ring_slot >= 0) {
+        d.ring->fence(d.ring_slot);
+        d.ring_slot = -1;
     }
 #if 0 //move to unbind should be fine
     if (d.update_texure) {
@@ -641,7 +666,12 @@ void VideoMaterialPrivate::uploadPlane(int p, bool updateTexture)
     // FIXME: why happens on win?
     if (frame.bytesPerLine(p) <= 0)
         return;
-    if (try_pbo) {
+    const GLubyte *data = frame.constBits(p);
+    if (ring && ring_slot >= 0) {
+        // planes were copied to the persistently mapped ring in video thread
+        ring->bind();
+        data = reinterpret_cast<const GLubyte*>(ring->offset(ring_slot, p));
+    } else if (try_pbo) {
         //qDebug("bind PBO %d", p);
         QOpenGLBuffer &pb = pbo[p];
         pb.bind();
@@ -655,6 +685,7 @@ void VideoMaterialPrivate::uploadPlane(int p, bool updateTexture)
             memcpy(ptr, frame.constBits(p), pb.size());
             pb.unmap();
         }
+        data = 0;
     }
     //qDebug("bpl[%d]=%d width=%d", p, frame.bytesPerLine(p), frame.planeWidth(p));
     DYGL(glBindTexture(target, tex));
@@ -663,16 +694,34 @@ void VideoMaterialPrivate::uploadPlane(int p, bool updateTexture)
     //DYGL(glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
     // This is necessary for non-power-of-two textures
     //glPixelStorei(GL_UNPACK_ALIGNMENT, get_alignment(stride)); 8, 4, 2, 1
-    // glPixelStorei(GL_UNPACK_ROW_LENGTH, stride/glbpp); // for stride%glbpp > 0?
-    DYGL(glTexSubImage2D(target, 0, 0, 0, texture_size[p].width(), texture_size[p].height(), data_format[p], data_type[p], try_pbo ? 0 : frame.constBits(p)));
-    if (false) { //texture_size[].width()*gl_bpp != bytesPerLine[]
-        for (int y = 0; y < plane0Size.height(); ++y)
-            DYGL(glTexSubImage2D(target, 0, 0, y, texture_size[p].width(), 1, data_format[p], data_type[p], try_pbo ? 0 : frame.constBits(p)+y*plane0Size.width()));
-    }
+    texSubImage(p, data);
     //DYGL(glBindTexture(target, 0)); // no bind 0 because glActiveTexture was called
-    if (try_pbo) {
+    if (ring && ring_slot >= 0)
+        ring->release();
+    else if (try_pbo)
         pbo[p].release();
+}
+
+void VideoMaterialPrivate::texSubImage(int p, const void *data)
+{
+    const int w = texture_size[p].width();
+    const int bpl = frame.bytesPerLine(p);
+    const int bpp_gl = OpenGLHelper::bytesOfGLFormat(data_format[p], data_type[p]);
+    if (bpl == w*bpp_gl) {
+        DYGL(glTexSubImage2D(target, 0, 0, 0, w, texture_size[p].height(), data_format[p], data_type[p], data));
+        return;
+    }
+    // frame stride is not the texture width, e.g. only this plane's padding changed, or stride is not a multiple of gl pixel size
+    const int h = qMin(texture_size[p].height(), frame.planeHeight(p));
+    const int row_w = qMin(w, bpl/bpp_gl);
+    if (bpl % bpp_gl == 0 && (bpl & 3) == 0 && OpenGLHelper::hasUnpackRowLength()) { // row start must match GL_UNPACK_ALIGNMENT(4)
+        DYGL(glPixelStorei(GL_UNPACK_ROW_LENGTH, bpl/bpp_gl));
+        DYGL(glTexSubImage2D(target, 0, 0, 0, row_w, h, data_format[p], data_type[p], data));
+        DYGL(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+        return;
     }
+    for (int y = 0; y < h; ++y)
+        DYGL(glTexSubImage2D(target, 0, 0, y, row_w, 1, data_format[p], data_type[p], (const GLubyte*)data + y*bpl));
 }
 
 void VideoMaterial::unbind()
@@ -948,6 +997,7 @@ bool VideoMaterialPrivate::initTexture(GLuint tex, GLint internal_format, GLenum
 
 VideoMaterialPrivate::~VideoMaterialPrivate()
 {
+    releasePooledTextures(); // pool is released later
     // FIXME: when to delete
     if (!QOpenGLContext::currentContext()) {
         qWarning("No gl context");
@@ -1137,6 +1187,71 @@ bool VideoMaterialPrivate::ensureTextures()
     return true;
 }
 
+QByteArray VideoMaterialPrivate::textureKey() const
+{
+    QByteArray key;
+    const int nb_planes = textures.size();
+    key.reserve((1 + 5*nb_planes)*sizeof(int));
+    const int t = target;
+    key.append((const char*)&t, sizeof(t));
+    for (int p = 0; p < nb_planes; ++p) {
+        const int v[] = { internal_format[p], (int)data_format[p], (int)data_type[p], texture_size[p].width(), texture_size[p].height() };
+        key.append((const char*)v, sizeof(v));
+    }
+    return key;
+}
+
+bool VideoMaterialPrivate::ensurePooledTextures(bool *upload)
+{
+    if (!tex_pool || !frame.constBits(0)) {
+        if (tex_set) { // e.g. switch to hw decoding
+            releasePooledTextures();
+            init_textures_required = true;
+        }
+        return false;
+    }
+    if (!update_texure && tex_set)
+        return true;
+    if (!tex_set) { // delete textures created by ensureTextures() or interop
+        for (int p = 0; p < textures.size(); ++p) {
+            GLuint &tex = textures[p];
+            if (tex && owns_texture[tex])
+                DYGL(glDeleteTextures(1, &tex));
+            tex = 0;
+        }
+        owns_texture.clear();
+    }
+    const QByteArray key(textureKey());
+    if (tex_set && tex_set->key == key && TexturePool::hasContent(tex_set, frame)) {
+        *upload = false;
+    } else if (TextureSet *s = tex_pool->find(key, frame)) { // uploaded by another material
+        releasePooledTextures();
+        tex_set = s;
+        *upload = false;
+    } else if (!tex_set || tex_set->key != key || tex_set->ref > 1) { // can not upload to textures used by others
+        releasePooledTextures();
+        bool created = false;
+        tex_set = tex_pool->acquire(key, textures.size(), &created);
+        if (created) {
+            for (int p = 0; p < textures.size(); ++p)
+                initTexture(tex_set->textures[p], internal_format[p], data_format[p], data_type[p], texture_size[p].width(), texture_size[p].height());
+        }
+    }
+    for (int p = 0; p < textures.size(); ++p)
+        textures[p] = tex_set->textures[p];
+    init_textures_required = false;
+    return true;
+}
+
+void VideoMaterialPrivate::releasePooledTextures()
+{
+    if (!tex_set)
+        return;
+    tex_pool->release(tex_set);
+    tex_set = 0;
+    textures.fill(0);
+}
+
 void VideoMaterialPrivate::setupQuality()
 {
     DYGL(glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
@@ -146,6 +146,14 @@ void api::resolve()
     GL_RESOLVE(BlendFuncSeparate);
 
     GL_RESOLVE_ES_3_1(GetTexLevelParameteriv);
+    // not linked for GL2/ES2 headers, always resolve at runtime
+    GL_RESOLVE_EXT(MapBufferRange);
+    GL_RESOLVE_EXT(UnmapBuffer);
+    GL_RESOLVE_EXT(BufferStorage);
+    GL_RESOLVE_EXT(FenceSync);
+    GL_RESOLVE_EXT(ClientWaitSync);
+    GL_RESOLVE_EXT(WaitSync);
+    GL_RESOLVE_EXT(DeleteSync);
 
 #ifdef Q_OS_WIN32
     if (!OpenGLHelper::isOpenGLES()) {
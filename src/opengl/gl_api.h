@@ -113,6 +113,9 @@ typedef QGLBuffer QOpenGLBuffer;
 #ifndef GL_RGBA16
 #define GL_RGBA16 0x805B
 #endif
+#ifndef GL_UNPACK_ROW_LENGTH
+#define GL_UNPACK_ROW_LENGTH 0x0CF2
+#endif
 
 namespace QtAV {
 typedef char GLchar; // for qt4 mingw
@@ -146,6 +149,16 @@ struct api {
     // Before using the following members, check null ptr first because they are not valid everywhere
 // ES3.1
     void (GL_APIENTRY *GetTexLevelParameteriv)(GLenum, GLint, GLenum, GLint *);
+// GL3.0, ES3.0. qptrdiff: GLintptr and GLsizeiptr are not declared by old gl headers
+    void* (GL_APIENTRY *MapBufferRange)(GLenum target, qptrdiff offset, qptrdiff length, GLbitfield access);
+    GLboolean (GL_APIENTRY *UnmapBuffer)(GLenum target);
+// GL4.4, GL_ARB_buffer_storage, GL_EXT_buffer_storage
+    void (GL_APIENTRY *BufferStorage)(GLenum target, qptrdiff size, const void *data, GLbitfield flags);
+// GL3.2, GL_ARB_sync, ES3.0. void* is GLsync
+    void* (GL_APIENTRY *FenceSync)(GLenum condition, GLbitfield flags);
+    GLenum (GL_APIENTRY *ClientWaitSync)(void *sync, GLbitfield flags, quint64 timeout);
+    void (GL_APIENTRY *WaitSync)(void *sync, GLbitfield flags, quint64 timeout);
+    void (GL_APIENTRY *DeleteSync)(void *sync);
 
 #if defined(Q_OS_WIN32)
     //#include <GL/wglext.h> //not found in vs2013
@@ -23,12 +23,14 @@
 #include "QtAV/private/AVOutput_p.h"
 #include "QtAV/private/AudioOutputBackend.h"
 #include "QtAV/private/AVCompat.h"
+#include "QtAV/MemoryAccounting.h"
 #if QT_VERSION >= QT_VERSION_CHECK(4, 7, 0)
 #include <QtCore/QElapsedTimer>
 #else
 #include <QtCore/QTime>
 typedef QTime QElapsedTimer;
 #endif
+#include <QtCore/QAtomicInt>
 #include "utils/ring.h"
 #include "utils/Logger.h"
 
@@ -36,6 +38,111 @@ typedef QTime QElapsedTimer;
 
 namespace QtAV {
 
+static inline int atomicLoad(const QAtomicInt& a)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    return a.loadAcquire();
+#else
+    return a;
+#endif
+}
+
+/*!
+ * Lock free PCM ring for Pull control. One producer (AudioOutput::receiveData()) and one consumer (backend callback).
+ * Positions are byte counters wrapped at 2^32, capacity is a power of 2.
+ * clear() is requested by the producer. It is done by the producer if the consumer is not reading, e.g. paused or between
+ * callbacks, otherwise by the consumer on the next read().
+ */
+class PCMRing
+{
+public:
+    PCMRing() : m_buf(0), m_mask(0), m_clear_pos(0) {}
+    /// not thread safe. call it when the consumer is stopped
+    void reset(int capacity) {
+        int c = 1;
+        while (c < capacity)
+            c <<= 1;
+        if (capacity <= 0)
+            c = 0;
+        m_data.resize(c);
+        m_buf = c ? m_data.data() : 0;
+        m_mask = c - 1;
+        m_write.fetchAndStoreRelease(0);
+        m_read.fetchAndStoreRelease(0);
+        m_clear.fetchAndStoreRelease(0);
+        m_reading.fetchAndStoreRelease(0);
+    }
+    int capacity() const { return m_data.size();}
+    quint32 readPos() const { return quint32(atomicLoad(m_read));}
+    quint32 writePos() const { return quint32(atomicLoad(m_write));}
+    int readable() const { return int(writePos() - readPos());}
+    // producer. a pending clear() is applied first if possible
+    int writable() {
+        applyClear();
+        return capacity() - readable();
+    }
+    // producer
+    int write(const char* data, int bytes) {
+        if (!m_buf)
+            return 0;
+        const quint32 w = writePos();
+        bytes = qMin(bytes, writable());
+        copy(m_buf, w, data, bytes, true);
+        m_write.fetchAndStoreRelease(int(w + quint32(bytes)));
+        return bytes;
+    }
+    // producer. drop all queued data
+    void clear() {
+        m_clear_pos = writePos();
+        m_clear.fetchAndStoreRelease(1);
+        applyClear();
+    }
+    // consumer
+    int read(char* data, int bytes) {
+        if (!m_buf)
+            return 0;
+        // the producer holds it only to move the read position in applyClear()
+        while (!m_reading.testAndSetAcquire(0, 1)) {}
+        if (m_clear.fetchAndStoreAcquire(0))
+            m_read.fetchAndStoreRelease(int(m_clear_pos));
+        const quint32 r = readPos();
+        bytes = qMin(bytes, readable());
+        if (bytes > 0) {
+            copy(data, r, m_buf, bytes, false);
+            m_read.fetchAndStoreRelease(int(r + quint32(bytes)));
+        }
+        m_reading.fetchAndStoreRelease(0);
+        return qMax(bytes, 0);
+    }
+private:
+    // producer. drop the data if the consumer is not reading, otherwise the consumer does it in read()
+    void applyClear() {
+        if (!atomicLoad(m_clear) || !m_reading.testAndSetAcquire(0, 2))
+            return;
+        if (m_clear.fetchAndStoreAcquire(0))
+            m_read.fetchAndStoreRelease(int(m_clear_pos));
+        m_reading.fetchAndStoreRelease(0);
+    }
+    void copy(char* dst, quint32 pos, const char* src, int bytes, bool to_ring) const {
+        const int i = int(pos & quint32(m_mask));
+        const int n = qMin(bytes, capacity() - i);
+        if (to_ring) {
+            memcpy(dst + i, src, n);
+            memcpy(dst, src + n, bytes - n);
+        } else {
+            memcpy(dst, src + i, n);
+            memcpy(dst + n, src, bytes - n);
+        }
+    }
+    QByteArray m_data;
+    char *m_buf;
+    int m_mask;
+    QAtomicInt m_write, m_read;
+    QAtomicInt m_clear;
+    QAtomicInt m_reading; // 1: consumer is reading, 2: producer is clearing
+    quint32 m_clear_pos;
+};
+
 // chunk
 static const int kBufferSamples = 512;
 static const int kBufferCount = 8*2; // may wait too long at the beginning (oal) if too large. if buffer count is too small, can not play for high sample rate audio.
@@ -138,6 +245,9 @@ public:
       , index_enqueue(-1)
       , index_deuqueue(-1)
       , frame_infos(ring<FrameInfo>(nb_buffers))
+      , queued_bytes(0)
+      , pull(false)
+      , rebase_end(0)
     {
         available = false;
     }
@@ -152,10 +262,12 @@ public:
     }
 
     struct FrameInfo {
-        FrameInfo(const QByteArray& d = QByteArray(), qreal t = 0, int us = 0) : timestamp(t), duration(us), data(d) {}
+        FrameInfo(const QByteArray& d = QByteArray(), qreal t = 0, int us = 0) : timestamp(t), duration(us), pos(0), size(d.size()), data(d) {}
         qreal timestamp;
         int duration; // in us
-        QByteArray data;
+        quint32 pos; // Pull: position in pcm
+        int size;
+        QByteArray data; // empty for Pull
     };
 
     void resetStatus() {
@@ -166,6 +278,45 @@ public:
         timer.invalidate();
 #endif
         frame_infos = ring<FrameInfo>(nb_buffers);
+        MemoryAccounting::add(MemoryAccounting::AudioOutputBuffers, -queued_bytes, dptr_ptr());
+        queued_bytes = 0;
+        pcm.clear();
+    }
+    /// Pull: pop frames completely read by backend
+    void popConsumedFrames() {
+        const quint32 r = pcm.readPos();
+        while (!frame_infos.empty()) {
+            const FrameInfo &fi = frame_infos.front();
+            if (int(r - fi.pos) < fi.size) // not started or partially read
+                break;
+            popFrameInfo();
+        }
+    }
+    // keep queued_bytes and MemoryAccounting in sync with frame_infos
+    void pushFrameInfo(const FrameInfo& fi) {
+        qint64 bytes = fi.data.size();
+        if (frame_infos.size() == frame_infos.capacity())
+            bytes -= frame_infos.front().data.size(); // overwritten
+        frame_infos.push_back(fi);
+        queued_bytes += bytes;
+        MemoryAccounting::add(MemoryAccounting::AudioOutputBuffers, bytes, dptr_ptr());
+    }
+    void popFrameInfo() {
+        const qint64 bytes = frame_infos.front().data.size();
+        frame_infos.pop_front();
+        queued_bytes -= bytes;
+        MemoryAccounting::add(MemoryAccounting::AudioOutputBuffers, -bytes, dptr_ptr());
+    }
+    /// apply rebaseTimestamps() in the thread queuing data, i.e. the only thread modifying frame_infos
+    void applyRebase() {
+        if (!rebase_pending.fetchAndStoreAcquire(0))
+            return;
+        qreal t = rebase_end;
+        for (int i = int(frame_infos.size()) - 1; i >= 0; --i) {
+            FrameInfo &fi = frame_infos[i];
+            t -= qreal(fi.duration)/1000000.0;
+            fi.timestamp = t;
+        }
     }
     /// call this if sample format or volume is changed
     void updateSampleScaleFunc();
@@ -197,6 +348,14 @@ public:
     // the index of current enqueue/dequeue
     int index_enqueue, index_deuqueue;
     ring<FrameInfo> frame_infos;
+    qint64 queued_bytes; // data bytes in frame_infos
+    // Pull control: data is queued in pcm and read by backend callback. The clock is computed from the read position
+    bool pull;
+    PCMRing pcm;
+    QAtomicInt pull_waiting; // producer is waiting in waitForNextBuffer()
+    QAtomicInt pull_paused; // paused, read by backend callback
+    QAtomicInt rebase_pending; // rebase_end is set by rebaseTimestamps() and not applied yet
+    qreal rebase_end;
 };
 
 void AudioOutputPrivate::updateSampleScaleFunc()
@@ -206,6 +365,7 @@ void AudioOutputPrivate::updateSampleScaleFunc()
 
 AudioOutputPrivate::~AudioOutputPrivate()
 {
+    MemoryAccounting::add(MemoryAccounting::AudioOutputBuffers, -queued_bytes - pcm.capacity(), dptr_ptr());
     if (backend) {
         backend->close();
         delete backend;
@@ -220,7 +380,7 @@ void AudioOutputPrivate::playInitialData()
     for (quint32 i = 0; i < nb_buffers; ++i) {
         const QByteArray data(backend->buffer_size, c);
         backend->write(data); // fill silence byte, not always 0. AudioFormat.silenceByte
-        frame_infos.push_back(FrameInfo(data, 0, 0)); // initial data can be small (1 instead of buffer_samples)
+        pushFrameInfo(FrameInfo(data, 0, 0)); // initial data can be small (1 instead of buffer_samples)
     }
     backend->play();
 }
@@ -256,6 +416,7 @@ AudioOutput::AudioOutput(QObject* parent)
     : QObject(parent)
     , AVOutput(*new AudioOutputPrivate())
 {
+    DPTR_INIT_PRIVATE(AVOutput); // MemoryAccounting owner
     qDebug() << "Registered audio backends: " << AudioOutput::backendsAvailable(); // call this to register
     setBackends(AudioOutputBackend::defaultPriority()); //ensure a backend is available
 }
@@ -334,6 +495,14 @@ QString AudioOutput::backend() const
 void AudioOutput::flush()
 {
     DPTR_D(AudioOutput);
+    if (d.pull) {
+        QElapsedTimer timer;
+        timer.start();
+        while (d.available && d.pcm.readable() > 0 && timer.elapsed() < 1000)
+            d.uwait(d.format.durationForBytes(d.pcm.readable()));
+        d.popConsumedFrames();
+        return;
+    }
     while (!d.frame_infos.empty()) {
         if (d.backend)
             d.backend->flush();
@@ -344,7 +513,8 @@ void AudioOutput::flush()
 void AudioOutput::clear()
 {
     DPTR_D(AudioOutput);
-    if (!d.backend || !d.backend->clear())
+    // Pull: queued data is dropped by the backend callback
+    if (!d.pull && (!d.backend || !d.backend->clear()))
         flush();
     d.resetStatus();
 }
@@ -356,6 +526,7 @@ bool AudioOutput::open()
     Q_UNUSED(lock);
     d.available = false;
     d.paused = false;
+    d.pull_paused.fetchAndStoreRelease(0);
     d.resetStatus();
     if (!d.backend)
         return false;
@@ -363,13 +534,22 @@ bool AudioOutput::open()
     d.backend->buffer_size = bufferSize();
     d.backend->buffer_count = bufferCount();
     d.backend->format = audioFormat();
+    d.pull = d.backend->bufferControl() & AudioOutputBackend::Pull;
+    if (d.pull) {
+        const int old_capacity = d.pcm.capacity();
+        d.pcm.reset(bufferSizeTotal());
+        MemoryAccounting::add(MemoryAccounting::AudioOutputBuffers, d.pcm.capacity() - old_capacity, dptr_ptr());
+    }
     // TODO: open next backend if fail and emit backendChanged()
     if (!d.backend->open())
         return false;
     d.available = true;
     d.tryVolume(volume());
     d.tryMute(isMute());
-    d.playInitialData();
+    if (d.pull) // no initial data. the callback plays silence if no data is queued
+        d.backend->play();
+    else
+        d.playInitialData();
     return true;
 }
 
@@ -380,12 +560,17 @@ bool AudioOutput::close()
     Q_UNUSED(lock);
     d.available = false;
     d.paused = false;
-    d.resetStatus();
-    if (!d.backend)
+    d.pull_paused.fetchAndStoreRelease(0);
+    if (!d.backend) {
+        d.resetStatus();
         return false;
+    }
     // TODO: drain() before close
+    // stop the device first. Pull backend callback reads audio and the pcm ring until then
+    const bool ok = d.backend->close();
     d.backend->audio = 0;
-    return d.backend->close();
+    d.resetStatus();
+    return ok;
 }
 
 bool AudioOutput::isOpen() const
@@ -407,6 +592,7 @@ void AudioOutput::pause(bool value)
 {
     DPTR_D(AudioOutput);
     d.paused = value;
+    d.pull_paused.fetchAndStoreRelease(value);
     // backend pause? Without backend pause, the buffered data will be played
 }
 
@@ -420,6 +606,7 @@ bool AudioOutput::receiveData(const QByteArray &data, qreal pts)
     DPTR_D(AudioOutput);
     if (isPaused())
         return false;
+    d.applyRebase();
     QByteArray queue_data(data);
     if (isMute() && d.sw_mute) {
         char s = 0;
@@ -443,7 +630,14 @@ bool AudioOutput::receiveData(const QByteArray &data, qreal pts)
         d.resetStatus();
         return false;
     }
-    d.frame_infos.push_back(AudioOutputPrivate::FrameInfo(queue_data, pts, d.format.durationForBytes(queue_data.size())));
+    if (d.pull) {
+        AudioOutputPrivate::FrameInfo fi(QByteArray(), pts, d.format.durationForBytes(queue_data.size()));
+        fi.pos = d.pcm.writePos();
+        fi.size = d.pcm.write(queue_data.constData(), queue_data.size());
+        d.pushFrameInfo(fi);
+        return fi.size == queue_data.size();
+    }
+    d.pushFrameInfo(AudioOutputPrivate::FrameInfo(queue_data, pts, d.format.durationForBytes(queue_data.size())));
     return d.backend->write(queue_data); // backend is not null here
 }
 
@@ -612,6 +806,21 @@ AudioOutput::DeviceFeatures AudioOutput::supportedDeviceFeatures() const
 bool AudioOutput::waitForNextBuffer() // parameter bool wait: if no wait and no next buffer, return false
 {
     DPTR_D(AudioOutput);
+    if (d.pull) {
+        // the backend reads data in its callback. wait for free space, woken up by the callback
+        QElapsedTimer timer;
+        timer.start();
+        forever {
+            d.popConsumedFrames();
+            if (d.pcm.writable() >= bufferSize() && d.frame_infos.size() < d.frame_infos.capacity())
+                return true;
+            if (!d.available || timer.elapsed() > 1000) // callback is not running
+                return false;
+            d.pull_waiting.fetchAndStoreRelease(1);
+            d.uwait(d.format.durationForBytes(bufferSize()));
+            d.pull_waiting.fetchAndStoreRelease(0);
+        }
+    }
     if (d.frame_infos.empty())
         return true;
     //don't return even if we can add buffer because we don't know when a buffer is processed and we have /to update dequeue index
@@ -751,7 +960,7 @@ bool AudioOutput::waitForNextBuffer() // parameter bool wait: if no wait and no
 //                qWarning("buffer queue empty");
                 break;
             }
-            d.frame_infos.pop_front();
+            d.popFrameInfo();
             next = d.frame_infos.front().data.size();
         }
         //qDebug("remove: %d, unremoved bytes < %d, writable_bytes: %d", remove, free_bytes, d.processed_remain);
@@ -763,7 +972,7 @@ bool AudioOutput::waitForNextBuffer() // parameter bool wait: if no wait and no
 //            qWarning("empty. can not pop!");
             break;
         }
-        d.frame_infos.pop_front();
+        d.popFrameInfo();
     }
     return true;
 }
@@ -772,7 +981,28 @@ bool AudioOutput::waitForNextBuffer() // parameter bool wait: if no wait and no
 qreal AudioOutput::timestamp() const
 {
     DPTR_D(const AudioOutput);
-    return d.frame_infos.front().timestamp;
+    if (!d.pull)
+        return d.frame_infos.front().timestamp;
+    // timestamp of the next sample to be read by the backend
+    const quint32 r = d.pcm.readPos();
+    for (size_t i = 0; i < d.frame_infos.size(); ++i) {
+        const AudioOutputPrivate::FrameInfo &fi = d.frame_infos.at(i);
+        const int consumed = int(r - fi.pos);
+        if (consumed < fi.size)
+            return fi.timestamp + (consumed > 0 ? qreal(d.format.durationForBytes(consumed))/1000000.0 : 0.0);
+    }
+    if (d.frame_infos.empty())
+        return 0;
+    const AudioOutputPrivate::FrameInfo &fi = d.frame_infos.back();
+    return fi.timestamp + qreal(fi.duration)/1000000.0;
+}
+
+void AudioOutput::rebaseTimestamps(qreal end)
+{
+    DPTR_D(AudioOutput);
+    // frame_infos is only modified by the thread queuing data. published here and applied there before the next data
+    d.rebase_end = end;
+    d.rebase_pending.fetchAndStoreRelease(1);
 }
 
 void AudioOutput::reportVolume(qreal value)
@@ -801,4 +1031,21 @@ void AudioOutput::onCallback()
 {
     d_func().onCallback();
 }
+
+int AudioOutput::pullData(char *data, int maxBytes)
+{
+    DPTR_D(AudioOutput);
+    int bytes = 0;
+    if (!atomicLoad(d.pull_paused)) // called in backend thread
+        bytes = d.pcm.read(data, maxBytes);
+    if (bytes < maxBytes) {
+        const char c = (d.format.sampleFormat() == AudioFormat::SampleFormat_Unsigned8
+                        || d.format.sampleFormat() == AudioFormat::SampleFormat_Unsigned8Planar)
+                ? 0x80 : 0;
+        memset(data + bytes, c, maxBytes - bytes);
+    }
+    if (atomicLoad(d.pull_waiting))
+        d.cond.wakeAll();
+    return bytes;
+}
 } //namespace QtAV
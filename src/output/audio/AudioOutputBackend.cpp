@@ -64,9 +64,20 @@ AudioOutputBackend::AudioOutputBackend(AudioOutput::DeviceFeatures f, QObject *p
 
 void AudioOutputBackend::onCallback()
 {
-    if (!audio)
+    AudioOutput *ao = audio; // load once. may be reset in another thread
+    if (!ao)
         return;
-    audio->onCallback();
+    ao->onCallback();
+}
+
+int AudioOutputBackend::pull(char *data, int bytes)
+{
+    AudioOutput *ao = audio; // load once. AudioOutput::close() resets it after the device is stopped
+    if (!ao) {
+        memset(data, 0, bytes);
+        return 0;
+    }
+    return ao->pullData(data, bytes);
 }
 
 
@@ -83,6 +94,12 @@ void AudioOutput_RegisterAll()
         return;
     extern bool RegisterAudioOutputBackendNull_Man();
     RegisterAudioOutputBackendNull_Man();
+    extern bool RegisterAudioOutputBackendNullPull_Man();
+    RegisterAudioOutputBackendNullPull_Man();
+    extern bool RegisterAudioOutputBackendMixer_Man();
+    RegisterAudioOutputBackendMixer_Man();
+    extern bool RegisterAudioOutputBackendMixerNull_Man();
+    RegisterAudioOutputBackendMixerNull_Man();
 #ifdef Q_OS_DARWIN
     extern bool RegisterAudioOutputBackendAudioToolbox_Man();
     RegisterAudioOutputBackendAudioToolbox_Man();
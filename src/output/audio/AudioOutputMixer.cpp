@@ -0,0 +1,460 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#include "QtAV/private/AudioOutputBackend.h"
+#include "QtAV/AudioResampler.h"
+#include "QtAV/private/mkid.h"
+#include "QtAV/private/factory.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MIXER_SSE 1
+#include <xmmintrin.h>
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define MIXER_NEON 1
+#include <arm_neon.h>
+#endif
+#include "utils/Logger.h"
+
+namespace QtAV {
+/*
+ * "Mixer" backend: many AudioOutputs share one device. Data written by each output is converted to the mix format and
+ * queued in a ring. A process-wide mixer thread mixes all rings with per-output gain and plays the result on one device
+ * opened by an internal AudioOutput with the default backends, so only one device stream is opened. Outputs are paced
+ * by the mixer (BytesCallback), which also drives their timestamps and clocks.
+ * "MixerNull" does the same without a device. The mixer thread is paced by a timer. Useful for headless tests.
+ */
+namespace {
+static const int kMixSampleRate = 48000;
+static const int kMixChannels = 2;
+static const int kPeriodFrames = 512;
+// the device is kept open for a while after the last input is removed, e.g. switching to the next file
+static const qint64 kIdleCloseMs = 3000;
+
+AudioFormat mixFormat()
+{
+    AudioFormat af;
+    af.setSampleFormat(AudioFormat::SampleFormat_Float);
+    af.setChannelLayout(AudioFormat::ChannelLayout_Stereo);
+    af.setChannels(kMixChannels);
+    af.setSampleRate(kMixSampleRate);
+    return af;
+}
+
+// dst[i] += src[i]*gain
+void mixSamples(float *dst, const float *src, int n, float gain)
+{
+    int i = 0;
+#if MIXER_SSE
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+#elif MIXER_NEON
+    const float32x4_t g = vdupq_n_f32(gain);
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(dst + i, vmlaq_f32(vld1q_f32(dst + i), vld1q_f32(src + i), g));
+#endif
+    for (; i < n; ++i)
+        dst[i] += src[i]*gain;
+}
+
+void clampSamples(float *data, int n)
+{
+    int i = 0;
+#if MIXER_SSE
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(data + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(data + i), lo), hi));
+#elif MIXER_NEON
+    const float32x4_t lo = vdupq_n_f32(-1.0f);
+    const float32x4_t hi = vdupq_n_f32(1.0f);
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(data + i, vminq_f32(vmaxq_f32(vld1q_f32(data + i), lo), hi));
+#endif
+    for (; i < n; ++i)
+        data[i] = qBound(-1.0f, data[i], 1.0f);
+}
+
+class AudioMixer;
+} //namespace
+
+static const char kName[] = "Mixer";
+class AudioOutputMixer : public AudioOutputBackend
+{
+public:
+    AudioOutputMixer(QObject *parent = 0);
+    ~AudioOutputMixer();
+    QString name() const Q_DECL_OVERRIDE { return QLatin1String(kName);}
+    bool open() Q_DECL_OVERRIDE;
+    bool close() Q_DECL_OVERRIDE;
+    bool isSupported(AudioFormat::SampleFormat f) const Q_DECL_OVERRIDE { return !IsPlanar(f);}
+    BufferControl bufferControl() const Q_DECL_OVERRIDE { return BytesCallback;}
+    bool write(const QByteArray& data) Q_DECL_OVERRIDE;
+    bool play() Q_DECL_OVERRIDE { return true;}
+    bool clear() Q_DECL_OVERRIDE;
+    int getWritableBytes() Q_DECL_OVERRIDE;
+    bool setVolume(qreal value) Q_DECL_OVERRIDE;
+    qreal getVolume() const Q_DECL_OVERRIDE;
+    bool setMute(bool value) Q_DECL_OVERRIDE;
+    bool getMute() const Q_DECL_OVERRIDE;
+    /// called in mixer thread. add at most \a frames frames to \a dst
+    void mixTo(float* dst, int frames);
+protected:
+    AudioOutputMixer(bool nullDevice, QObject *parent);
+private:
+    AudioMixer *m_mixer;
+    mutable QMutex m_mutex;
+    AudioResampler *m_conv;
+    AudioFormat m_mix_format;
+    QVector<float> m_ring; // samples in mix format
+    int m_read, m_size; // in samples
+    float m_gain;
+    bool m_mute;
+};
+
+typedef AudioOutputMixer AudioOutputBackendMixer;
+static const AudioOutputBackendId AudioOutputBackendId_Mixer = mkid::id32base36_5<'M', 'i', 'x', 'e', 'r'>::value;
+FACTORY_REGISTER(AudioOutputBackend, Mixer, kName)
+
+static const char kNameNull[] = "MixerNull";
+class AudioOutputMixerNull : public AudioOutputMixer
+{
+public:
+    AudioOutputMixerNull(QObject *parent = 0) : AudioOutputMixer(true, parent) {}
+    QString name() const Q_DECL_OVERRIDE { return QLatin1String(kNameNull);}
+};
+
+typedef AudioOutputMixerNull AudioOutputBackendMixerNull;
+static const AudioOutputBackendId AudioOutputBackendId_MixerNull = mkid::id32base36_6<'M', 'i', 'x', 'N', 'u', 'l'>::value;
+FACTORY_REGISTER(AudioOutputBackend, MixerNull, kNameNull)
+
+namespace {
+AudioMixer *g_mixers[2] = { 0, 0 };
+
+class AudioMixer : public QThread
+{
+public:
+    // never deleted. the thread stops kIdleCloseMs after the last input is removed, or when the application quits
+    static AudioMixer* instance(bool nullDevice) {
+        if (nullDevice) {
+            static AudioMixer *null_mixer = new AudioMixer(true);
+            return null_mixer;
+        }
+        static AudioMixer *mixer = new AudioMixer(false);
+        return mixer;
+    }
+    void addInput(AudioOutputMixer* input) {
+        QMutexLocker control_lock(&control_mutex);
+        Q_UNUSED(control_lock);
+        {
+            QMutexLocker lock(&mutex);
+            Q_UNUSED(lock);
+            if (!inputs.contains(input))
+                inputs.append(input);
+        }
+        if (stop || !isRunning()) { // stop is set if the thread is exiting because it was idle
+            wait();
+            stop = false;
+            start();
+        }
+    }
+    // the input is not mixed after return. the thread keeps running for a grace period
+    void removeInput(AudioOutputMixer* input) {
+        QMutexLocker lock(&mutex);
+        Q_UNUSED(lock);
+        inputs.removeAll(input);
+    }
+    static void shutdown() {
+        for (int i = 0; i < 2; ++i) {
+            AudioMixer *m = g_mixers[i];
+            if (!m)
+                continue;
+            QMutexLocker control_lock(&m->control_mutex);
+            Q_UNUSED(control_lock);
+            m->stop = true;
+            m->wait();
+        }
+    }
+protected:
+    void run() Q_DECL_OVERRIDE {
+        const AudioFormat fmt(mixFormat());
+        QScopedPointer<AudioOutput> ao;
+        QScopedPointer<AudioResampler> conv;
+        if (!null_device) {
+            ao.reset(new AudioOutput());
+            const AudioFormat af(ao->setAudioFormat(fmt));
+            ao->setBufferSamples(kPeriodFrames*fmt.channels());
+            if (!ao->open()) {
+                qWarning("AudioMixer: failed to open audio device. Fallback to null device");
+                ao.reset();
+            } else if (af != fmt) {
+                conv.reset(AudioResampler::create(AudioResamplerId_FF));
+                if (!conv)
+                    conv.reset(AudioResampler::create(AudioResamplerId_Libav));
+                if (conv) {
+                    conv->setInAudioFormat(fmt);
+                    conv->setOutAudioFormat(af);
+                }
+            }
+            qDebug("AudioMixer: device %s", ao ? qPrintable(ao->backend()) : "null");
+        }
+        const int period_samples = kPeriodFrames*fmt.channels();
+        const qint64 period_us = qint64(kPeriodFrames)*1000000LL/qint64(fmt.sampleRate());
+        QVector<float> mix(period_samples);
+        QElapsedTimer timer;
+        timer.start();
+        QElapsedTimer idle;
+        qint64 next_us = 0;
+        while (!stop) {
+            mix.fill(0);
+            {
+                QMutexLocker lock(&mutex);
+                Q_UNUSED(lock);
+                if (!inputs.isEmpty()) {
+                    idle.invalidate();
+                } else if (!idle.isValid()) {
+                    idle.start();
+                } else if (idle.elapsed() >= kIdleCloseMs) {
+                    stop = true; // under the lock, so addInput() sees it and restarts the thread
+                    break;
+                }
+                foreach (AudioOutputMixer* input, inputs) {
+                    input->mixTo(mix.data(), kPeriodFrames);
+                }
+            }
+            clampSamples(mix.data(), period_samples);
+            if (ao) {
+                // the device blocks until the next buffer can be written
+                if (conv) {
+                    const quint8 *src = (const quint8*)mix.constData();
+                    conv->setInSampesPerChannel(kPeriodFrames);
+                    if (conv->convert(&src))
+                        ao->play(conv->outData());
+                } else {
+                    ao->play(QByteArray((const char*)mix.constData(), period_samples*sizeof(float)));
+                }
+                continue;
+            }
+            next_us += period_us;
+            const qint64 wait_us = next_us - timer.elapsed()*1000LL;
+            if (wait_us > 0)
+                usleep((unsigned long)wait_us);
+            else if (wait_us < -8*period_us) // too late, e.g. suspended. do not catch up
+                next_us = timer.elapsed()*1000LL;
+        }
+        if (ao)
+            ao->close();
+    }
+private:
+    AudioMixer(bool nullDevice) : null_device(nullDevice), stop(false) {
+        g_mixers[nullDevice ? 1 : 0] = this;
+        qAddPostRoutine(shutdown);
+    }
+
+    bool null_device;
+    volatile bool stop;
+    QMutex control_mutex; // serializes start/stop in addInput and shutdown
+    QMutex mutex; // protects inputs
+    QList<AudioOutputMixer*> inputs;
+};
+} //namespace
+
+AudioOutputMixer::AudioOutputMixer(QObject *parent)
+    : AudioOutputBackend(AudioOutput::SetVolume | AudioOutput::SetMute, parent)
+    , m_mixer(AudioMixer::instance(false))
+    , m_conv(0)
+    , m_mix_format(mixFormat())
+    , m_read(0)
+    , m_size(0)
+    , m_gain(1.0f)
+    , m_mute(false)
+{}
+
+AudioOutputMixer::AudioOutputMixer(bool nullDevice, QObject *parent)
+    : AudioOutputBackend(AudioOutput::SetVolume | AudioOutput::SetMute, parent)
+    , m_mixer(AudioMixer::instance(nullDevice))
+    , m_conv(0)
+    , m_mix_format(mixFormat())
+    , m_read(0)
+    , m_size(0)
+    , m_gain(1.0f)
+    , m_mute(false)
+{}
+
+AudioOutputMixer::~AudioOutputMixer()
+{
+    close();
+}
+
+bool AudioOutputMixer::open()
+{
+    close();
+    if (format != m_mix_format) {
+        m_conv = AudioResampler::create(AudioResamplerId_FF);
+        if (!m_conv)
+            m_conv = AudioResampler::create(AudioResamplerId_Libav);
+        if (!m_conv) {
+            qWarning("AudioOutputMixer: no audio resampler is available");
+            return false;
+        }
+        m_conv->setInAudioFormat(format);
+        m_conv->setOutAudioFormat(m_mix_format);
+    }
+    {
+        QMutexLocker lock(&m_mutex);
+        Q_UNUSED(lock);
+        // buffer_size*buffer_count in the input format, and some space for resampler delay
+        const qint64 frames = qint64(buffer_size)*qint64(buffer_count)/qMax(1, format.bytesPerFrame());
+        const qint64 mix_frames = frames*m_mix_format.sampleRate()/qMax(1, format.sampleRate()) + kPeriodFrames;
+        m_ring.resize(mix_frames*m_mix_format.channels());
+        m_read = m_size = 0;
+    }
+    m_mixer->addInput(this);
+    return true;
+}
+
+bool AudioOutputMixer::close()
+{
+    m_mixer->removeInput(this);
+    if (m_conv) {
+        delete m_conv;
+        m_conv = 0;
+    }
+    QMutexLocker lock(&m_mutex);
+    Q_UNUSED(lock);
+    m_ring.clear();
+    m_read = m_size = 0;
+    return true;
+}
+
+bool AudioOutputMixer::write(const QByteArray &data)
+{
+    QByteArray mix_data(data);
+    if (m_conv) {
+        const quint8 *in = (const quint8*)data.constData();
+        m_conv->setInSampesPerChannel(data.size()/qMax(1, format.bytesPerFrame()));
+        if (!m_conv->convert(&in))
+            return false;
+        mix_data = m_conv->outData();
+    }
+    const float *src = (const float*)mix_data.constData();
+    int samples = mix_data.size()/sizeof(float);
+    QMutexLocker lock(&m_mutex);
+    Q_UNUSED(lock);
+    const int cap = m_ring.size();
+    if (cap <= 0)
+        return false;
+    if (samples > cap - m_size) { // should not happen because of getWritableBytes(). drop the oldest
+        const int drop = qMin(m_size, samples - (cap - m_size));
+        m_read = (m_read + drop) % cap;
+        m_size -= drop;
+        samples = qMin(samples, cap);
+    }
+    int w = (m_read + m_size) % cap;
+    for (int left = samples; left > 0;) {
+        const int n = qMin(left, cap - w);
+        memcpy(m_ring.data() + w, src, n*sizeof(float));
+        src += n;
+        left -= n;
+        w = (w + n) % cap;
+    }
+    m_size += samples;
+    return true;
+}
+
+bool AudioOutputMixer::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    Q_UNUSED(lock);
+    m_read = m_size = 0;
+    return true;
+}
+
+int AudioOutputMixer::getWritableBytes()
+{
+    QMutexLocker lock(&m_mutex);
+    Q_UNUSED(lock);
+    if (m_ring.isEmpty())
+        return -1;
+    // free space in mix format to bytes in input format. rounded, the ring has kPeriodFrames more for resampler delay
+    const qint64 free_frames = (m_ring.size() - m_size)/m_mix_format.channels();
+    const qint64 in_frames = (free_frames*qint64(format.sampleRate()) + m_mix_format.sampleRate()/2)/qint64(m_mix_format.sampleRate());
+    return in_frames*format.bytesPerFrame();
+}
+
+bool AudioOutputMixer::setVolume(qreal value)
+{
+    QMutexLocker lock(&m_mutex);
+    Q_UNUSED(lock);
+    m_gain = float(value);
+    return true;
+}
+
+qreal AudioOutputMixer::getVolume() const
+{
+    QMutexLocker lock(&m_mutex);
+    Q_UNUSED(lock);
+    return m_gain;
+}
+
+bool AudioOutputMixer::setMute(bool value)
+{
+    QMutexLocker lock(&m_mutex);
+    Q_UNUSED(lock);
+    m_mute = value;
+    return true;
+}
+
+bool AudioOutputMixer::getMute() const
+{
+    QMutexLocker lock(&m_mutex);
+    Q_UNUSED(lock);
+    return m_mute;
+}
+
+void AudioOutputMixer::mixTo(float *dst, int frames)
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        Q_UNUSED(lock);
+        const int cap = m_ring.size();
+        const int samples = qMin(m_size, frames*m_mix_format.channels());
+        if (samples <= 0)
+            return;
+        const float gain = m_mute ? 0.0f : m_gain;
+        for (int left = samples; left > 0;) {
+            const int n = qMin(left, cap - m_read);
+            if (gain != 0.0f)
+                mixSamples(dst, m_ring.constData() + m_read, n, gain);
+            dst += n;
+            left -= n;
+            m_read = (m_read + n) % cap;
+        }
+        m_size -= samples;
+    }
+    onCallback(); // wake up AudioOutput::waitForNextBuffer()
+}
+} //namespace QtAV
@@ -22,6 +22,8 @@
 #include "QtAV/private/AudioOutputBackend.h"
 #include "QtAV/private/mkid.h"
 #include "QtAV/private/factory.h"
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThread>
 
 namespace QtAV {
 //TODO: block internally
@@ -48,4 +50,82 @@ AudioOutputNull::AudioOutputNull(QObject *parent)
     : AudioOutputBackend(AudioOutput::DeviceFeatures(), parent)
 {}
 
+/*
+ * Pull control without a device. Data is consumed in real time by a timer thread which emulates a device callback.
+ * Useful to test the pull model and A/V sync without audio hardware.
+ */
+static const char kNamePull[] = "NullPull";
+class AudioOutputNullPull : public AudioOutputBackend
+{
+public:
+    AudioOutputNullPull(QObject *parent = 0);
+    ~AudioOutputNullPull() { close();}
+    QString name() const Q_DECL_OVERRIDE { return QLatin1String(kNamePull);}
+    bool open() Q_DECL_OVERRIDE;
+    bool close() Q_DECL_OVERRIDE;
+    BufferControl bufferControl() const Q_DECL_OVERRIDE { return Pull;}
+    bool write(const QByteArray&) Q_DECL_OVERRIDE { return true;}
+    bool play() Q_DECL_OVERRIDE { return true;}
+private:
+    class Clock : public QThread {
+    public:
+        Clock(AudioOutputNullPull *ao) : m_ao(ao), m_stop(false) {}
+        void stop() { m_stop = true;}
+    protected:
+        void run() Q_DECL_OVERRIDE;
+    private:
+        AudioOutputNullPull *m_ao;
+        volatile bool m_stop;
+    };
+    Clock *m_clock;
+};
+
+typedef AudioOutputNullPull AudioOutputBackendNullPull;
+static const AudioOutputBackendId AudioOutputBackendId_NullPull = mkid::id32base36_6<'N', 'u', 'l', 'l', 'P', 'l'>::value;
+FACTORY_REGISTER(AudioOutputBackend, NullPull, kNamePull)
+
+AudioOutputNullPull::AudioOutputNullPull(QObject *parent)
+    : AudioOutputBackend(AudioOutput::DeviceFeatures(), parent)
+    , m_clock(0)
+{}
+
+bool AudioOutputNullPull::open()
+{
+    close();
+    m_clock = new Clock(this);
+    m_clock->start();
+    return true;
+}
+
+bool AudioOutputNullPull::close()
+{
+    if (!m_clock)
+        return true;
+    m_clock->stop();
+    m_clock->wait();
+    delete m_clock;
+    m_clock = 0;
+    return true;
+}
+
+void AudioOutputNullPull::Clock::run()
+{
+    // read a period of data like a device callback
+    const int bytes = qMax(m_ao->format.bytesPerFrame(), m_ao->buffer_size);
+    const qint64 period_us = qMax<qint64>(1000, m_ao->format.durationForBytes(bytes));
+    QByteArray data(bytes, 0);
+    QElapsedTimer timer;
+    timer.start();
+    qint64 next_us = 0;
+    while (!m_stop) {
+        m_ao->pull(data.data(), data.size());
+        next_us += period_us;
+        const qint64 wait_us = next_us - timer.elapsed()*1000LL;
+        if (wait_us > 0)
+            usleep((unsigned long)wait_us);
+        else if (wait_us < -8*period_us) // too late, do not catch up
+            next_us = timer.elapsed()*1000LL;
+    }
+}
+
 } //namespace QtAV
@@ -39,8 +39,10 @@ public:
     bool close() Q_DECL_FINAL;
     virtual BufferControl bufferControl() const Q_DECL_FINAL;
     virtual bool write(const QByteArray& data) Q_DECL_FINAL;
-    virtual bool play() Q_DECL_FINAL { return true;}
+    virtual bool play() Q_DECL_FINAL;
 private:
+    static int callback(const void *input, void *output, unsigned long frames, const PaStreamCallbackTimeInfo *timeInfo, PaStreamCallbackFlags statusFlags, void *userData);
+
     bool initialized;
     PaStreamParameters *outputParameters;
     PaStream *stream;
@@ -97,21 +99,37 @@ AudioOutputPortAudio::~AudioOutputPortAudio()
 
 AudioOutputBackend::BufferControl AudioOutputPortAudio::bufferControl() const
 {
-    return Blocking;
+    return Pull;
 }
 
 bool AudioOutputPortAudio::write(const QByteArray& data)
 {
-    if (Pa_IsStreamStopped(stream))
-        Pa_StartStream(stream);
-    PaError err = Pa_WriteStream(stream, data.constData(), data.size()/format.channels()/format.bytesPerSample());
-    if (err == paUnanticipatedHostError) {
-        qWarning("Write portaudio stream error: %s", Pa_GetErrorText(err));
-        return   false;
+    Q_UNUSED(data); // data is read in callback()
+    return true;
+}
+
+bool AudioOutputPortAudio::play()
+{
+    if (!Pa_IsStreamStopped(stream))
+        return true;
+    PaError err = Pa_StartStream(stream);
+    if (err != paNoError) {
+        qWarning("Start portaudio stream error: %s", Pa_GetErrorText(err));
+        return false;
     }
     return true;
 }
 
+int AudioOutputPortAudio::callback(const void *input, void *output, unsigned long frames, const PaStreamCallbackTimeInfo *timeInfo, PaStreamCallbackFlags statusFlags, void *userData)
+{
+    Q_UNUSED(input);
+    Q_UNUSED(timeInfo);
+    Q_UNUSED(statusFlags);
+    AudioOutputPortAudio *pa = static_cast<AudioOutputPortAudio*>(userData);
+    pa->pull((char*)output, int(frames)*pa->format.bytesPerFrame());
+    return paContinue;
+}
+
 //TODO: what about planar, int8, int24 etc that FFmpeg or Pa not support?
 static int toPaSampleFormat(AudioFormat::SampleFormat format)
 {
@@ -134,7 +152,7 @@ bool AudioOutputPortAudio::open()
 {
     outputParameters->sampleFormat = toPaSampleFormat(format.sampleFormat());
     outputParameters->channelCount = format.channels();
-    PaError err = Pa_OpenStream(&stream, NULL, outputParameters, format.sampleRate(), 0, paNoFlag, NULL, NULL);
+    PaError err = Pa_OpenStream(&stream, NULL, outputParameters, format.sampleRate(), paFramesPerBufferUnspecified, paNoFlag, callback, this);
     if (err != paNoError) {
         qWarning("Open portaudio stream error: %s", Pa_GetErrorText(err));
         return false;
@@ -79,6 +79,7 @@ bool OpenGLRendererBase::receiveFrame(const VideoFrame& frame)
     DPTR_D(OpenGLRendererBase);
     d.video_frame = frame;
     d.frame_changed = true;
+    d.glv.prepareFrame(frame); // copy to gl buffer here but not in rendering thread
     updateUi(); //can not call updateGL() directly because no event and paintGL() will in video thread
     return true;
 }
@@ -22,6 +22,9 @@
 #include <QtAV/QPainterRenderer.h>
 #include <QtAV/private/QPainterRenderer_p.h>
 #include <QtAV/FilterContext.h>
+#include <QtAV/private/FusedConvert.h>
+#include "ColorTransform.h"
+#include "utils/ColorAdjust.h"
 
 namespace QtAV {
 
@@ -40,16 +43,98 @@ QPainterRenderer::QPainterRenderer(QPainterRendererPrivate &d)
 
 bool QPainterRenderer::isSupported(VideoFormat::PixelFormat pixfmt) const
 {
+    if (d_func().prescale && canFusedConvert(VideoFormat(pixfmt)))
+        return true;
     return VideoFormat::imageFormatFromPixelFormat(pixfmt) != QImage::Format_Invalid;
 }
 
+void QPainterRenderer::setPrescale(bool value)
+{
+    DPTR_D(QPainterRenderer);
+    if (d.prescale == value)
+        return;
+    d.prescale = value;
+    if (!value) {
+        d.frame_orig = VideoFrame();
+        d.scaled_frame = VideoFrame();
+        d.fused_image = QImage();
+    }
+    updateUi();
+}
+
+bool QPainterRenderer::isPrescale() const
+{
+    return d_func().prescale;
+}
+
 bool QPainterRenderer::preparePixmap(const VideoFrame &frame)
 {
     DPTR_D(QPainterRenderer);
     // already locked in a larger scope of receive()
     QImage::Format imgfmt = frame.imageFormat();
-    if (frame.constBits(0)) {
+    d.pixmap_scaled = false;
+    d.frame_orig = frame;
+    const bool eq = d.brightness != 0 || d.contrast != 0 || d.hue != 0 || d.saturation != 0;
+    ColorTransform ct;
+    ct.setBrightness(d.brightness);
+    ct.setContrast(d.contrast);
+    ct.setHue(d.hue);
+    ct.setSaturation(d.saturation);
+    if (d.prescale) {
+        const QSize dst(d.out_rect.size());
+        // compare with the source size. realROI() without a roi is the size of d.video_frame, which must be the source frame
+        const bool whole = !d.roi.isValid() || realROI() == QRect(0, 0, d.src_width, d.src_height);
+        if (d.rotation() == 0 && !dst.isEmpty() && whole && frame.constBits(0) && canFusedConvert(frame.format())) {
+            // yuv to rgb, scale and eq in one pass. release the previous pixmap so the image is not detached
+            d.pixmap = QPixmap();
+            d.scaled_frame = VideoFrame();
+            if (d.fused_image.size() != dst)
+                d.fused_image = QImage(dst, QImage::Format_RGB32);
+            ct.setInputColorSpace(frame.colorSpace() == ColorSpace_BT709 ? ColorSpace_BT709 : ColorSpace_BT601);
+            ct.setInputColorRange(frame.colorRange() == ColorRange_Full ? ColorRange_Full : ColorRange_Limited);
+            ct.setOutputColorSpace(ColorSpace_RGB);
+            ct.setOutputColorRange(ColorRange_Full);
+            if (!d.fused_image.isNull()
+                    && fusedConvertRGB32(frame, ct.matrixRef(), d.fused_image.bits(), d.fused_image.bytesPerLine(), dst)) {
+                d.video_frame = frame; // the source frame for roi, mapToFrame() and filters
+                d.pixmap_scaled = true;
+                d.pixmap = QPixmap::fromImage(d.fused_image);
+                return true;
+            }
+        }
+        if (d.rotation() == 0 && !dst.isEmpty() && dst != frame.size() && whole) {
+            // keep rgb formats supported by QImage, e.g. with alpha. swapped rgb formats are converted
+            VideoFormat::PixelFormat pixfmt = VideoFormat::Format_RGB32;
+            if (imgfmt > QImage::Format_Invalid && frame.constBits(0))
+                pixfmt = frame.pixelFormat();
+            d.scaled_frame = d.conv.convert(frame, pixfmt, dst);
+            if (d.scaled_frame.isValid()) {
+                if (eq && colorAdjustSupported(d.scaled_frame.format())) // converter's buffer
+                    colorAdjust(d.scaled_frame, d.scaled_frame, ct.matrixRef());
+                d.video_frame = frame;
+                d.pixmap_scaled = true;
+                d.pixmap = QPixmap::fromImage(QImage((uchar*)d.scaled_frame.constBits(), d.scaled_frame.width(), d.scaled_frame.height(), d.scaled_frame.bytesPerLine(), d.scaled_frame.imageFormat()));
+                return true;
+            }
+        }
+    }
+    if (frame.constBits(0) && imgfmt != QImage::Format_Invalid) {
         d.video_frame = frame;
+        if (eq && colorAdjustSupported(frame.format())) {
+            // reused like fused_image. release the pixmap of the previous frame first
+            d.pixmap = QPixmap();
+            if (d.adjusted_frame.format() != frame.format() || d.adjusted_frame.size() != frame.size()) {
+                d.adjusted_frame = VideoFrame(frame.width(), frame.height(), frame.format());
+                if (!d.adjusted_frame.allocate())
+                    d.adjusted_frame = VideoFrame();
+            }
+            if (d.adjusted_frame.isValid() && colorAdjust(frame, d.adjusted_frame, ct.matrixRef())) {
+                d.adjusted_frame.setTimestamp(frame.timestamp());
+                d.video_frame = d.adjusted_frame;
+            }
+        } else {
+            d.adjusted_frame = VideoFrame();
+        }
     } else {
         if (imgfmt == QImage::Format_Invalid) {
             d.video_frame = frame.to(VideoFormat::Format_RGB32);
@@ -57,6 +142,8 @@ bool QPainterRenderer::preparePixmap(const VideoFrame &frame)
         } else {
             d.video_frame = frame.to(frame.pixelFormat());
         }
+        if (eq && colorAdjustSupported(d.video_frame.format()))
+            colorAdjust(d.video_frame, d.video_frame, ct.matrixRef());
     }
     const bool swapRGB = (int)imgfmt < 0;
     if (swapRGB) {
@@ -74,7 +161,7 @@ bool QPainterRenderer::preparePixmap(const VideoFrame &frame)
 void QPainterRenderer::drawBackground()
 {
     DPTR_D(QPainterRenderer);
-    if (!d.painter)
+    if (!d.painter || !d.update_background)
         return;
     const QRegion bgRegion(backgroundRegion());
     if (bgRegion.isEmpty())
@@ -99,6 +186,14 @@ void QPainterRenderer::drawFrame()
         return;
     if (d.pixmap.isNull())
         return;
+    if (d.pixmap_scaled) {
+        // scaled for the previous video rect if resized after prepared
+        if (d.pixmap.size() == d.out_rect.size())
+            d.painter->drawPixmap(d.out_rect.topLeft(), d.pixmap);
+        else
+            d.painter->drawPixmap(d.out_rect, d.pixmap);
+        return;
+    }
     QRect roi = realROI();
     if (d.rotation() == 0) {
         //assume that the image data is already scaled to out_size(NOT renderer size!)
@@ -126,4 +221,58 @@ void QPainterRenderer::drawFrame()
     d.painter->restore();
 }
 
+void QPainterRenderer::onResizeRenderer(int width, int height)
+{
+    Q_UNUSED(width);
+    Q_UNUSED(height);
+    DPTR_D(QPainterRenderer);
+    if (!d.prescale)
+        return;
+    QMutexLocker lock(&d.img_mutex);
+    Q_UNUSED(lock);
+    if (d.frame_orig.isValid())
+        preparePixmap(d.frame_orig);
+}
+
+bool QPainterRenderer::onSetBrightness(qreal b)
+{
+    DPTR_D(QPainterRenderer);
+    updateEQ(b, d.contrast, d.hue, d.saturation);
+    return true;
+}
+
+bool QPainterRenderer::onSetContrast(qreal c)
+{
+    DPTR_D(QPainterRenderer);
+    updateEQ(d.brightness, c, d.hue, d.saturation);
+    return true;
+}
+
+bool QPainterRenderer::onSetHue(qreal h)
+{
+    DPTR_D(QPainterRenderer);
+    updateEQ(d.brightness, d.contrast, h, d.saturation);
+    return true;
+}
+
+bool QPainterRenderer::onSetSaturation(qreal s)
+{
+    DPTR_D(QPainterRenderer);
+    updateEQ(d.brightness, d.contrast, d.hue, s);
+    return true;
+}
+
+void QPainterRenderer::updateEQ(qreal b, qreal c, qreal h, qreal s)
+{
+    DPTR_D(QPainterRenderer);
+    QMutexLocker lock(&d.img_mutex);
+    Q_UNUSED(lock);
+    // VideoRenderer::setXXX() assigns the value again after return. preparePixmap() needs it now
+    d.brightness = b;
+    d.contrast = c;
+    d.hue = h;
+    d.saturation = s;
+    if (d.frame_orig.isValid())
+        preparePixmap(d.frame_orig);
+}
 } //namespace QtAV
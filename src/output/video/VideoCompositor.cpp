@@ -0,0 +1,392 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#include "QtAV/VideoCompositor.h"
+#include "QtAV/private/VideoRenderer_p.h"
+#include "QtAV/private/mkid.h"
+#include "QtAV/OpenGLVideo.h"
+#include <algorithm>
+#include <cmath>
+#include <QtCore/QElapsedTimer>
+#include <QtGui/QOpenGLContext>
+#include "opengl/OpenGLHelper.h"
+#include "utils/Logger.h"
+
+namespace QtAV {
+static const VideoRendererId VideoRendererId_CompositorTile = mkid::id32base36_6<'C', 'o', 'm', 'p', 'T', 'l'>::value;
+
+class CompositorTilePrivate : public VideoRendererPrivate
+{
+public:
+    CompositorTilePrivate()
+        : compositor(0)
+        , frame_changed(false)
+        , format(VideoFormat::Format_Invalid)
+    {}
+    void setupAspectRatio() {
+        matrix.setToIdentity();
+        if (renderer_width <= 0 || renderer_height <= 0)
+            return;
+        matrix.scale((GLfloat)out_rect.width()/(GLfloat)renderer_width, (GLfloat)out_rect.height()/(GLfloat)renderer_height, 1);
+        if (rotation())
+            matrix.rotate(rotation(), 0, 0, 1); // Z axis
+    }
+
+    VideoCompositor *compositor;
+    OpenGLVideo glv;
+    VideoFrame video_frame; // guarded by img_mutex
+    bool frame_changed;
+    VideoFormat::PixelFormat format; // format of the frame set to glv
+    QRectF rect; // normalized. invalid: grid cell
+    QRect cell; // in pixels, top-left origin
+    QMatrix4x4 matrix;
+};
+
+class CompositorTile : public VideoRenderer
+{
+    DPTR_DECLARE_PRIVATE(CompositorTile)
+public:
+    CompositorTile(VideoCompositor *compositor)
+        : VideoRenderer(*new CompositorTilePrivate())
+    {
+        d_func().compositor = compositor;
+        setPreferredPixelFormat(VideoFormat::Format_YUV420P);
+    }
+    ~CompositorTile() {
+        d_func().glv.setOpenGLContext(0);
+    }
+    VideoRendererId id() const Q_DECL_OVERRIDE { return VideoRendererId_CompositorTile; }
+    bool isSupported(VideoFormat::PixelFormat pixfmt) const Q_DECL_OVERRIDE { return OpenGLVideo::isSupported(pixfmt); }
+    OpenGLVideo* opengl() const Q_DECL_OVERRIDE { return const_cast<OpenGLVideo*>(&d_func().glv); }
+    /*!
+     * update texture of the new frame, layout and transform in rendering thread.
+     * \return false if nothing to draw
+     */
+    bool prepare(const QRect& cell, const QSize& viewport) {
+        DPTR_D(CompositorTile);
+        QOpenGLContext *ctx = QOpenGLContext::currentContext();
+        if (d.glv.openGLContext() != ctx) {
+            d.glv.setOpenGLContext(ctx);
+            d.cell = QRect(); // viewport is reset
+        }
+        if (d.cell != cell) {
+            d.cell = cell;
+            resizeRenderer(cell.size());
+            d.setupAspectRatio();
+            // gl viewport origin is bottom-left
+            d.glv.setViewport(QRectF(cell.x(), viewport.height() - cell.y() - cell.height(), cell.width(), cell.height()));
+        }
+        VideoFrame frame;
+        {
+            QMutexLocker lock(&d.img_mutex);
+            Q_UNUSED(lock);
+            if (d.frame_changed)
+                frame = d.video_frame;
+            d.frame_changed = false;
+        }
+        if (frame.isValid()) {
+            d.glv.setCurrentFrame(frame);
+            d.format = frame.pixelFormat();
+        }
+        return d.format != VideoFormat::Format_Invalid && !cell.isEmpty();
+    }
+    void draw() {
+        DPTR_D(CompositorTile);
+        d.glv.render(QRectF(), realROI(), d.matrix);
+    }
+    VideoFormat::PixelFormat format() const { return d_func().format; }
+    QRect cell() const { return d_func().cell; }
+    QRectF rect() const { return d_func().rect; }
+    void setRect(const QRectF& r) { d_func().rect = r; }
+    void reset() { // context is about to be destroyed
+        DPTR_D(CompositorTile);
+        d.glv.setOpenGLContext(0);
+        d.cell = QRect();
+        d.format = VideoFormat::Format_Invalid;
+        QMutexLocker lock(&d.img_mutex);
+        Q_UNUSED(lock);
+        d.frame_changed = d.video_frame.isValid(); // upload again in the new context
+    }
+protected:
+    bool receiveFrame(const VideoFrame& frame) Q_DECL_OVERRIDE {
+        DPTR_D(CompositorTile);
+        d.video_frame = frame;
+        d.frame_changed = true;
+        d.glv.prepareFrame(frame);
+        updateUi();
+        return true;
+    }
+    void drawFrame() Q_DECL_OVERRIDE {} // drawn by VideoCompositor::render()
+    void updateUi() Q_DECL_OVERRIDE {
+        d_func().compositor->requestUpdate();
+    }
+private:
+    void onSetOutAspectRatioMode(OutAspectRatioMode mode) Q_DECL_OVERRIDE {
+        Q_UNUSED(mode);
+        d_func().setupAspectRatio();
+    }
+    void onSetOutAspectRatio(qreal ratio) Q_DECL_OVERRIDE {
+        Q_UNUSED(ratio);
+        d_func().setupAspectRatio();
+    }
+    bool onSetOrientation(int value) Q_DECL_OVERRIDE {
+        Q_UNUSED(value);
+        d_func().setupAspectRatio();
+        return true;
+    }
+    bool onSetBrightness(qreal b) Q_DECL_OVERRIDE {
+        d_func().glv.setBrightness(b);
+        return true;
+    }
+    bool onSetContrast(qreal c) Q_DECL_OVERRIDE {
+        d_func().glv.setContrast(c);
+        return true;
+    }
+    bool onSetHue(qreal h) Q_DECL_OVERRIDE {
+        d_func().glv.setHue(h);
+        return true;
+    }
+    bool onSetSaturation(qreal s) Q_DECL_OVERRIDE {
+        d_func().glv.setSaturation(s);
+        return true;
+    }
+};
+
+static bool formatLessThan(const QPair<int, CompositorTile*>& a, const QPair<int, CompositorTile*>& b)
+{
+    return a.first < b.first;
+}
+
+class VideoCompositor::Private
+{
+public:
+    Private()
+        : spacing(0)
+        , background(Qt::black)
+        , ctx(0)
+        , render_time(0)
+        , update_pending(0)
+    {}
+    QRect cellRect(int index, const QSize& viewport) const {
+        const int n = tiles.size();
+        int cols = grid.width();
+        int rows = grid.height();
+        if (cols <= 0 || rows <= 0) {
+            cols = qMax(1, (int)std::ceil(std::sqrt((qreal)n)));
+            rows = qMax(1, (n + cols - 1)/cols);
+        }
+        if (index >= cols*rows)
+            return QRect();
+        const int w = (viewport.width() - spacing*(cols - 1))/cols;
+        const int h = (viewport.height() - spacing*(rows - 1))/rows;
+        return QRect((index % cols)*(w + spacing), (index / cols)*(h + spacing), w, h);
+    }
+
+    QList<CompositorTile*> tiles;
+    QSize grid;
+    int spacing;
+    QColor background;
+    QOpenGLContext *ctx;
+    QSize viewport;
+    qint64 render_time;
+    QAtomicInt update_pending;
+};
+
+VideoCompositor::VideoCompositor(QObject *parent)
+    : QObject(parent)
+    , d(new Private())
+{
+}
+
+VideoCompositor::~VideoCompositor()
+{
+    qDeleteAll(d->tiles);
+    d->tiles.clear();
+    delete d;
+    d = 0;
+}
+
+VideoRenderer* VideoCompositor::addTile()
+{
+    CompositorTile *tile = new CompositorTile(this);
+    d->tiles.append(tile);
+    d->viewport = QSize(); // relayout
+    requestUpdate();
+    return tile;
+}
+
+void VideoCompositor::removeTile(VideoRenderer *tile)
+{
+    const int idx = d->tiles.indexOf(static_cast<CompositorTile*>(tile));
+    if (idx < 0)
+        return;
+    delete d->tiles.takeAt(idx);
+    d->viewport = QSize();
+    requestUpdate();
+}
+
+int VideoCompositor::tileCount() const
+{
+    return d->tiles.size();
+}
+
+VideoRenderer* VideoCompositor::tile(int index) const
+{
+    return d->tiles.value(index, 0);
+}
+
+void VideoCompositor::setGridSize(const QSize &value)
+{
+    if (d->grid == value)
+        return;
+    d->grid = value;
+    d->viewport = QSize();
+    requestUpdate();
+}
+
+QSize VideoCompositor::gridSize() const
+{
+    return d->grid;
+}
+
+void VideoCompositor::setTileRect(VideoRenderer *tile, const QRectF &rect)
+{
+    const int idx = d->tiles.indexOf(static_cast<CompositorTile*>(tile));
+    if (idx < 0)
+        return;
+    d->tiles[idx]->setRect(rect);
+    d->viewport = QSize();
+    requestUpdate();
+}
+
+QRectF VideoCompositor::tileRect(VideoRenderer *tile) const
+{
+    const int idx = d->tiles.indexOf(static_cast<CompositorTile*>(tile));
+    if (idx < 0)
+        return QRectF();
+    return d->tiles[idx]->rect();
+}
+
+void VideoCompositor::setSpacing(int value)
+{
+    if (d->spacing == value)
+        return;
+    d->spacing = value;
+    d->viewport = QSize();
+    requestUpdate();
+}
+
+int VideoCompositor::spacing() const
+{
+    return d->spacing;
+}
+
+void VideoCompositor::setBackgroundColor(const QColor &c)
+{
+    d->background = c;
+    requestUpdate();
+}
+
+QColor VideoCompositor::backgroundColor() const
+{
+    return d->background;
+}
+
+qint64 VideoCompositor::renderTime() const
+{
+    return d->render_time;
+}
+
+void VideoCompositor::render(const QSize &viewport)
+{
+    QElapsedTimer timer;
+    timer.start();
+    d->update_pending.fetchAndStoreOrdered(0);
+    QOpenGLContext *ctx = QOpenGLContext::currentContext();
+    if (!ctx || viewport.isEmpty())
+        return;
+    if (ctx != d->ctx) {
+        if (d->ctx)
+            resetGL();
+        d->ctx = ctx;
+        connect(ctx, SIGNAL(aboutToBeDestroyed()), this, SLOT(resetGL()), Qt::DirectConnection);
+    }
+    const bool relayout = d->viewport != viewport;
+    d->viewport = viewport;
+    DYGL(glViewport(0, 0, viewport.width(), viewport.height()));
+    const QColor &c = d->background;
+    DYGL(glClearColor(c.redF(), c.greenF(), c.blueF(), c.alphaF()));
+    DYGL(glClear(GL_COLOR_BUFFER_BIT));
+    // draw tiles of the same format(the same shader program) one after another
+    QVector<QPair<int, CompositorTile*> > batch;
+    batch.reserve(d->tiles.size());
+    for (int i = 0; i < d->tiles.size(); ++i) {
+        CompositorTile *tile = d->tiles[i];
+        QRect cell = tile->cell();
+        if (relayout) {
+            const QRectF r = tile->rect();
+            if (r.isValid())
+                cell = QRect(qRound(r.x()*viewport.width()), qRound(r.y()*viewport.height()), qRound(r.width()*viewport.width()), qRound(r.height()*viewport.height()));
+            else
+                cell = d->cellRect(i, viewport);
+        }
+        if (tile->prepare(cell, viewport))
+            batch.append(qMakePair((int)tile->format(), tile));
+    }
+    std::stable_sort(batch.begin(), batch.end(), formatLessThan);
+    for (int i = 0; i < batch.size(); ++i)
+        batch[i].second->draw();
+    d->render_time = timer.nsecsElapsed();
+}
+
+void VideoCompositor::resetGL()
+{
+    foreach (CompositorTile *tile, d->tiles)
+        tile->reset();
+    if (d->ctx)
+        disconnect(d->ctx, SIGNAL(aboutToBeDestroyed()), this, SLOT(resetGL()));
+    d->ctx = 0;
+    d->viewport = QSize();
+}
+
+void VideoCompositor::requestUpdate()
+{
+    if (d->update_pending.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(this, "updateRequested", Qt::QueuedConnection);
+}
+
+VideoCompositorWindow::VideoCompositorWindow(QWindow *parent)
+    : QOpenGLWindow(NoPartialUpdate, parent)
+    , m_compositor(new VideoCompositor(this))
+{
+    connect(m_compositor, SIGNAL(updateRequested()), SLOT(update()));
+}
+
+VideoCompositor* VideoCompositorWindow::compositor() const
+{
+    return m_compositor;
+}
+
+void VideoCompositorWindow::paintGL()
+{
+    m_compositor->render(QSize(width(), height())*devicePixelRatio());
+}
+} //namespace QtAV
@@ -58,6 +58,12 @@ bool VideoRenderer::receive(const VideoFrame &frame)
     setInSize(frame.width(), frame.height());
     QMutexLocker locker(&d.img_mutex);
     Q_UNUSED(locker); //TODO: double buffer for display/dec frame to avoid mutex
+    ++d.frames_received;
+    // the same frame object again, e.g. repeated by a low fps source. nothing to repaint.
+    // do not compare data pointers, pooled buffers are reused by new frames with new content
+    if (frame.isValid() && frame.isSharedWith(d.video_frame))
+        return true;
+    d.frame_dirty = true;
     return receiveFrame(frame);
 }
 
@@ -323,6 +329,22 @@ bool VideoRenderer::onSetOrientation(int value)
     return false;
 }
 
+qint64 VideoRenderer::framesReceived() const
+{
+    DPTR_D(const VideoRenderer);
+    QMutexLocker lock(&const_cast<VideoRendererPrivate&>(d).img_mutex);
+    Q_UNUSED(lock);
+    return d.frames_received;
+}
+
+qint64 VideoRenderer::framesPainted() const
+{
+    DPTR_D(const VideoRenderer);
+    QMutexLocker lock(&const_cast<VideoRendererPrivate&>(d).img_mutex);
+    Q_UNUSED(lock);
+    return d.frames_painted;
+}
+
 QSize VideoRenderer::videoFrameSize() const
 {
     DPTR_D(const VideoRenderer);
@@ -465,6 +487,7 @@ void VideoRenderer::drawBackground()
 void VideoRenderer::handlePaintEvent()
 {
     DPTR_D(VideoRenderer);
+    d.update_pending.fetchAndStoreOrdered(0); // frames received from now on need a new update
     d.setupQuality();
     //begin paint. how about QPainter::beginNativePainting()?
     {
@@ -506,6 +529,10 @@ void VideoRenderer::handlePaintEvent()
          */
         if (d.video_frame.isValid()) {
             drawFrame();
+            if (d.frame_dirty) {
+                d.frame_dirty = false;
+                ++d.frames_painted;
+            }
             //qDebug("render elapsed: %lld", et.elapsed());
             if (d.statistics) {
                 d.statistics->video_only.frameDisplayed(d.video_frame.timestamp());
@@ -652,12 +679,22 @@ void VideoRenderer::setBackgroundColor(const QColor &c)
         return;
     onSetBackgroundColor(c);
     d.bg_color = c;
+    d.update_background = true;
     Q_EMIT backgroundColorChanged();
     updateUi();
 }
 
 void VideoRenderer::updateUi()
 {
+    DPTR_D(VideoRenderer);
+    // repaint the video rect only if the background is not changed
+    const int level = d.update_background || d.out_rect.isEmpty() ? 2 : 1;
+    // only raise the pending level, a full update must not be turned into a video rect update
+    int pending = d.update_pending.fetchAndAddOrdered(0);
+    while (pending < level && !d.update_pending.testAndSetOrdered(pending, level))
+        pending = d.update_pending.fetchAndAddOrdered(0);
+    if (pending >= level)
+        return; // an update covering this one is posted but not painted yet
     QObject *obj = (QObject*)widget();
     if (obj) {
         // UpdateRequest only sync backing store but do not shedule repainting. UpdateLater does
@@ -673,7 +710,8 @@ void VideoRenderer::updateUi()
         protected:
             QRegion m_region;
         };
-        QCoreApplication::instance()->postEvent(obj, new QUpdateLaterEvent(QRegion(0, 0, rendererWidth(), rendererHeight())));
+        const QRegion region(level == 1 ? QRegion(d.out_rect) : QRegion(0, 0, rendererWidth(), rendererHeight()));
+        QCoreApplication::instance()->postEvent(obj, new QUpdateLaterEvent(region));
     } else {
         obj = (QObject*)qwindow();
         if (obj)
@@ -0,0 +1,77 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#include "BlendASS_p.h"
+#if BLENDASS_AVX2 && defined(__AVX2__)
+#include <string.h>
+#include <immintrin.h>
+
+namespace QtAV {
+static inline __m256i div255_epi16(__m256i x)
+{
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+static inline __m256i blend_epi16(__m256i d, __m256i c, __m256i k)
+{
+    const __m256i k1 = _mm256_sub_epi16(_mm256_set1_epi16(255), k);
+    return div255_epi16(_mm256_add_epi16(_mm256_mullo_epi16(c, k), _mm256_mullo_epi16(d, k1)));
+}
+
+// 8 pixels per loop. unpack and pack work in 128 bit lanes, so lo is pixel 0, 1, 4, 5 and hi is 2, 3, 6, 7
+void BlendASS_AVX2(quint32 *dst, int dstStride, const quint8 *src, int srcStride, int w, int h, quint32 color)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m256i zero256 = _mm256_setzero_si256();
+    const __m128i alpha = _mm_set1_epi16(color >> 24);
+    const __m256i rgb = _mm256_set1_epi32(color & 0xffffff);
+    const __m256i amask = _mm256_set1_epi32(0xff000000);
+    const __m256i c = _mm256_unpacklo_epi8(_mm256_set1_epi32(color), zero256); // b, g, r, a, b, g, r, a in each lane
+    for (int y = 0; y < h; ++y) {
+        int x = 0;
+        for (; x + 8 <= w; x += 8) {
+            qint64 s8;
+            memcpy(&s8, src + x, 8);
+            if (!s8)
+                continue;
+            __m256i *p = (__m256i*)(dst + x);
+            const __m256i d = _mm256_loadu_si256(p);
+            const __m128i sa = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + x)), zero), alpha);
+            // floor(sa/255)
+            const __m128i k16 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(sa, _mm_set1_epi16(1)), _mm_srli_epi16(sa, 8)), 8);
+            const __m256i k32 = _mm256_cvtepu16_epi32(k16);
+            const __m256i kk = _mm256_or_si256(k32, _mm256_slli_epi32(k32, 16));
+            const __m256i lo = blend_epi16(_mm256_unpacklo_epi8(d, zero256), c, _mm256_unpacklo_epi32(kk, kk));
+            const __m256i hi = blend_epi16(_mm256_unpackhi_epi8(d, zero256), c, _mm256_unpackhi_epi32(kk, kk));
+            const __m256i blended = _mm256_packus_epi16(lo, hi);
+            const __m256i set = _mm256_andnot_si256(_mm256_cmpeq_epi32(k32, zero256), _mm256_cmpeq_epi32(_mm256_and_si256(d, amask), zero256));
+            const __m256i v = _mm256_or_si256(rgb, _mm256_slli_epi32(k32, 24));
+            _mm256_storeu_si256(p, _mm256_blendv_epi8(blended, v, set));
+        }
+        for (; x < w; ++x)
+            blendASSPixel(&dst[x], src[x], color);
+        src += srcStride;
+        dst = (quint32*)((quint8*)dst + dstStride);
+    }
+}
+} //namespace QtAV
+#endif //BLENDASS_AVX2
@@ -0,0 +1,76 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#include "BlendASS_p.h"
+#if BLENDASS_NEON
+#include <arm_neon.h>
+
+namespace QtAV {
+static inline uint8x8_t div255_u16(uint16x8_t x)
+{
+    x = vaddq_u16(x, vdupq_n_u16(128));
+    return vshrn_n_u16(vaddq_u16(x, vshrq_n_u16(x, 8)), 8);
+}
+
+static inline uint8x8_t div255_floor_u16(uint16x8_t x)
+{
+    return vshrn_n_u16(vaddq_u16(vaddq_u16(x, vdupq_n_u16(1)), vshrq_n_u16(x, 8)), 8);
+}
+
+static inline uint8x8_t blend_u8(uint8x8_t d, uint8x8_t c, uint8x8_t k, uint8x8_t k1)
+{
+    return div255_u16(vmlal_u8(vmull_u8(c, k), d, k1));
+}
+
+// 8 pixels per loop. vld4 splits b, g, r, a channels of little endian ARGB32
+void BlendASS_NEON(quint32 *dst, int dstStride, const quint8 *src, int srcStride, int w, int h, quint32 color)
+{
+    const uint8x8_t b = vdup_n_u8(color & 0xff);
+    const uint8x8_t g = vdup_n_u8((color >> 8) & 0xff);
+    const uint8x8_t r = vdup_n_u8((color >> 16) & 0xff);
+    const uint8x8_t a = vdup_n_u8(color >> 24);
+    const uint8x8_t max = vdup_n_u8(255);
+    for (int y = 0; y < h; ++y) {
+        int x = 0;
+        for (; x + 8 <= w; x += 8) {
+            const uint8x8_t s = vld1_u8(src + x);
+            if (!vget_lane_u64(vreinterpret_u64_u8(s), 0))
+                continue;
+            quint8 *p = (quint8*)(dst + x);
+            uint8x8x4_t d = vld4_u8(p);
+            const uint8x8_t k = div255_floor_u16(vmull_u8(s, a));
+            const uint8x8_t k1 = vsub_u8(max, k);
+            // transparent dst and k > 0: (r, g, b, k)
+            const uint8x8_t set = vand_u8(vceq_u8(d.val[3], vdup_n_u8(0)), vtst_u8(k, k));
+            d.val[0] = vbsl_u8(set, b, blend_u8(d.val[0], b, k, k1));
+            d.val[1] = vbsl_u8(set, g, blend_u8(d.val[1], g, k, k1));
+            d.val[2] = vbsl_u8(set, r, blend_u8(d.val[2], r, k, k1));
+            d.val[3] = vbsl_u8(set, k, blend_u8(d.val[3], a, k, k1));
+            vst4_u8(p, d);
+        }
+        for (; x < w; ++x)
+            blendASSPixel(&dst[x], src[x], color);
+        src += srcStride;
+        dst = (quint32*)((quint8*)dst + dstStride);
+    }
+}
+} //namespace QtAV
+#endif //BLENDASS_NEON
@@ -0,0 +1,83 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#include "BlendASS_p.h"
+#if BLENDASS_SSE2
+#include <string.h>
+#include <emmintrin.h>
+
+namespace QtAV {
+// 16 bit lanes, x in [0, 255*255]
+static inline __m128i div255_epi16(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+static inline __m128i div255_floor_epi16(__m128i x)
+{
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)), 8);
+}
+
+// k: 16 bit k,k for each 32 bit lane. d: 4 channels of 2 pixels in 16 bit lanes
+static inline __m128i blend_epi16(__m128i d, __m128i c, __m128i k)
+{
+    const __m128i k1 = _mm_sub_epi16(_mm_set1_epi16(255), k);
+    return div255_epi16(_mm_add_epi16(_mm_mullo_epi16(c, k), _mm_mullo_epi16(d, k1)));
+}
+
+// 4 pixels per loop
+void BlendASS_SSE2(quint32 *dst, int dstStride, const quint8 *src, int srcStride, int w, int h, quint32 color)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi16(color >> 24);
+    const __m128i rgb = _mm_set1_epi32(color & 0xffffff);
+    const __m128i amask = _mm_set1_epi32(0xff000000);
+    const __m128i c = _mm_unpacklo_epi8(_mm_cvtsi32_si128(color), zero); // b, g, r, a in 16 bit
+    const __m128i c2 = _mm_unpacklo_epi64(c, c);
+    for (int y = 0; y < h; ++y) {
+        int x = 0;
+        for (; x + 4 <= w; x += 4) {
+            int s4;
+            memcpy(&s4, src + x, 4);
+            if (!s4)
+                continue;
+            __m128i *p = (__m128i*)(dst + x);
+            const __m128i d = _mm_loadu_si128(p);
+            const __m128i k16 = div255_floor_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(s4), zero), alpha));
+            const __m128i k32 = _mm_unpacklo_epi16(k16, zero);
+            const __m128i kk = _mm_or_si128(k32, _mm_slli_epi32(k32, 16));
+            const __m128i lo = blend_epi16(_mm_unpacklo_epi8(d, zero), c2, _mm_unpacklo_epi32(kk, kk));
+            const __m128i hi = blend_epi16(_mm_unpackhi_epi8(d, zero), c2, _mm_unpackhi_epi32(kk, kk));
+            const __m128i blended = _mm_packus_epi16(lo, hi);
+            // transparent dst and k > 0: (r, g, b, k)
+            const __m128i set = _mm_andnot_si128(_mm_cmpeq_epi32(k32, zero), _mm_cmpeq_epi32(_mm_and_si128(d, amask), zero));
+            const __m128i v = _mm_or_si128(rgb, _mm_slli_epi32(k32, 24));
+            _mm_storeu_si128(p, _mm_or_si128(_mm_and_si128(set, v), _mm_andnot_si128(set, blended)));
+        }
+        for (; x < w; ++x)
+            blendASSPixel(&dst[x], src[x], color);
+        src += srcStride;
+        dst = (quint32*)((quint8*)dst + dstStride);
+    }
+}
+} //namespace QtAV
+#endif //BLENDASS_SSE2
@@ -0,0 +1,62 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#ifndef QTAV_BLENDASS_P_H
+#define QTAV_BLENDASS_P_H
+
+#include <QtAV/QtAV_Global.h>
+// kernels used by blendASSFunc(). see QtAV/private/SubImageBlend.h
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLENDASS_SSE2 1 // baseline on x86_64, no runtime check
+#endif
+#if QTAV_HAVE(AVX2) // BlendASS_AVX2.cpp is built with avx2 flags
+#define BLENDASS_AVX2 1
+#endif
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__ARM_BIG_ENDIAN)
+#define BLENDASS_NEON 1
+#endif
+namespace QtAV {
+// exact for x in [0, 255*255]. round(x/255) and floor(x/255)
+static inline unsigned div255(unsigned x) { x += 128; return (x + (x >> 8)) >> 8;}
+static inline unsigned div255_floor(unsigned x) { return (x + 1 + (x >> 8)) >> 8;}
+
+static inline void blendASSPixel(quint32 *dst, quint8 coverage, quint32 color)
+{
+    const unsigned k = div255_floor(coverage*(color >> 24));
+    if (k == 0)
+        return;
+    const quint32 d = *dst;
+    if ((d >> 24) == 0) {
+        *dst = (color & 0xffffff) | (k << 24);
+        return;
+    }
+    quint32 v = 0;
+    for (int s = 0; s < 32; s += 8)
+        v |= div255(k*((color >> s) & 0xff) + (255 - k)*((d >> s) & 0xff)) << s;
+    *dst = v;
+}
+
+void BlendASS_C(quint32 *dst, int dstStride, const quint8 *src, int srcStride, int w, int h, quint32 color);
+void BlendASS_SSE2(quint32 *dst, int dstStride, const quint8 *src, int srcStride, int w, int h, quint32 color);
+void BlendASS_AVX2(quint32 *dst, int dstStride, const quint8 *src, int srcStride, int w, int h, quint32 color);
+void BlendASS_NEON(quint32 *dst, int dstStride, const quint8 *src, int srcStride, int w, int h, quint32 color);
+} //namespace QtAV
+#endif //QTAV_BLENDASS_P_H
@@ -19,7 +19,12 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ******************************************************************************/
 #include "QtAV/SubImage.h"
+#include "QtAV/private/SubImageBlend.h"
 #include <QtGui/QImage>
+#include "BlendASS_p.h"
+extern "C" {
+#include <libavutil/cpu.h>
+}
 
 namespace QtAV {
 
@@ -44,44 +49,65 @@ SubImageSet::SubImageSet(int width, int height, Format format)
 #define _b(c)  (((c)>>8)&0xFF)
 #define _a(c)  ((c)&0xFF)
 
-#define qRgba2(r, g, b, a) ((a << 24) | (r << 16) | (g  << 8) | b)
 /*
  * ASS_Image: 1bit alpha per pixel + 1 rgb per image. less memory usage
  */
-//0xAARRGGBB
-#if (Q_BYTE_ORDER == Q_BIG_ENDIAN)
-#define ARGB32_SET(C, R, G, B, A) \
-    C[0] = (A); \
-    C[1] = (R); \
-    C[2] = (G); \
-    C[3] = (B);
-#define ARGB32_ADD(C, R, G, B, A) \
-    C[0] += (A); \
-    C[1] += (R); \
-    C[2] += (G); \
-    C[3] += (B);
-#define ARGB32_A(C) (C[0])
-#define ARGB32_R(C) (C[1])
-#define ARGB32_G(C) (C[2])
-#define ARGB32_B(C) (C[3])
+void BlendASS_C(quint32 *dst, int dstStride, const quint8 *src, int srcStride, int w, int h, quint32 color)
+{
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x)
+            blendASSPixel(&dst[x], src[x], color);
+        src += srcStride;
+        dst = (quint32*)((quint8*)dst + dstStride);
+    }
+}
+
+#if BLENDASS_AVX2
+static bool detect_avx2()
+{
+#ifdef AV_CPU_FLAG_AVX2
+    static bool is_avx2 = !!(av_get_cpu_flags() & AV_CPU_FLAG_AVX2);
+    return is_avx2;
+#else
+    return false;
+#endif
+}
+#endif //BLENDASS_AVX2
+
+BlendASSFunc blendASSFunc(BlendASSKernel kernel)
+{
+    switch (kernel) {
+    case BlendASS_C:
+        return BlendASS_C;
+    case BlendASS_SSE2:
+#if BLENDASS_SSE2
+        return BlendASS_SSE2;
+#else
+        return 0;
+#endif
+    case BlendASS_AVX2:
+#if BLENDASS_AVX2
+        if (detect_avx2())
+            return BlendASS_AVX2;
+#endif
+        return 0;
+    case BlendASS_NEON:
+#if BLENDASS_NEON
+        return BlendASS_NEON;
 #else
-#define ARGB32_SET(C, R, G, B, A) \
-    C[0] = (B); \
-    C[1] = (G); \
-    C[2] = (R); \
-    C[3] = (A);
-#define ARGB32_ADD(C, R, G, B, A) \
-    C[0] += (B); \
-    C[1] += (G); \
-    C[2] += (R); \
-    C[3] += (A);
-#define ARGB32_A(C) (C[3])
-#define ARGB32_R(C) (C[2])
-#define ARGB32_G(C) (C[1])
-#define ARGB32_B(C) (C[0])
+        return 0;
 #endif
-#define USE_QRGBA 0
-// C[i] = C'[i] = (k*c[i]+(255-k)*C[i])/255 = C[i] + k*(c[i]-C[i])/255, min(c[i],C[i]) <= C'[i] <= max(c[i],C[i])
+    default:
+        break;
+    }
+    static const BlendASSKernel kernels[] = { BlendASS_AVX2, BlendASS_SSE2, BlendASS_NEON };
+    for (size_t i = 0; i < sizeof(kernels)/sizeof(kernels[0]); ++i) {
+        BlendASSFunc f = blendASSFunc(kernels[i]);
+        if (f)
+            return f;
+    }
+    return BlendASS_C;
+}
 
 // render 1 ass image into a 32bit QImage with alpha channel.
 //use dstX, dstY instead of img->dst_x/y because image size is small then ass renderer size
@@ -90,51 +116,9 @@ void RenderASS(QImage *image, const SubImage& img, int dstX, int dstY)
     const quint8 a = 255 - _a(img.color);
     if (a == 0)
         return;
-    const quint8 r = _r(img.color);
-    const quint8 g = _g(img.color);
-    const quint8 b = _b(img.color);
-    const quint8 *src = (const quint8*)img.data.constData();
+    static const BlendASSFunc blend = blendASSFunc();
     // use QRgb to avoid endian issue
     QRgb *dst = (QRgb*)image->constBits() + dstY * image->width() + dstX;
-    // k*src+(1-k)*dst
-    for (int y = 0; y < img.h; ++y) {
-        for (int x = 0; x < img.w; ++x) {
-            const unsigned k = ((unsigned) src[x])*a/255;
-#if USE_QRGBA
-            const unsigned A = qAlpha(dst[x]);
-#else
-            quint8 *c = (quint8*)(&dst[x]);
-            const unsigned A = ARGB32_A(c);
-#endif
-            if (A == 0) { // dst color can be ignored
-#if USE_QRGBA
-                 dst[x] = qRgba(r, g, b, k);
-#else
-                 ARGB32_SET(c, r, g, b, k);
-#endif //USE_QRGBA
-            } else if (k == 0) { //no change
-                //dst[x] = qRgba(qRed(dst[x])), qGreen(dst[x]), qBlue(dst[x]), qAlpha(dst[x])) == dst[x];
-            } else if (k == 255) {
-#if USE_QRGBA
-                dst[x] = qRgba(r, g, b, k);
-#else
-                ARGB32_SET(c, r, g, b, k);
-#endif //USE_QRGBA
-            } else {
-                // c=k*dc/255=k*dc/256 * (1-1/256), -1<err(c) = k*dc/256^2<1, -1 is bad!
-#if USE_QRGBA
-                // no need to &0xff because always be 0~255
-                dst[x] += qRgba2(k*(r-qRed(dst[x]))/255, k*(g-qGreen(dst[x]))/255, k*(b-qBlue(dst[x]))/255, k*(a-A)/255);
-#else
-                const unsigned R = ARGB32_R(c);
-                const unsigned G = ARGB32_G(c);
-                const unsigned B = ARGB32_B(c);
-                ARGB32_ADD(c, r == R ? 0 : k*(r-R)/255, g == G ? 0 : k*(g-G)/255, b == B ? 0 : k*(b-B)/255, a == A ? 0 : k*(a-A)/255);
-#endif
-            }
-        }
-        src += img.stride;
-        dst += image->width();
-    }
+    blend(dst, image->width()*sizeof(QRgb), (const quint8*)img.data.constData(), img.stride, img.w, img.h, qRgba(_r(img.color), _g(img.color), _b(img.color), a));
 }
 } //namespace QtAV
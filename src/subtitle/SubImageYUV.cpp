@@ -0,0 +1,310 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#include "QtAV/private/SubImageBlend.h"
+#include "QtAV/SubImage.h"
+#include "QtAV/VideoFrame.h"
+#include "QtAV/private/AVCompat.h"
+#include <QtCore/QVector>
+#include <QtGui/QImage>
+#include "BlendASS_p.h"
+#include "utils/Logger.h"
+
+namespace QtAV {
+namespace {
+/*!
+ * A layer to blend in frame coordinates. alpha of a pixel is coverage*opacity/255.
+ * Color is 8 bit yuv, either a solid color or one value per pixel
+ */
+struct Layer {
+    int x, y, w, h;
+    const quint8 *coverage;
+    int coverage_stride;
+    unsigned opacity;
+    const quint8 *yuv[3]; // null: use color
+    int yuv_stride;
+    unsigned color[3];
+};
+
+static inline unsigned alphaOf(unsigned coverage, unsigned opacity)
+{
+    return opacity == 255 ? coverage : div255_floor(coverage*opacity);
+}
+
+class YUVTarget
+{
+public:
+    YUVTarget(const VideoFrame *frame)
+        : depth(0)
+    {
+        const VideoFormat fmt(frame->format());
+        if (!canBlendYUV(fmt) || !frame->constBits(0))
+            return;
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get((AVPixelFormat)fmt.pixelFormatFFmpeg());
+        if (!desc)
+            return;
+        log2_w = desc->log2_chroma_w;
+        log2_h = desc->log2_chroma_h;
+        width = frame->width();
+        height = frame->height();
+        for (int i = 0; i < 3; ++i) {
+            bits[i] = const_cast<uchar*>(frame->constBits(i)); // written only by blend(), which is called for a writable frame
+            stride[i] = frame->bytesPerLine(i);
+        }
+        cs = frame->colorSpace();
+        if (cs != ColorSpace_BT601 && cs != ColorSpace_BT709)
+            cs = height > 576 ? ColorSpace_BT709 : ColorSpace_BT601;
+        full = frame->colorRange() == ColorRange_Full || fmt.pixelFormat() == VideoFormat::Format_Jpeg;
+        const double kr = cs == ColorSpace_BT709 ? 0.2126 : 0.299;
+        const double kb = cs == ColorSpace_BT709 ? 0.0722 : 0.114;
+        const double ys = full ? 1.0 : 219.0/255.0;
+        const double cs_ = full ? 1.0 : 224.0/255.0;
+        const double m[3][3] = {
+            { kr*ys, (1.0-kr-kb)*ys, kb*ys },
+            { -0.5*kr/(1.0-kb)*cs_, -0.5*(1.0-kr-kb)/(1.0-kb)*cs_, 0.5*cs_ },
+            { 0.5*cs_, -0.5*(1.0-kr-kb)/(1.0-kr)*cs_, -0.5*kb/(1.0-kr)*cs_ }
+        };
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j)
+                mat[i][j] = qRound(m[i][j]*65536.0);
+        }
+        offset[0] = full ? 0 : 16;
+        offset[1] = offset[2] = 128;
+        depth = fmt.bitsPerComponent();
+    }
+    bool isValid() const { return depth > 0;}
+    ColorSpace colorSpace() const { return cs;}
+    bool isFullRange() const { return full;}
+    void toYUV(unsigned r, unsigned g, unsigned b, unsigned *yuv) const {
+        for (int i = 0; i < 3; ++i) {
+            const int v = offset[i] + ((mat[i][0]*int(r) + mat[i][1]*int(g) + mat[i][2]*int(b) + 32768) >> 16);
+            yuv[i] = qBound(0, v, 255);
+        }
+    }
+    // clip layer rect to frame. return false if nothing to draw
+    bool clip(Layer *l) const {
+        if (l->x < 0) {
+            l->coverage -= l->x;
+            for (int i = 0; i < 3; ++i) {
+                if (l->yuv[i])
+                    l->yuv[i] -= l->x;
+            }
+            l->w += l->x;
+            l->x = 0;
+        }
+        if (l->y < 0) {
+            l->coverage -= l->y*l->coverage_stride;
+            for (int i = 0; i < 3; ++i) {
+                if (l->yuv[i])
+                    l->yuv[i] -= l->y*l->yuv_stride;
+            }
+            l->h += l->y;
+            l->y = 0;
+        }
+        l->w = qMin(l->w, width - l->x);
+        l->h = qMin(l->h, height - l->y);
+        return l->w > 0 && l->h > 0;
+    }
+    void blend(const Layer& l) const {
+        if (depth > 8)
+            blendT<quint16>(l);
+        else
+            blendT<quint8>(l);
+    }
+
+private:
+    template<typename T> void blendT(const Layer& l) const;
+
+    int depth;
+    ColorSpace cs;
+    bool full;
+    int log2_w, log2_h;
+    int width, height;
+    uchar *bits[3];
+    int stride[3];
+    int mat[3][3];
+    int offset[3];
+};
+
+template<typename T>
+void YUVTarget::blendT(const Layer &l) const
+{
+    const int shift = depth - 8;
+    for (int j = 0; j < l.h; ++j) {
+        T *d = (T*)(bits[0] + (l.y + j)*stride[0]) + l.x;
+        const quint8 *a = l.coverage + j*l.coverage_stride;
+        const quint8 *s = l.yuv[0] ? l.yuv[0] + j*l.yuv_stride : 0;
+        for (int i = 0; i < l.w; ++i) {
+            const unsigned k = alphaOf(a[i], l.opacity);
+            if (!k)
+                continue;
+            const unsigned c = (s ? s[i] : l.color[0]) << shift;
+            d[i] = T((k*c + (255 - k)*d[i] + 127)/255);
+        }
+    }
+    // a chroma sample is the average of the luma block it covers. pixels out of the layer have alpha 0
+    const unsigned n255 = 255U << (log2_w + log2_h);
+    const int cx0 = l.x >> log2_w, cx1 = (l.x + l.w - 1) >> log2_w;
+    const int cy0 = l.y >> log2_h, cy1 = (l.y + l.h - 1) >> log2_h;
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        const int y0 = qMax(cy << log2_h, l.y), y1 = qMin((cy + 1) << log2_h, l.y + l.h);
+        T *du = (T*)(bits[1] + cy*stride[1]);
+        T *dv = (T*)(bits[2] + cy*stride[2]);
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            const int x0 = qMax(cx << log2_w, l.x), x1 = qMin((cx + 1) << log2_w, l.x + l.w);
+            unsigned sa = 0, su = 0, sv = 0;
+            for (int y = y0; y < y1; ++y) {
+                const quint8 *a = l.coverage + (y - l.y)*l.coverage_stride - l.x;
+                for (int x = x0; x < x1; ++x) {
+                    const unsigned k = alphaOf(a[x], l.opacity);
+                    sa += k;
+                    if (l.yuv[1]) {
+                        const int o = (y - l.y)*l.yuv_stride + x - l.x;
+                        su += k*l.yuv[1][o];
+                        sv += k*l.yuv[2][o];
+                    }
+                }
+            }
+            if (!sa)
+                continue;
+            if (!l.yuv[1]) {
+                su = sa*l.color[1];
+                sv = sa*l.color[2];
+            }
+            du[cx] = T(((su << shift) + (n255 - sa)*du[cx] + n255/2)/n255);
+            dv[cx] = T(((sv << shift) + (n255 - sa)*dv[cx] + n255/2)/n255);
+        }
+    }
+}
+} //namespace
+
+bool canBlendYUV(const VideoFormat &format)
+{
+    if (!format.isValid() || format.isRGB() || !format.isPlanar() || format.planeCount() != 3)
+        return false;
+    // YV12 and IMCx planes are not in y, u, v order
+    if (format.pixelFormat() == VideoFormat::Format_YV12 || format.pixelFormatFFmpeg() == QTAV_PIX_FMT_C(NONE))
+        return false;
+    const int bpc = format.bitsPerComponent();
+    if (bpc < 8 || bpc > 16 || format.bytesPerPixel(0) != (bpc + 7)/8)
+        return false;
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    return bpc == 8 || format.isBigEndian();
+#else
+    return bpc == 8 || !format.isBigEndian();
+#endif
+}
+
+bool blendSubImagesYUV(VideoFrame *frame, const SubImageSet &set)
+{
+    if (set.format() != SubImageSet::ASS)
+        return false;
+    const YUVTarget t(frame);
+    if (!t.isValid())
+        return false;
+    foreach (const SubImage& i, set.images) {
+        Layer l;
+        l.x = i.x;
+        l.y = i.y;
+        l.w = i.w;
+        l.h = i.h;
+        l.coverage = (const quint8*)i.data.constData();
+        l.coverage_stride = i.stride;
+        l.opacity = 255 - (i.color & 0xff); // ass color is RRGGBBAA, AA is transparency
+        l.yuv[0] = l.yuv[1] = l.yuv[2] = 0;
+        l.yuv_stride = 0;
+        if (!l.opacity || !t.clip(&l))
+            continue;
+        t.toYUV(i.color >> 24, (i.color >> 16) & 0xff, (i.color >> 8) & 0xff, l.color);
+        t.blend(l);
+    }
+    return true;
+}
+
+bool blendImageYUV(VideoFrame *frame, const QImage &image, const QPoint &pos)
+{
+    YUVImage yuv;
+    if (!convertImageYUV(*frame, image, true, &yuv))
+        return false;
+    return blendImageYUV(frame, yuv, pos);
+}
+
+bool convertImageYUV(const VideoFrame &frame, const QImage &image, bool imageChanged, YUVImage *yuv)
+{
+    const YUVTarget t(&frame);
+    if (!t.isValid())
+        return false;
+    if (!imageChanged && yuv->color_space == t.colorSpace() && yuv->full_range == t.isFullRange())
+        return true;
+    yuv->color_space = t.colorSpace();
+    yuv->full_range = t.isFullRange();
+    yuv->width = yuv->height = 0;
+    yuv->planes.clear();
+    if (image.isNull())
+        return true;
+    const QImage img(image.format() == QImage::Format_ARGB32 ? image : image.convertToFormat(QImage::Format_ARGB32));
+    const int w = img.width(), h = img.height();
+    yuv->width = w;
+    yuv->height = h;
+    yuv->planes.resize(w*h*4);
+    quint8 *a = yuv->planes.data();
+    quint8 *p[3] = { a + w*h, a + w*h*2, a + w*h*3 };
+    for (int j = 0; j < h; ++j) {
+        const QRgb *s = (const QRgb*)img.constScanLine(j);
+        for (int i = 0; i < w; ++i) {
+            const int offset = j*w + i;
+            a[offset] = qAlpha(s[i]);
+            if (!a[offset])
+                continue;
+            unsigned v[3];
+            t.toYUV(qRed(s[i]), qGreen(s[i]), qBlue(s[i]), v);
+            for (int c = 0; c < 3; ++c)
+                p[c][offset] = v[c];
+        }
+    }
+    return true;
+}
+
+bool blendImageYUV(VideoFrame *frame, const YUVImage &image, const QPoint &pos)
+{
+    const YUVTarget t(frame);
+    if (!t.isValid())
+        return false;
+    if (image.isNull())
+        return true;
+    const int w = image.width, h = image.height;
+    const quint8 *a = image.planes.constData();
+    Layer l;
+    l.x = pos.x();
+    l.y = pos.y();
+    l.w = w;
+    l.h = h;
+    l.coverage = a;
+    l.coverage_stride = w;
+    l.opacity = 255;
+    for (int c = 0; c < 3; ++c)
+        l.yuv[c] = a + w*h*(c + 1);
+    l.yuv_stride = w;
+    if (t.clip(&l))
+        t.blend(l);
+    return true;
+}
+} //namespace QtAV
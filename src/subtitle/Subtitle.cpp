@@ -131,6 +131,7 @@ Subtitle::Subtitle(QObject *parent) :
 {
     // TODO: use factory.registedNames() and the order
     setEngines(QStringList() << QStringLiteral("LibASS") << QStringLiteral("FFmpeg"));
+    connect(SubtitleFontCache::instance(), SIGNAL(ready(qint64)), SLOT(onFontCacheReady(qint64)));
 }
 
 Subtitle::~Subtitle()
@@ -386,6 +387,7 @@ void Subtitle::setFontFileForced(bool value)
     Q_EMIT fontFileForcedChanged();
     if (priv->processor) {
         priv->processor->setFontFileForced(value);
+        checkCapability();
     }
 }
 
@@ -457,6 +459,12 @@ void Subtitle::load()
     }
 }
 
+void Subtitle::onFontCacheReady(qint64 elapsed)
+{
+    checkCapability();
+    Q_EMIT fontCacheReady(elapsed);
+}
+
 void Subtitle::checkCapability()
 {
     if (priv->last_can_render == canRender())
@@ -99,6 +99,45 @@ int SubtitleProcessor::frameHeight() const
     return m_height;
 }
 
+namespace {
+enum { WarmupNotStarted, WarmupRunning, WarmupFinished };
+}
+
+SubtitleFontCache* SubtitleFontCache::instance()
+{
+    static SubtitleFontCache fc;
+    return &fc;
+}
+
+SubtitleFontCache::SubtitleFontCache()
+    : QObject(0)
+    , m_state(WarmupNotStarted)
+    , m_elapsed(-1)
+{}
+
+bool SubtitleFontCache::beginWarmup()
+{
+    return m_state.testAndSetOrdered(WarmupNotStarted, WarmupRunning);
+}
+
+void SubtitleFontCache::endWarmup(qint64 elapsed)
+{
+    m_elapsed = elapsed;
+    m_state.fetchAndStoreOrdered(WarmupFinished);
+    qDebug("font cache is ready. elapsed: %lldms", elapsed);
+    Q_EMIT ready(elapsed);
+}
+
+bool SubtitleFontCache::isReady() const
+{
+    return m_state.fetchAndAddAcquire(0) == WarmupFinished;
+}
+
+qint64 SubtitleFontCache::warmupTime() const
+{
+    return isReady() ? m_elapsed : -1;
+}
+
 void SubtitleProcessor::onFrameSizeChanged(int width, int height)
 {
     Q_UNUSED(width);
@@ -21,11 +21,15 @@
 
 #include "QtAV/private/SubtitleProcessor.h"
 #include <QtCore/QCoreApplication>
-#include <QtCore/QEventLoop>
 #include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QFile>
+#include <QtCore/QLibrary>
 #include <QtCore/QMutex>
+#include <QtCore/QRunnable>
 #include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QWaitCondition>
 #include "QtAV/Packet.h"
 #include "QtAV/private/factory.h"
 #include "PlainText.h"
@@ -36,11 +40,30 @@
 //#define CAPI_LINK_ASS
 #include "capi/ass_api.h"
 #include <stdarg.h>
+#include <limits>
 //#include <string>  //include after ass_api.h, stdio.h is included there in a different namespace
 
 namespace QtAV {
 void RenderASS(QImage *image, const SubImage &img, int dstX, int dstY);
 
+namespace {
+// images of a time range [begin, end) in ms
+struct RenderedSubs {
+    RenderedSubs() : begin(0), end(0), rendered_at(-1), generation(-1) {}
+    qint64 begin, end;
+    qint64 rendered_at; // pts of the last ass_render_frame() call with the same result
+    int generation;
+    QSize size;
+    SubImageSet images;
+    QRect bound;
+    QImage image; // created if getImage() is used
+};
+static const qint64 kForever = std::numeric_limits<qint64>::max();
+static const int kMaxRendered = 32;
+static const int kMaxPooledImages = 4;
+} //namespace
+
+class LookaheadThread;
 class SubtitleProcessorLibASS Q_DECL_FINAL: public SubtitleProcessor, protected ass::api
 {
 public:
@@ -54,7 +77,7 @@ public:
     // supportsFromFile must be true
     bool process(const QString& path) Q_DECL_OVERRIDE;
     QList<SubtitleFrame> frames() const Q_DECL_OVERRIDE;
-    bool canRender() const Q_DECL_OVERRIDE { return true;}
+    bool canRender() const Q_DECL_OVERRIDE { return isFontCacheReady();}
     QString getText(qreal pts) const Q_DECL_OVERRIDE;
     QImage getImage(qreal pts, QRect *boundingRect = 0) Q_DECL_OVERRIDE;
     SubImageSet getSubImages(qreal pts, QRect *boundingRect) Q_DECL_OVERRIDE;
@@ -67,9 +90,33 @@ protected:
     void onFrameSizeChanged(int width, int height) Q_DECL_OVERRIDE;
 private:
     bool initRenderer();
-    void updateFontCacheAsync();
-    SubImageSet getSubImages(qreal pts, QRect *boundingRect, QImage* qimg, bool copy);
+    // start warming up if required but not ready
+    bool isFontCacheReady() const;
     void processTrack(ASS_Track *track);
+    /*
+     * Lookahead rendering. A background thread renders the next cue transitions after the last requested pts into
+     * m_rendered, so getImage() and getSubImages() are usually a lookup. A static range is rendered once, animated events
+     * are rendered every step (interval of requests). Results are dropped if generation changes, i.e. track, fonts or
+     * frame size changed. Lock order: m_mutex, m_rendered_mutex
+     */
+    friend class LookaheadThread;
+    RenderedSubs rendered(qreal pts, bool image);
+    bool findRendered(qint64 ms, bool image, RenderedSubs *r);
+    RenderedSubs renderSync(qint64 ms, bool image);
+    // m_mutex must be locked. return false if result is the same as the render at prev_at, and images are not set
+    bool renderAt(qint64 ms, qint64 prev_at, qint64 step, int generation, RenderedSubs *r);
+    // m_mutex must be locked
+    qint64 nextTransition(qint64 ms, bool *animated) const;
+    int transitions(qint64 from, qint64 to) const;
+    // m_rendered_mutex must be locked
+    bool insertRendered(const RenderedSubs& r, bool changed, qint64 prev_at);
+    void rasterize(RenderedSubs *r);
+    void recycle(QImage *image);
+    void invalidateRendered();
+    // drop the rendered ranges overlapping [begin, end) in ms, keep others
+    void invalidateRendered(qint64 begin, qint64 end);
+    void lookahead();
+    bool ensureRenderer();
     bool m_update_cache;
     bool force_font_file; // works only iff font_file is set
     QString font_file;
@@ -79,11 +126,34 @@ private:
     ASS_Renderer *m_renderer;
     ASS_Track *m_track;
     QList<SubtitleFrame> m_frames;
-    //cache the image for the last invocation. return this if image does not change
-    QImage m_image;
-    SubImageSet m_assimages;
-    QRect m_bound;
     mutable QMutex m_mutex;
+    qint64 m_last_render; // pts of the last ass_render_frame() call
+    int m_last_render_generation;
+
+    QMutex m_rendered_mutex;
+    QWaitCondition m_lookahead_cond;
+    QList<RenderedSubs> m_rendered;
+    QList<QImage> m_image_pool;
+    int m_generation;
+    qint64 m_cursor; // last requested pts
+    qint64 m_step;
+    bool m_want_image;
+    bool m_lookahead_pending;
+    bool m_stop;
+    int m_lookahead; // number of cue transitions to render ahead. 0: no lookahead thread
+    LookaheadThread *m_thread;
+};
+
+class LookaheadThread : public QThread
+{
+public:
+    LookaheadThread(SubtitleProcessorLibASS *p) : sp(p) {}
+protected:
+    void run() Q_DECL_OVERRIDE {
+        sp->lookahead();
+    }
+private:
+    SubtitleProcessorLibASS *sp;
 };
 
 static const SubtitleProcessorId SubtitleProcessorId_LibASS = QStringLiteral("qtav.subtitle.processor.libass");
@@ -130,7 +200,21 @@ SubtitleProcessorLibASS::SubtitleProcessorLibASS()
     , m_ass(0)
     , m_renderer(0)
     , m_track(0)
+    , m_last_render(-1)
+    , m_last_render_generation(-1)
+    , m_generation(0)
+    , m_cursor(-1)
+    , m_step(40)
+    , m_want_image(false)
+    , m_lookahead_pending(false)
+    , m_stop(false)
+    , m_lookahead(8)
+    , m_thread(0)
 {
+    bool ok = false;
+    const int n = qgetenv("QTAV_SUB_LOOKAHEAD").toInt(&ok);
+    if (ok && n >= 0)
+        m_lookahead = n;
     if (!ass::api::loaded())
         return;
     m_ass = ass_library_init();
@@ -143,6 +227,17 @@ SubtitleProcessorLibASS::SubtitleProcessorLibASS()
 
 SubtitleProcessorLibASS::~SubtitleProcessorLibASS()
 { // ass dll is loaded if ass objects are available
+    if (m_thread) {
+        {
+            QMutexLocker lock(&m_rendered_mutex);
+            Q_UNUSED(lock);
+            m_stop = true;
+            m_lookahead_cond.wakeAll();
+        }
+        m_thread->wait();
+        delete m_thread;
+        m_thread = 0;
+    }
     if (m_track) {
         ass_free_track(m_track);
         m_track = 0;
@@ -199,6 +294,7 @@ bool SubtitleProcessorLibASS::process(QIODevice *dev)
         }
     }
     QByteArray data(dev->readAll());
+    invalidateRendered();
     m_track = ass_read_memory(m_ass, (char*)data.constData(), data.size(), NULL); //utf-8
     if (!m_track) {
         qWarning("ass_read_memory error, ass track init failed!");
@@ -219,6 +315,7 @@ bool SubtitleProcessorLibASS::process(const QString &path)
         ass_free_track(m_track);
         m_track = 0;
     }
+    invalidateRendered();
     m_track = ass_read_file(m_ass, (char*)path.toUtf8().constData(), NULL);
     if (!m_track) {
         qWarning("ass_read_file error, ass track init failed!");
@@ -241,6 +338,7 @@ bool SubtitleProcessorLibASS::processHeader(const QByteArray& codec, const QByte
         ass_free_track(m_track);
         m_track = 0;
     }
+    invalidateRendered();
     m_track = ass_new_track(m_ass);
     if (!m_track) {
         qWarning("failed to create an ass track");
@@ -270,6 +368,14 @@ SubtitleFrame SubtitleProcessorLibASS::processLine(const QByteArray &data, qreal
     }
     if (nb_tracks == m_track->n_events)
         return SubtitleFrame();
+    // new events are appended. only the ranges they cover are rendered again
+    qint64 begin = kForever, end = 0;
+    for (int i = nb_tracks; i < m_track->n_events; ++i) {
+        const ASS_Event& ae = m_track->events[i];
+        begin = qMin<qint64>(begin, ae.Start);
+        end = qMax<qint64>(end, ae.Duration > 0 ? ae.Start + ae.Duration : kForever);
+    }
+    invalidateRendered(begin, end);
     //qDebug("events: %d", m_track->n_events);
     for (int i = m_track->n_events-1; i >= 0; --i) {
         const ASS_Event& ae = m_track->events[i];
@@ -302,57 +408,135 @@ QString SubtitleProcessorLibASS::getText(qreal pts) const
     return text.trimmed();
 }
 
-void renderASS32(QImage *image, ASS_Image *img, int dstX, int dstY);
 QImage SubtitleProcessorLibASS::getImage(qreal pts, QRect *boundingRect)
 { // ass dll is loaded if ass library is available
-    getSubImages(pts, boundingRect, &m_image, false);
-    m_assimages.reset();
-    return m_image;
+    const RenderedSubs r(rendered(pts, true));
+    if (boundingRect)
+        *boundingRect = r.bound;
+    return r.image;
 }
 
 SubImageSet SubtitleProcessorLibASS::getSubImages(qreal pts, QRect *boundingRect)
 {
-    m_assimages = getSubImages(pts, boundingRect, NULL, true);
-    return m_assimages;
+    const RenderedSubs r(rendered(pts, false));
+    if (boundingRect)
+        *boundingRect = r.bound;
+    return r.images;
 }
 
-SubImageSet SubtitleProcessorLibASS::getSubImages(qreal pts, QRect *boundingRect, QImage *qimg, bool copy)
-{ // ass dll is loaded if ass library is available
+RenderedSubs SubtitleProcessorLibASS::rendered(qreal pts, bool image)
+{
+    const qint64 ms = (qint64)(pts * 1000.0);
+    RenderedSubs r;
+    if (findRendered(ms, image, &r))
+        return r;
+    return renderSync(ms, image);
+}
+
+bool SubtitleProcessorLibASS::findRendered(qint64 ms, bool image, RenderedSubs *r)
+{
+    QMutexLocker lock(&m_rendered_mutex);
+    Q_UNUSED(lock);
+    // the step is the interval of requests, e.g. frame duration
+    const qint64 dt = ms - m_cursor;
+    if (m_cursor >= 0 && dt > 0 && dt < 1000)
+        m_step = qBound<qint64>(10, dt, 100);
+    m_cursor = ms;
+    m_want_image |= image;
+    if (m_lookahead > 0 && ass::api::loaded()) {
+        if (!m_thread) {
+            m_thread = new LookaheadThread(this);
+            m_thread->start(QThread::LowPriority);
+        }
+        m_lookahead_pending = true;
+        m_lookahead_cond.wakeAll();
+    }
+    const QSize size(frameWidth(), frameHeight());
+    for (int i = 0; i < m_rendered.size(); ++i) {
+        RenderedSubs &c = m_rendered[i];
+        if (c.begin > ms || c.end <= ms || c.size != size || c.generation != m_generation)
+            continue;
+        if (image && c.image.isNull() && c.images.isValid())
+            rasterize(&c);
+        *r = c;
+        return true;
+    }
+    return false;
+}
+
+bool SubtitleProcessorLibASS::ensureRenderer()
+{
+    if (!isFontCacheReady()) // text only until ready
+        return false;
     {
     QMutexLocker lock(&m_mutex);
     Q_UNUSED(lock);
     if (!m_ass) {
         qWarning("ass library not available");
-        return SubImageSet();
+        return false;
     }
     if (!m_track) {
         qWarning("ass track not available");
-        return SubImageSet();
+        return false;
     }
     if (!m_renderer) {
         initRenderer();
         if (!m_renderer) {
             qWarning("ass renderer not available");
-            return SubImageSet();
+            return false;
         }
     }
     }
     if (m_update_cache)
         updateFontCache();
+    return true;
+}
 
+RenderedSubs SubtitleProcessorLibASS::renderSync(qint64 ms, bool image)
+{ // ass dll is loaded if ass library is available
+    RenderedSubs r;
+    if (!ensureRenderer())
+        return r;
+    int generation = 0;
+    qint64 step = 0;
+    {
+        QMutexLocker lock(&m_rendered_mutex);
+        Q_UNUSED(lock);
+        generation = m_generation;
+        step = m_step;
+    }
     QMutexLocker lock(&m_mutex);
     Q_UNUSED(lock);
     if (!m_renderer) //reset in setFontXXX
-        return SubImageSet();
+        return r;
+    renderAt(ms, -1, step, generation, &r);
+    QMutexLocker rlock(&m_rendered_mutex);
+    Q_UNUSED(rlock);
+    if (image && r.images.isValid())
+        rasterize(&r);
+    insertRendered(r, true, -1);
+    return r;
+}
+
+bool SubtitleProcessorLibASS::renderAt(qint64 ms, qint64 prev_at, qint64 step, int generation, RenderedSubs *r)
+{
+    bool animated = false;
+    const qint64 next = nextTransition(ms, &animated);
     int detect_change = 0;
-    ASS_Image *img = ass_render_frame(m_renderer, m_track, (long long)(pts * 1000.0), &detect_change);
-    if (!detect_change && !m_assimages.isValid()) {
-        if (boundingRect)
-            *boundingRect = m_bound;
-        return m_assimages;
-    }
-    m_image = QImage();
-    m_assimages.reset(frameWidth(), frameHeight(), SubImageSet::ASS);
+    ASS_Image *img = ass_render_frame(m_renderer, m_track, (long long)ms, &detect_change);
+    const bool same = !detect_change && prev_at >= 0 && prev_at == m_last_render && generation == m_last_render_generation;
+    m_last_render = ms;
+    m_last_render_generation = generation;
+    r->begin = ms;
+    r->end = next < 0 ? kForever : next;
+    if (animated)
+        r->end = qMin(r->end, ms + step);
+    r->rendered_at = ms;
+    r->generation = generation;
+    r->size = QSize(frameWidth(), frameHeight());
+    if (same)
+        return false;
+    r->images.reset(frameWidth(), frameHeight(), SubImageSet::ASS);
     QRect rect(0, 0, 0, 0);
     ASS_Image *i = img;
     while (i) {
@@ -364,35 +548,227 @@ SubImageSet SubtitleProcessorLibASS::getSubImages(qreal pts, QRect *boundingRect
         }
         SubImage s(i->dst_x, i->dst_y, i->w, i->h, i->stride);
         s.color = i->color;
-        if (copy) {
-            s.data.reserve(i->stride*i->h);
-            s.data.resize(i->stride*i->h);
-            memcpy(s.data.data(), i->bitmap, i->stride*(i->h-1) + i->w);
-        } else {
-            s.data = QByteArray::fromRawData((const char*)i->bitmap, i->stride*(i->h-1) + i->w);
-        }
-        m_assimages.images.append(s);
+        s.data.reserve(i->stride*i->h);
+        s.data.resize(i->stride*i->h);
+        memcpy(s.data.data(), i->bitmap, i->stride*(i->h-1) + i->w);
+        r->images.images.append(s);
         rect |= QRect(i->dst_x, i->dst_y, i->w, i->h);
         i = i->next;
     }
-    m_bound = rect;
-    if (boundingRect) {
-        *boundingRect = m_bound;
+    r->bound = rect;
+    return true;
+}
+
+static bool isAnimated(const ASS_Event& e)
+{
+    if (e.Effect && *e.Effect) // banner, scroll
+        return true;
+    if (!e.Text)
+        return false;
+    static const char* kTags[] = { "\\t(", "\\move", "\\fad", "\\k", "\\K" };
+    for (size_t i = 0; i < sizeof(kTags)/sizeof(kTags[0]); ++i) {
+        if (strstr(e.Text, kTags[i]))
+            return true;
+    }
+    return false;
+}
+
+qint64 SubtitleProcessorLibASS::nextTransition(qint64 ms, bool *animated) const
+{
+    qint64 next = -1;
+    for (int i = 0; i < m_track->n_events; ++i) {
+        const ASS_Event& e = m_track->events[i];
+        const qint64 t[] = { e.Start, e.Start + e.Duration };
+        for (int k = 0; k < 2; ++k) {
+            if (t[k] > ms && (next < 0 || t[k] < next))
+                next = t[k];
+        }
+        if (animated && !*animated && t[0] <= ms && ms < t[1])
+            *animated = isAnimated(e);
+    }
+    return next;
+}
+
+int SubtitleProcessorLibASS::transitions(qint64 from, qint64 to) const
+{
+    int n = 0;
+    for (int i = 0; i < m_track->n_events; ++i) {
+        const ASS_Event& e = m_track->events[i];
+        if (e.Start > from && e.Start <= to)
+            ++n;
+        if (e.Start + e.Duration > from && e.Start + e.Duration <= to)
+            ++n;
+    }
+    return n;
+}
+
+bool SubtitleProcessorLibASS::insertRendered(const RenderedSubs &r, bool changed, qint64 prev_at)
+{
+    if (r.generation != m_generation)
+        return false;
+    for (int i = m_rendered.size() - 1; i >= 0; --i) {
+        if (m_rendered.at(i).generation == m_generation && m_rendered.at(i).size == r.size)
+            continue;
+        recycle(&m_rendered[i].image);
+        m_rendered.removeAt(i);
+    }
+    if (!changed) { // extend the range
+        for (int i = 0; i < m_rendered.size(); ++i) {
+            RenderedSubs &c = m_rendered[i];
+            if (c.rendered_at != prev_at || c.end != r.begin)
+                continue;
+            c.end = r.end;
+            c.rendered_at = r.rendered_at;
+            return true;
+        }
+        return false;
+    }
+    while (m_rendered.size() >= kMaxRendered) {
+        // drop the range farthest behind the cursor, otherwise the farthest ahead
+        int k = 0;
+        for (int i = 1; i < m_rendered.size(); ++i) {
+            const RenderedSubs &c = m_rendered.at(i);
+            const RenderedSubs &ck = m_rendered.at(k);
+            if (ck.end <= m_cursor) {
+                if (c.end < ck.end)
+                    k = i;
+            } else if (c.end <= m_cursor || c.begin > ck.begin) {
+                k = i;
+            }
+        }
+        recycle(&m_rendered[k].image);
+        m_rendered.removeAt(k);
+    }
+    m_rendered.append(r);
+    return true;
+}
+
+void SubtitleProcessorLibASS::rasterize(RenderedSubs *r)
+{
+    QImage img;
+    for (int i = 0; i < m_image_pool.size(); ++i) {
+        if (m_image_pool.at(i).size() == r->bound.size()) {
+            img = m_image_pool.takeAt(i);
+            break;
+        }
+    }
+    if (img.isNull())
+        img = QImage(r->bound.size(), QImage::Format_ARGB32);
+    img.fill(Qt::transparent);
+    foreach (const SubImage& i, r->images.images) {
+        RenderASS(&img, i, i.x - r->bound.x(), i.y - r->bound.y());
+    }
+    r->image = img;
+}
+
+void SubtitleProcessorLibASS::recycle(QImage *image)
+{
+    const QImage img(*image);
+    *image = QImage();
+    // reuse if not referenced by others
+    if (!img.isNull() && m_image_pool.size() < kMaxPooledImages && img.isDetached())
+        m_image_pool.append(img);
+}
+
+void SubtitleProcessorLibASS::invalidateRendered()
+{
+    QMutexLocker lock(&m_rendered_mutex);
+    Q_UNUSED(lock);
+    ++m_generation;
+    for (int i = 0; i < m_rendered.size(); ++i)
+        recycle(&m_rendered[i].image);
+    m_rendered.clear();
+}
+
+void SubtitleProcessorLibASS::invalidateRendered(qint64 begin, qint64 end)
+{
+    QMutexLocker lock(&m_rendered_mutex);
+    Q_UNUSED(lock);
+    // a render in flight may not see the new events, so it is rejected by the new generation
+    const int generation = m_generation++;
+    for (int i = m_rendered.size() - 1; i >= 0; --i) {
+        RenderedSubs &c = m_rendered[i];
+        if (c.generation == generation && (c.end <= begin || c.begin >= end)) {
+            c.generation = m_generation;
+            continue;
+        }
+        recycle(&c.image);
+        m_rendered.removeAt(i);
+    }
+    if (m_thread) {
+        m_lookahead_pending = true;
+        m_lookahead_cond.wakeAll();
     }
-    if (!qimg)
-        return m_assimages;
-    *qimg = QImage(rect.size(), QImage::Format_ARGB32);
-    qimg->fill(Qt::transparent);
-    foreach (const SubImage& i, m_assimages.images) {
-        RenderASS(qimg, i, i.x - rect.x(), i.y - rect.y());
+}
+
+void SubtitleProcessorLibASS::lookahead()
+{
+    forever {
+        qint64 cursor = 0, t = 0, prev_at = -1, step = 0;
+        int generation = 0;
+        {
+            QMutexLocker lock(&m_rendered_mutex);
+            Q_UNUSED(lock);
+            while (!m_stop && !m_lookahead_pending)
+                m_lookahead_cond.wait(&m_rendered_mutex);
+            if (m_stop)
+                return;
+            cursor = m_cursor;
+            generation = m_generation;
+            step = m_step;
+            // the first pts not rendered after cursor
+            t = cursor;
+            const QSize size(frameWidth(), frameHeight());
+            int ahead = 0;
+            for (int i = 0; i < m_rendered.size() && t != kForever; ++i) {
+                const RenderedSubs &c = m_rendered.at(i);
+                if (c.begin > t || c.end <= t || c.size != size || c.generation != m_generation)
+                    continue;
+                t = c.end;
+                prev_at = c.rendered_at;
+                ++ahead;
+                i = -1;
+            }
+            if (t == kForever || ahead >= kMaxRendered/2) {
+                m_lookahead_pending = false;
+                continue;
+            }
+        }
+        if (!ensureRenderer()) {
+            QMutexLocker lock(&m_rendered_mutex);
+            Q_UNUSED(lock);
+            m_lookahead_pending = false;
+            continue;
+        }
+        RenderedSubs r;
+        bool changed = false;
+        {
+            QMutexLocker lock(&m_mutex);
+            Q_UNUSED(lock);
+            if (!m_renderer || !m_track || frameWidth() <= 0 || frameHeight() <= 0 || transitions(cursor, t) >= m_lookahead) {
+                QMutexLocker rlock(&m_rendered_mutex);
+                Q_UNUSED(rlock);
+                if (m_cursor == cursor && m_generation == generation)
+                    m_lookahead_pending = false;
+                continue;
+            }
+            changed = renderAt(t, prev_at, step, generation, &r);
+        }
+        QMutexLocker lock(&m_rendered_mutex);
+        Q_UNUSED(lock);
+        if (changed && m_want_image && r.images.isValid())
+            rasterize(&r);
+        insertRendered(r, changed, prev_at);
     }
-    return m_assimages;
 }
 
 void SubtitleProcessorLibASS::onFrameSizeChanged(int width, int height)
 {
     if (width < 0 || height < 0)
         return;
+    invalidateRendered();
+    QMutexLocker lock(&m_mutex);
+    Q_UNUSED(lock);
     if (!m_renderer) {
         initRenderer();
     }
@@ -407,6 +783,7 @@ void SubtitleProcessorLibASS::setFontFile(const QString &file)
         return;
     font_file = file;
     m_update_cache = true; //update renderer when getting the next image
+    invalidateRendered();
     if (m_renderer) {
         QMutexLocker lock(&m_mutex);
         Q_UNUSED(lock);
@@ -424,6 +801,7 @@ void SubtitleProcessorLibASS::setFontFileForced(bool force)
     force_font_file = force;
     // FIXME: sometimes crash
     m_update_cache = true; //update renderer when getting the next image
+    invalidateRendered();
     if (m_renderer) {
         QMutexLocker lock(&m_mutex);
         Q_UNUSED(lock);
@@ -440,6 +818,7 @@ void SubtitleProcessorLibASS::setFontsDir(const QString &dir)
         return;
     fonts_dir = dir;
     m_update_cache = true; //update renderer when getting the next image
+    invalidateRendered();
     if (m_renderer) {
         QMutexLocker lock(&m_mutex);
         Q_UNUSED(lock);
@@ -464,13 +843,99 @@ bool SubtitleProcessorLibASS::initRenderer()
 #endif
     return true;
 }
-// TODO: set font cache dir. default is working dir which may be not writable on some platforms
-void SubtitleProcessorLibASS::updateFontCache()
-{ // ass dll is loaded if renderer is valid
-    QMutexLocker lock(&m_mutex);
+namespace {
+// process wide font settings, looked up once
+struct FontConfig {
+    QString conf; // fonts.conf
+    QString font; // default.ttf. if exists, font provider can be disabled
+    QString fonts_dir;
+    QByteArray family;
+};
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+/*!
+ * The config file fontconfig loads by default, i.e. FONTCONFIG_FILE, FONTCONFIG_PATH or the path built in fontconfig
+ * (/etc/fonts, /usr/local/etc/fonts etc.). fontconfig is loaded by libass, so resolve it at runtime.
+ * Empty if fontconfig is not found
+ */
+static QString systemFontConfig()
+{
+    typedef unsigned char* (*FcConfigFilename_t)(const unsigned char*);
+    typedef void (*FcStrFree_t)(unsigned char*);
+    QLibrary fc(QStringLiteral("fontconfig"), 1);
+    if (!fc.load()) {
+        qDebug() << "fontconfig is not loaded: " << fc.errorString();
+        return QString::fromLocal8Bit(qgetenv("FONTCONFIG_FILE"));
+    }
+    FcConfigFilename_t fcConfigFilename = (FcConfigFilename_t)fc.resolve("FcConfigFilename");
+    FcStrFree_t fcStrFree = (FcStrFree_t)fc.resolve("FcStrFree");
+    if (!fcConfigFilename)
+        return QString();
+    unsigned char *f = fcConfigFilename(0);
+    if (!f)
+        return QString();
+    const QString file(QString::fromLocal8Bit((const char*)f));
+    if (fcStrFree)
+        fcStrFree(f);
+    return file; // fontconfig stays loaded by libass, do not unload
+}
+#endif
+
+// fontconfig can not write the cache if the config is not writable (e.g. android). use a config with a writable cache dir
+static QString writeFontConfig(const QString& fontsDir)
+{
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+    const QString sysConf(systemFontConfig());
+    if (sysConf.isEmpty() || !QFile::exists(sysConf)) { // system fonts must not be lost. let fontconfig load its default config
+        qDebug("system fontconfig file is unknown. use the default config");
+        return QString();
+    }
+    const QString dir(Internal::Path::appDataDir() + QStringLiteral("/fontconfig"));
+    const QString cacheDir(dir + QStringLiteral("/cache"));
+    if (!QDir().mkpath(cacheDir)) {
+        qWarning("Failed to create fontconfig cache dir: %s", cacheDir.toUtf8().constData());
+        return QString();
+    }
+    QStringList dirs;
+    if (!fontsDir.isEmpty())
+        dirs << fontsDir;
+    if (!Internal::Path::fontsDir().isEmpty())
+        dirs << Internal::Path::fontsDir();
+    QByteArray xml("<?xml version=\"1.0\"?>\n<!DOCTYPE fontconfig SYSTEM \"fonts.dtd\">\n<fontconfig>\n");
+    xml += "  <include>" + QString(sysConf).replace(QLatin1Char('&'), QStringLiteral("&amp;")).replace(QLatin1Char('<'), QStringLiteral("&lt;")).toUtf8() + "</include>\n";
+    foreach (const QString& d, dirs) {
+        xml += "  <dir>" + QString(d).replace(QLatin1Char('&'), QStringLiteral("&amp;")).replace(QLatin1Char('<'), QStringLiteral("&lt;")).toUtf8() + "</dir>\n";
+    }
+    xml += "  <cachedir>" + QString(cacheDir).replace(QLatin1Char('&'), QStringLiteral("&amp;")).replace(QLatin1Char('<'), QStringLiteral("&lt;")).toUtf8() + "</cachedir>\n</fontconfig>\n";
+    QFile f(dir + QStringLiteral("/fonts.conf"));
+    if (f.open(QIODevice::ReadOnly)) {
+        if (f.readAll() == xml)
+            return f.fileName();
+        f.close();
+    }
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate) || f.write(xml) != xml.size()) {
+        qWarning() << "Failed to write " << f.fileName() << ": " << f.errorString();
+        return QString();
+    }
+    qDebug() << "fontconfig cache dir: " << cacheDir;
+    return f.fileName();
+#else
+    Q_UNUSED(fontsDir);
+    return QString();
+#endif
+}
+
+// thread safe
+static const FontConfig& fontConfig()
+{
+    static QMutex mutex;
+    QMutexLocker lock(&mutex);
     Q_UNUSED(lock);
-    if (!m_renderer)
-        return;
+    static FontConfig config;
+    static bool done = false;
+    if (done)
+        return config;
+    done = true;
     // fonts in assets and qrc may change. so check before appFontsDir
     static const QStringList kFontsDirs = QStringList()
             << qApp->applicationDirPath().append(QLatin1String("/fonts"))
@@ -482,9 +947,8 @@ void SubtitleProcessorLibASS::updateFontCache()
             << Internal::Path::fontsDir()
 #endif
                ;
-    // TODO: modify fontconfig cache dir in fonts.conf <dir></dir> then save to conf
-    static QString conf(0, QChar()); //FC_CONFIG_FILE?
-    if (conf.isEmpty() && !conf.isNull()) {
+    QString conf(0, QChar()); //FC_CONFIG_FILE?
+    {
         static const QString kFontCfg(QStringLiteral("fonts.conf"));
         foreach (const QString& fdir, kFontsDirs) {
             qDebug() << "looking up " << kFontCfg << " in: " << fdir;
@@ -530,9 +994,9 @@ void SubtitleProcessorLibASS::updateFontCache()
      * (for example fontconfig) to speed up(skip) libass font look up.
      * Skip setting fonts dir
      */
-    static QString sFont(0, QChar()); // if exists, fontconfig will be disabled and directly use this font
-    static QString sFontsDir(0, QChar());
-    if (sFontsDir.isEmpty() && !sFontsDir.isNull()) {
+    QString sFont(0, QChar()); // if exists, fontconfig will be disabled and directly use this font
+    QString sFontsDir(0, QChar());
+    {
         static const QString kDefaultFontName(QStringLiteral("default.ttf"));
         static const QStringList ft_filters = QStringList() << QStringLiteral("*.ttf") << QStringLiteral("*.otf") << QStringLiteral("*.ttc");
         QStringList fonts;
@@ -590,13 +1054,31 @@ void SubtitleProcessorLibASS::updateFontCache()
             }
         }
     }
-    static QByteArray family; //fallback to Arial?
-    if (family.isEmpty()) {
-        family = qgetenv("QTAV_SUB_FONT_FAMILY_DEFAULT");
-          //Setting default font to the Arial from default.ttf (used if FontConfig fails)
-        if (family.isEmpty())
-            family = QByteArrayLiteral("Arial");
-    }
+    QByteArray family = qgetenv("QTAV_SUB_FONT_FAMILY_DEFAULT"); //fallback to Arial?
+    //Setting default font to the Arial from default.ttf (used if FontConfig fails)
+    if (family.isEmpty())
+        family = QByteArrayLiteral("Arial");
+    if (conf.isEmpty())
+        conf = writeFontConfig(sFontsDir);
+    config.conf = conf;
+    config.font = sFont;
+    config.fonts_dir = sFontsDir;
+    config.family = family;
+    return config;
+}
+} //namespace
+
+void SubtitleProcessorLibASS::updateFontCache()
+{ // ass dll is loaded if renderer is valid
+    QMutexLocker lock(&m_mutex);
+    Q_UNUSED(lock);
+    if (!m_renderer)
+        return;
+    const FontConfig& cfg = fontConfig();
+    const QString conf(cfg.conf);
+    const QString sFont(cfg.font);
+    const QString sFontsDir(cfg.fonts_dir);
+    const QByteArray family(cfg.family);
     // prefer user settings
     const QString kFont = font_file.isEmpty() ? sFont : Internal::Path::toLocal(font_file);
     const QString kFontsDir = fonts_dir.isEmpty() ? sFontsDir : Internal::Path::toLocal(fonts_dir);
@@ -629,27 +1111,43 @@ void SubtitleProcessorLibASS::updateFontCache()
     m_update_cache = false; //TODO: set true if user set a new font or fonts dir
 }
 
-void SubtitleProcessorLibASS::updateFontCacheAsync()
+class FontCacheWarmup : public QRunnable, protected ass::api
 {
-    class FontCacheUpdater : public QThread {
-        SubtitleProcessorLibASS *sp;
-    public:
-        FontCacheUpdater(SubtitleProcessorLibASS *p) : sp(p) {}
-        void run() {
-            if (!sp)
-                return;
-            sp->updateFontCache();
+public:
+    void run() Q_DECL_OVERRIDE {
+        QElapsedTimer timer;
+        timer.start();
+        const FontConfig& cfg = fontConfig();
+        ASS_Library *ass = ass::api::loaded() ? ass_library_init() : 0;
+        if (ass) {
+            ass_set_message_cb(ass, ass_msg_cb, NULL);
+#ifndef Q_OS_WINRT
+            if (!cfg.fonts_dir.isEmpty())
+                ass_set_fonts_dir(ass, cfg.fonts_dir.toUtf8().constData());
+#endif
+            ASS_Renderer *renderer = ass_renderer_init(ass);
+            if (renderer) {
+                // fontconfig writes the cache to disk, later font provider setup in renderers reads it
+                const QByteArray conf(cfg.conf.toUtf8());
+                ass_set_fonts(renderer, cfg.font.isEmpty() ? NULL : cfg.font.toUtf8().constData(), cfg.family.constData(), 1, conf.isEmpty() ? 0 : conf.constData(), 1);
+                ass_renderer_done(renderer);
+            }
+            ass_library_done(ass);
         }
-    };
-    FontCacheUpdater updater(this);
-    QEventLoop loop;
-    //QObject::connect(&updater, SIGNAL(finished()), &loop, SLOT(quit()));
-    updater.start();
-    while (updater.isRunning()) {
-        loop.processEvents();
-    }
-    //loop.exec(); // what if updater is finished before exec()?
-    //updater.wait();
+        SubtitleFontCache::instance()->endWarmup(timer.elapsed());
+    }
+};
+
+bool SubtitleProcessorLibASS::isFontCacheReady() const
+{
+    if (force_font_file) // no font provider
+        return true;
+    SubtitleFontCache *fc = SubtitleFontCache::instance();
+    if (fc->isReady())
+        return true;
+    if (fc->beginWarmup())
+        QThreadPool::globalInstance()->start(new FontCacheWarmup());
+    return false;
 }
 
 void SubtitleProcessorLibASS::processTrack(ASS_Track *track)
@@ -0,0 +1,240 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#include "ColorAdjust.h"
+#include "QtAV/VideoFrame.h"
+#include <QtCore/QVector>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLORADJUST_SSE2 1 // baseline on x86_64, no runtime check
+#include <emmintrin.h>
+#endif
+
+namespace QtAV {
+namespace {
+// dst = k*src + t[x], t[x] is the chroma and offset term of luma
+void lumaRow8(quint8 *dst, const quint8 *src, const float *t, int w, float k)
+{
+    int x = 0;
+#if COLORADJUST_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 kk = _mm_set1_ps(k);
+    for (; x + 16 <= w; x += 16) {
+        const __m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+        const __m128i lo = _mm_unpacklo_epi8(s, zero);
+        const __m128i hi = _mm_unpackhi_epi8(s, zero);
+        const __m128 f0 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), kk), _mm_loadu_ps(t + x));
+        const __m128 f1 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), kk), _mm_loadu_ps(t + x + 4));
+        const __m128 f2 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), kk), _mm_loadu_ps(t + x + 8));
+        const __m128 f3 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), kk), _mm_loadu_ps(t + x + 12));
+        // saturated packs clamp to [0, 255]
+        const __m128i p0 = _mm_packs_epi32(_mm_cvtps_epi32(f0), _mm_cvtps_epi32(f1));
+        const __m128i p1 = _mm_packs_epi32(_mm_cvtps_epi32(f2), _mm_cvtps_epi32(f3));
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(p0, p1));
+    }
+#endif
+    for (; x < w; ++x)
+        dst[x] = (quint8)qBound(0, qRound(k*float(src[x]) + t[x]), 255);
+}
+
+void lumaRow16(quint16 *dst, const quint16 *src, const float *t, int w, float k, int maxv)
+{
+    int x = 0;
+#if COLORADJUST_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 kk = _mm_set1_ps(k);
+    const __m128 lo_bound = _mm_setzero_ps();
+    const __m128 hi_bound = _mm_set1_ps(float(maxv));
+    // no unsigned 32 to 16 pack in sse2. pack signed values biased by -32768, then flip the sign bit.
+    // the bias is subtracted from integers, float values near 32768 lose the fraction
+    const __m128i bias = _mm_set1_epi32(32768);
+    const __m128i sign = _mm_set1_epi16((short)0x8000);
+    for (; x + 8 <= w; x += 8) {
+        const __m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+        __m128 f0 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(s, zero)), kk), _mm_loadu_ps(t + x));
+        __m128 f1 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(s, zero)), kk), _mm_loadu_ps(t + x + 4));
+        f0 = _mm_min_ps(_mm_max_ps(f0, lo_bound), hi_bound);
+        f1 = _mm_min_ps(_mm_max_ps(f1, lo_bound), hi_bound);
+        const __m128i p = _mm_packs_epi32(_mm_sub_epi32(_mm_cvtps_epi32(f0), bias), _mm_sub_epi32(_mm_cvtps_epi32(f1), bias));
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_xor_si128(p, sign));
+    }
+#endif
+    for (; x < w; ++x)
+        dst[x] = (quint16)qBound(0, qRound(k*float(src[x]) + t[x]), maxv);
+}
+
+// u' = c[0]*u + c[1]*v + c[2], v' = c[3]*u + c[4]*v + c[5]
+template<typename T>
+void chromaRow(T *du, T *dv, const T *su, const T *sv, int w, const float *c, int maxv)
+{
+    for (int x = 0; x < w; ++x) {
+        const float u = su[x], v = sv[x];
+        du[x] = (T)qBound(0, qRound(c[0]*u + c[1]*v + c[2]), maxv);
+        dv[x] = (T)qBound(0, qRound(c[3]*u + c[4]*v + c[5]), maxv);
+    }
+}
+
+template<>
+void chromaRow<quint8>(quint8 *du, quint8 *dv, const quint8 *su, const quint8 *sv, int w, const float *c, int maxv)
+{
+    int x = 0;
+#if COLORADJUST_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 c0 = _mm_set1_ps(c[0]), c1 = _mm_set1_ps(c[1]), c2 = _mm_set1_ps(c[2]);
+    const __m128 c3 = _mm_set1_ps(c[3]), c4 = _mm_set1_ps(c[4]), c5 = _mm_set1_ps(c[5]);
+    for (; x + 8 <= w; x += 8) {
+        const __m128i u16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(su + x)), zero);
+        const __m128i v16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(sv + x)), zero);
+        const __m128 u0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(u16, zero));
+        const __m128 u1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(u16, zero));
+        const __m128 v0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v16, zero));
+        const __m128 v1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v16, zero));
+        const __m128i ou = _mm_packs_epi32(
+                    _mm_cvtps_epi32(_mm_add_ps(_mm_add_ps(_mm_mul_ps(u0, c0), _mm_mul_ps(v0, c1)), c2)),
+                    _mm_cvtps_epi32(_mm_add_ps(_mm_add_ps(_mm_mul_ps(u1, c0), _mm_mul_ps(v1, c1)), c2)));
+        const __m128i ov = _mm_packs_epi32(
+                    _mm_cvtps_epi32(_mm_add_ps(_mm_add_ps(_mm_mul_ps(u0, c3), _mm_mul_ps(v0, c4)), c5)),
+                    _mm_cvtps_epi32(_mm_add_ps(_mm_add_ps(_mm_mul_ps(u1, c3), _mm_mul_ps(v1, c4)), c5)));
+        const __m128i uv = _mm_packus_epi16(ou, ov); // u in low 8 bytes, v in high 8 bytes
+        _mm_storel_epi64((__m128i*)(du + x), uv);
+        _mm_storel_epi64((__m128i*)(dv + x), _mm_srli_si128(uv, 8));
+    }
+#endif
+    Q_UNUSED(maxv);
+    for (; x < w; ++x) {
+        const float u = su[x], v = sv[x];
+        du[x] = (quint8)qBound(0, qRound(c[0]*u + c[1]*v + c[2]), 255);
+        dv[x] = (quint8)qBound(0, qRound(c[3]*u + c[4]*v + c[5]), 255);
+    }
+}
+
+bool adjustYUV(const VideoFrame &src, VideoFrame &dst, const QMatrix4x4 &m)
+{
+    const VideoFormat fmt(src.format());
+    const int bpc = fmt.bitsPerComponent();
+    const float maxv = float((1 << bpc) - 1);
+    const bool is8 = fmt.bytesPerPixel(0) == 1;
+    const int w = src.width(), h = src.height();
+    const int cw = fmt.width(w, 1), ch = fmt.height(h, 1);
+    if (cw <= 0 || ch <= 0)
+        return false;
+    const float k = m(0, 0);
+    const float ku = m(0, 1), kv = m(0, 2), kc = m(0, 3)*maxv;
+    const float c[] = { m(1, 1), m(1, 2), m(1, 3)*maxv, m(2, 1), m(2, 2), m(2, 3)*maxv };
+    // luma first because it reads the original chroma
+    QVector<float> t(w + 16); // luma term of a chroma row expanded to luma width
+    int last_cy = -1;
+    for (int y = 0; y < h; ++y) {
+        const int cy = y*ch/h;
+        if (cy != last_cy) {
+            last_cy = cy;
+            const uchar *su = src.constBits(1) + cy*src.bytesPerLine(1);
+            const uchar *sv = src.constBits(2) + cy*src.bytesPerLine(2);
+            for (int x = 0; x < w; ++x) {
+                const int cx = x*cw/w;
+                const float u = is8 ? su[cx] : ((const quint16*)su)[cx];
+                const float v = is8 ? sv[cx] : ((const quint16*)sv)[cx];
+                t[x] = ku*u + kv*v + kc;
+            }
+        }
+        const uchar *s = src.constBits(0) + y*src.bytesPerLine(0);
+        uchar *d = dst.bits(0) + y*dst.bytesPerLine(0);
+        if (is8)
+            lumaRow8(d, s, t.constData(), w, k);
+        else
+            lumaRow16((quint16*)d, (const quint16*)s, t.constData(), w, k, int(maxv));
+    }
+    for (int y = 0; y < ch; ++y) {
+        const uchar *su = src.constBits(1) + y*src.bytesPerLine(1);
+        const uchar *sv = src.constBits(2) + y*src.bytesPerLine(2);
+        uchar *du = dst.bits(1) + y*dst.bytesPerLine(1);
+        uchar *dv = dst.bits(2) + y*dst.bytesPerLine(2);
+        if (is8)
+            chromaRow<quint8>(du, dv, su, sv, cw, c, 255);
+        else
+            chromaRow<quint16>((quint16*)du, (quint16*)dv, (const quint16*)su, (const quint16*)sv, cw, c, int(maxv));
+    }
+    if (fmt.planeCount() > 3 && src.constBits(3) != dst.constBits(3)) { // alpha
+        for (int y = 0; y < h; ++y)
+            memcpy(dst.bits(3) + y*dst.bytesPerLine(3), src.constBits(3) + y*src.bytesPerLine(3), w*fmt.bytesPerPixel(3));
+    }
+    return true;
+}
+
+bool adjustRGB32(const VideoFrame &src, VideoFrame &dst, const QMatrix4x4 &m)
+{
+    // table[out][in][value]: out = sum of 3 lookups. fixed point 16.16
+    QVector<qint32> table(3*3*256);
+    for (int o = 0; o < 3; ++o) {
+        for (int i = 0; i < 3; ++i) {
+            qint32 *tb = table.data() + (o*3 + i)*256;
+            // the offset is added to the first input channel
+            const float offset = i == 0 ? m(o, 3)*255.0f : 0.0f;
+            for (int v = 0; v < 256; ++v)
+                tb[v] = qint32((m(o, i)*float(v) + offset)*65536.0f);
+        }
+    }
+    const qint32 *t = table.constData();
+    // shift of r, g, b in a native 32 bit pixel
+    const bool bgr = src.format().pixelFormat() == VideoFormat::Format_BGR32;
+    const int sr = bgr ? 0 : 16, sg = 8, sb = bgr ? 16 : 0;
+    for (int y = 0; y < src.height(); ++y) {
+        const quint32 *s = (const quint32*)(src.constBits(0) + y*src.bytesPerLine(0));
+        quint32 *d = (quint32*)(dst.bits(0) + y*dst.bytesPerLine(0));
+        for (int x = 0; x < src.width(); ++x) {
+            const quint32 p = s[x];
+            const int r = (p >> sr) & 0xff, g = (p >> sg) & 0xff, b = (p >> sb) & 0xff;
+            const int r1 = qBound(0, (t[r] + t[256 + g] + t[512 + b] + 32768) >> 16, 255);
+            const int g1 = qBound(0, (t[768 + r] + t[1024 + g] + t[1280 + b] + 32768) >> 16, 255);
+            const int b1 = qBound(0, (t[1536 + r] + t[1792 + g] + t[2048 + b] + 32768) >> 16, 255);
+            d[x] = (p & 0xff000000) | (quint32(r1) << sr) | (quint32(g1) << sg) | (quint32(b1) << sb);
+        }
+    }
+    return true;
+}
+} //namespace
+
+bool colorAdjustSupported(const VideoFormat &fmt)
+{
+    switch (fmt.pixelFormat()) {
+    case VideoFormat::Format_RGB32:
+    case VideoFormat::Format_BGR32:
+        return true;
+    default:
+        break;
+    }
+    if (fmt.isRGB() || !fmt.isPlanar() || fmt.planeCount() < 3 || fmt.isBigEndian() || fmt.isHWAccelerated())
+        return false;
+    const int bpc = fmt.bitsPerComponent();
+    return bpc >= 8 && bpc <= 16 && fmt.bytesPerPixel(0) == (bpc + 7)/8;
+}
+
+bool colorAdjust(const VideoFrame &src, VideoFrame &dst, const QMatrix4x4 &m)
+{
+    const VideoFormat fmt(src.format());
+    if (!colorAdjustSupported(fmt) || !src.constBits(0))
+        return false;
+    if (dst.format() != fmt || dst.width() != src.width() || dst.height() != src.height() || !dst.bits(0))
+        return false;
+    if (fmt.isRGB())
+        return adjustRGB32(src, dst, m);
+    return adjustYUV(src, dst, m);
+}
+} //namespace QtAV
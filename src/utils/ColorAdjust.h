@@ -0,0 +1,47 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#ifndef QTAV_COLORADJUST_H
+#define QTAV_COLORADJUST_H
+
+#include <QtAV/QtAV_Global.h>
+#include <QtGui/QMatrix4x4>
+
+namespace QtAV {
+class VideoFormat;
+class VideoFrame;
+/*!
+ * \brief colorAdjustSupported
+ * Planar yuv of 8~16 bits (little endian) and packed 32 bit rgb(Format_RGB32, Format_BGR32)
+ */
+Q_AV_PRIVATE_EXPORT bool colorAdjustSupported(const VideoFormat& fmt);
+/*!
+ * \brief colorAdjust
+ * Apply the top 3x4 of a ColorTransform matrix to a frame in host memory. Components are normalized to [0, 1] as in shaders,
+ * so a matrix from ColorTransform with the same input and output color space (yuv or rgb) can be used directly.
+ * For yuv, chroma rows must not depend on luma, which is true for brightness, contrast, saturation and hue because gray stays
+ * gray. Luma can depend on chroma. Alpha is not changed.
+ * \param dst the same format and size as \a src. can be \a src to work in place
+ * \return false if not supported
+ */
+Q_AV_PRIVATE_EXPORT bool colorAdjust(const VideoFrame& src, VideoFrame& dst, const QMatrix4x4& m);
+} //namespace QtAV
+#endif //QTAV_COLORADJUST_H
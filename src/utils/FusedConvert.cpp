@@ -0,0 +1,220 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+#include "QtAV/private/FusedConvert.h"
+#include "QtAV/VideoFrame.h"
+#include <QtCore/QVector>
+#include <QtGui/QMatrix4x4>
+#include <string.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FUSEDCONVERT_SSE2 1 // baseline on x86_64, no runtime check
+#include <emmintrin.h>
+#endif
+
+namespace QtAV {
+namespace {
+/*
+ * Interpolated components are 8 bit values with 6 fraction bits (0~16320), matrix coefficients have 11 fraction bits,
+ * so a product has 17 fraction bits and fits in 16 bit multiplications (madd).
+ */
+enum {
+    kWeightBits = 6,
+    kCoeffBits = 11,
+    kShift = kWeightBits + kCoeffBits
+};
+
+// bilinear sample positions of an axis, pixel centers aligned
+struct Tap {
+    int i0, i1;
+    int w; // weight of i1, 0~64
+};
+
+void computeTaps(QVector<Tap> *taps, int dstLen, int srcLen)
+{
+    taps->resize(dstLen);
+    const double scale = double(srcLen)/double(dstLen);
+    for (int i = 0; i < dstLen; ++i) {
+        const double p = qBound(0.0, (double(i) + 0.5)*scale - 0.5, double(srcLen - 1));
+        Tap &t = (*taps)[i];
+        t.i0 = int(p);
+        t.i1 = qMin(t.i0 + 1, srcLen - 1);
+        t.w = qRound((p - double(t.i0))*double(1 << kWeightBits));
+        if (t.w == (1 << kWeightBits)) { // rounded to the next pixel
+            t.i0 = t.i1;
+            t.w = 0;
+        }
+    }
+}
+
+void scaleRow(qint16 *dst, const quint8 *src, const Tap *taps, int w)
+{
+    for (int x = 0; x < w; ++x) {
+        const Tap &t = taps[x];
+        dst[x] = qint16((int(src[t.i0]) << kWeightBits) + (int(src[t.i1]) - int(src[t.i0]))*t.w);
+    }
+}
+
+/*!
+ * Horizontally scaled rows of a plane. Destination rows read 2 adjacent source rows in increasing order, so 2 cached rows
+ * are enough and every source row is scaled at most once.
+ */
+class RowCache
+{
+public:
+    RowCache(const quint8 *bits, int stride, const Tap *taps, int w)
+        : m_bits(bits)
+        , m_stride(stride)
+        , m_taps(taps)
+        , m_w(w)
+        , m_buf(2*w)
+    {
+        m_row[0] = m_row[1] = -1;
+    }
+    // get scaled source rows r0 and r1
+    void get(int r0, int r1, const qint16 **p0, const qint16 **p1) {
+        const int s0 = slotOf(r0, -1);
+        const int s1 = slotOf(r1, s0);
+        *p0 = m_buf.constData() + s0*m_w;
+        *p1 = m_buf.constData() + s1*m_w;
+    }
+private:
+    int slotOf(int r, int keep) {
+        for (int s = 0; s < 2; ++s) {
+            if (m_row[s] == r)
+                return s;
+        }
+        // replace the slot not required by the other row, the smaller row otherwise
+        int s = m_row[0] <= m_row[1] ? 0 : 1;
+        if (s == keep)
+            s = 1 - s;
+        m_row[s] = r;
+        scaleRow(m_buf.data() + s*m_w, m_bits + r*m_stride, m_taps, m_w);
+        return s;
+    }
+    const quint8 *m_bits;
+    int m_stride;
+    const Tap *m_taps;
+    int m_w;
+    QVector<qint16> m_buf;
+    int m_row[2];
+};
+
+void blendRows(qint16 *dst, const qint16 *r0, const qint16 *r1, int w, int wy)
+{
+    if (wy == 0) {
+        memcpy(dst, r0, w*sizeof(qint16));
+        return;
+    }
+    const int round = 1 << (kWeightBits - 1);
+    for (int x = 0; x < w; ++x)
+        dst[x] = qint16(r0[x] + (((int(r1[x]) - int(r0[x]))*wy + round) >> kWeightBits));
+}
+
+// c[ch*4 + k]: coefficients of y, u, v and the offset for r, g and b
+void yuvToRGB32(quint32 *dst, const qint16 *py, const qint16 *pu, const qint16 *pv, int w, const qint32 *c)
+{
+    int x = 0;
+#if FUSEDCONVERT_SSE2
+    __m128i cyu[3], cv0[3], off[3];
+    for (int ch = 0; ch < 3; ++ch) {
+        cyu[ch] = _mm_set1_epi32(int((quint32(quint16(c[ch*4 + 1])) << 16) | quint16(c[ch*4])));
+        cv0[ch] = _mm_set1_epi32(int(quint16(c[ch*4 + 2])));
+        off[ch] = _mm_set1_epi32(c[ch*4 + 3]);
+    }
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi8((char)0xff);
+    for (; x + 8 <= w; x += 8) {
+        const __m128i y = _mm_loadu_si128((const __m128i*)(py + x));
+        const __m128i u = _mm_loadu_si128((const __m128i*)(pu + x));
+        const __m128i v = _mm_loadu_si128((const __m128i*)(pv + x));
+        const __m128i yu_lo = _mm_unpacklo_epi16(y, u), yu_hi = _mm_unpackhi_epi16(y, u);
+        const __m128i v_lo = _mm_unpacklo_epi16(v, zero), v_hi = _mm_unpackhi_epi16(v, zero);
+        __m128i rgb[3];
+        for (int ch = 0; ch < 3; ++ch) {
+            const __m128i lo = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yu_lo, cyu[ch]), _mm_madd_epi16(v_lo, cv0[ch])), off[ch]), kShift);
+            const __m128i hi = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yu_hi, cyu[ch]), _mm_madd_epi16(v_hi, cv0[ch])), off[ch]), kShift);
+            rgb[ch] = _mm_packs_epi32(lo, hi);
+        }
+        // saturated packs clamp to [0, 255]. memory order of native 0xAARRGGBB is b, g, r, a
+        const __m128i bg = _mm_unpacklo_epi8(_mm_packus_epi16(rgb[2], zero), _mm_packus_epi16(rgb[1], zero));
+        const __m128i ra = _mm_unpacklo_epi8(_mm_packus_epi16(rgb[0], zero), alpha);
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i*)(dst + x + 4), _mm_unpackhi_epi16(bg, ra));
+    }
+#endif
+    for (; x < w; ++x) {
+        const int y = py[x], u = pu[x], v = pv[x];
+        const int r = qBound(0, (c[0]*y + c[1]*u + c[2]*v + c[3]) >> kShift, 255);
+        const int g = qBound(0, (c[4]*y + c[5]*u + c[6]*v + c[7]) >> kShift, 255);
+        const int b = qBound(0, (c[8]*y + c[9]*u + c[10]*v + c[11]) >> kShift, 255);
+        dst[x] = 0xff000000 | (quint32(r) << 16) | (quint32(g) << 8) | quint32(b);
+    }
+}
+} //namespace
+
+bool canFusedConvert(const VideoFormat &format)
+{
+    if (format.isRGB() || !format.isPlanar() || format.planeCount() < 3 || format.isHWAccelerated())
+        return false;
+    return format.bitsPerComponent() == 8 && format.bytesPerPixel(0) == 1;
+}
+
+bool fusedConvertRGB32(const VideoFrame &frame, const QMatrix4x4 &m, uchar *dst, int dstStride, const QSize &dstSize)
+{
+    const VideoFormat fmt(frame.format());
+    if (!canFusedConvert(fmt) || !frame.constBits(0) || !dst || dstSize.isEmpty())
+        return false;
+    const int w = frame.width(), h = frame.height();
+    const int cw = fmt.width(w, 1), ch = fmt.height(h, 1);
+    if (w <= 0 || h <= 0 || cw <= 0 || ch <= 0)
+        return false;
+    const int dw = dstSize.width(), dh = dstSize.height();
+    qint32 c[12];
+    for (int i = 0; i < 3; ++i) {
+        for (int k = 0; k < 3; ++k) // in the range of 16 bit multiplication. |m(i, k)| < 16 in practice
+            c[i*4 + k] = qBound(-32768, qRound(m(i, k)*float(1 << kCoeffBits)), 32767);
+        c[i*4 + 3] = qRound(m(i, 3)*255.0f*float(1 << kShift)) + (1 << (kShift - 1));
+    }
+    QVector<Tap> xl, yl, xc, yc;
+    computeTaps(&xl, dw, w);
+    computeTaps(&yl, dh, h);
+    computeTaps(&xc, dw, cw);
+    computeTaps(&yc, dh, ch);
+    RowCache rows[] = {
+        RowCache(frame.constBits(0), frame.bytesPerLine(0), xl.constData(), dw),
+        RowCache(frame.constBits(1), frame.bytesPerLine(1), xc.constData(), dw),
+        RowCache(frame.constBits(2), frame.bytesPerLine(2), xc.constData(), dw)
+    };
+    QVector<qint16> yuv(3*dw);
+    qint16 *py = yuv.data(), *pu = py + dw, *pv = pu + dw;
+    for (int y = 0; y < dh; ++y) {
+        const qint16 *r0, *r1;
+        rows[0].get(yl[y].i0, yl[y].i1, &r0, &r1);
+        blendRows(py, r0, r1, dw, yl[y].w);
+        rows[1].get(yc[y].i0, yc[y].i1, &r0, &r1);
+        blendRows(pu, r0, r1, dw, yc[y].w);
+        rows[2].get(yc[y].i0, yc[y].i1, &r0, &r1);
+        blendRows(pv, r0, r1, dw, yc[y].w);
+        yuvToRGB32((quint32*)(dst + y*dstStride), py, pu, pv, dw, c);
+    }
+    return true;
+}
+} //namespace QtAV
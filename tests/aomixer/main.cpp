@@ -0,0 +1,130 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2016 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2014)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+/*
+ * Play sine waves from many AudioOutputs sharing one device via the Mixer backend, and check the pacing of each output
+ * usage: aomixer [-ao Mixer|MixerNull] [-n count] [-t msecs]
+ * MixerNull needs no audio device.
+ */
+#include <QtCore/qmath.h>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+#include <QtAV/AudioOutput.h>
+#include <QtDebug>
+
+using namespace QtAV;
+const int kFrames = 512;
+
+class Feeder : public QThread
+{
+public:
+    Feeder(const QString& backend, int index, qint64 msecs)
+        : m_backend(backend), m_index(index), m_msecs(msecs), m_played(0), m_elapsed(0), m_ok(false)
+    {}
+    qint64 playedMSecs() const { return m_played;}
+    qint64 elapsedMSecs() const { return m_elapsed;}
+    bool ok() const { return m_ok;}
+protected:
+    void run() {
+        AudioOutput ao;
+        ao.setBackends(QStringList() << m_backend);
+        AudioFormat af;
+        af.setChannels(2);
+        af.setSampleFormat(AudioFormat::SampleFormat_Signed16);
+        af.setSampleRate(m_index % 2 ? 44100 : 48000); // inputs in different formats are resampled
+        ao.setAudioFormat(af);
+        ao.setBufferSamples(kFrames);
+        ao.setVolume(1.0/qreal(m_index + 1));
+        if (!ao.open()) {
+            qWarning("open audio error");
+            return;
+        }
+        QByteArray data(af.bytesPerFrame()*kFrames, 0);
+        const qreal freq = 220.0*qreal(m_index + 1);
+        qint64 frames = 0;
+        QElapsedTimer timer;
+        timer.start();
+        while (timer.elapsed() < m_msecs) {
+            qint16 *d = (qint16*)data.data();
+            for (int k = 0; k < kFrames; ++k, ++frames) {
+                const qint16 v = qint16(8000.0*sin(2.0*M_PI*freq*qreal(frames)/qreal(af.sampleRate())));
+                *d++ = v;
+                *d++ = v;
+            }
+            ao.play(data, qreal(frames)/qreal(af.sampleRate()));
+        }
+        m_elapsed = timer.elapsed();
+        m_played = qint64(ao.timestamp()*1000.0);
+        ao.close();
+        m_ok = true;
+    }
+private:
+    QString m_backend;
+    int m_index;
+    qint64 m_msecs;
+    qint64 m_played, m_elapsed;
+    bool m_ok;
+};
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QString backend = QString::fromLatin1("MixerNull");
+    int idx = app.arguments().indexOf(QLatin1String("-ao"));
+    if (idx > 0)
+        backend = app.arguments().at(idx+1);
+    int count = 8;
+    idx = app.arguments().indexOf(QLatin1String("-n"));
+    if (idx > 0)
+        count = qMax(1, app.arguments().at(idx+1).toInt());
+    qint64 msecs = 3000;
+    idx = app.arguments().indexOf(QLatin1String("-t"));
+    if (idx > 0)
+        msecs = qMax(100, app.arguments().at(idx+1).toInt());
+    if (!AudioOutput::backendsAvailable().contains(backend)) {
+        qWarning() << "unknow backend " << backend;
+        return -1;
+    }
+    QList<Feeder*> feeders;
+    for (int i = 0; i < count; ++i) {
+        feeders.append(new Feeder(backend, i, msecs));
+        feeders.last()->start();
+    }
+    int ret = 0;
+    for (int i = 0; i < feeders.size(); ++i) {
+        Feeder *f = feeders.at(i);
+        f->wait();
+        // played time should follow wall time, i.e. outputs are paced by the mixer
+        qDebug("output %d: played %lldms in %lldms", i, f->playedMSecs(), f->elapsedMSecs());
+        if (!f->ok() || qAbs(f->playedMSecs() - f->elapsedMSecs()) > 500)
+            ret = 1;
+        delete f;
+    }
+    // all outputs are closed and the mixer is idle but still running. a new output must be mixed again
+    Feeder f(backend, count, msecs/2);
+    f.start();
+    f.wait();
+    qDebug("reopened output: played %lldms in %lldms", f.playedMSecs(), f.elapsedMSecs());
+    if (!f.ok() || qAbs(f.playedMSecs() - f.elapsedMSecs()) > 500)
+        ret = 1;
+    return ret;
+}
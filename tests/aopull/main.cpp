@@ -0,0 +1,101 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+/*
+ * Seek an AudioOutput with a Pull backend, i.e. clear() then queue new data, and check that a whole ring of new data is
+ * accepted without waiting, both while playing and while paused.
+ * usage: aopull [-ao NullPull|PortAudio]
+ * NullPull needs no audio device.
+ */
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStringList>
+#include <QtAV/AudioOutput.h>
+#include <QtDebug>
+
+using namespace QtAV;
+const int kFrames = 512;
+
+// queue data until the ring is full. return queued bytes
+static int fill(AudioOutput &ao, const QByteArray& data, qreal pts)
+{
+    int bytes = 0;
+    for (int i = 0; i < ao.bufferCount(); ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!ao.play(data, pts + qreal(i*kFrames)/qreal(ao.audioFormat().sampleRate())))
+            break;
+        if (timer.elapsed() > 100) // waited for the backend to read
+            break;
+        bytes += data.size();
+    }
+    return bytes;
+}
+
+static bool seek(AudioOutput &ao, const QByteArray& data, bool paused)
+{
+    ao.pause(false);
+    fill(ao, data, 0);
+    ao.pause(paused);
+    ao.clear();
+    const qreal pts = 10.0;
+    const int queued = fill(ao, data, pts);
+    qDebug("seek %s: queued %d/%d bytes, timestamp %f", paused ? "paused" : "playing", queued, ao.bufferSizeTotal(), ao.timestamp());
+    if (queued != ao.bufferSizeTotal())
+        return false;
+    // nothing is read while paused, so the next sample is the first queued one
+    if (paused && !qFuzzyCompare(ao.timestamp(), pts))
+        return false;
+    return ao.timestamp() >= pts;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QString backend = QString::fromLatin1("NullPull");
+    const int idx = app.arguments().indexOf(QLatin1String("-ao"));
+    if (idx > 0)
+        backend = app.arguments().at(idx+1);
+    AudioOutput ao;
+    ao.setBackends(QStringList() << backend);
+    if (ao.backend() != backend) {
+        qWarning() << "unknow backend " << backend;
+        return -1;
+    }
+    AudioFormat af;
+    af.setChannels(2);
+    af.setSampleFormat(AudioFormat::SampleFormat_Signed16);
+    af.setSampleRate(44100);
+    ao.setAudioFormat(af);
+    ao.setBufferSamples(kFrames);
+    if (!ao.open()) {
+        qWarning("open audio error");
+        return -1;
+    }
+    const QByteArray data(af.bytesPerFrame()*kFrames, 0);
+    int ret = 0;
+    if (!seek(ao, data, false))
+        ret = 1;
+    if (!seek(ao, data, true))
+        ret = 1;
+    ao.pause(false);
+    ao.close();
+    return ret;
+}
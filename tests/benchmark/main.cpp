@@ -0,0 +1,423 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+/*
+ * Headless throughput benchmark. No clock and no window is used, every stage runs as fast as possible.
+ * Clips are generated by libavfilter sources (lavfi testsrc and sine), so results are reproducible.
+ * Usage: benchmark [-s WxH] [-t seconds] [-c:v encoder] [-i video_file] [-o result.json]
+ * Display conversion is usually compared with -s 1920x1080 and -s 3840x2160.
+ */
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+#include <QtAV/AVDemuxer.h>
+#include <QtAV/AVMuxer.h>
+#include <QtAV/AudioDecoder.h>
+#include <QtAV/AudioOutput.h>
+#include <QtAV/AudioResampler.h>
+#include <QtAV/VideoDecoder.h>
+#include <QtAV/VideoEncoder.h>
+#include <QtAV/Packet.h>
+#include <QtAV/version.h>
+#include <QtAV/private/FusedConvert.h>
+#include <QtGui/QMatrix4x4>
+#include <QtDebug>
+
+using namespace QtAV;
+
+static const int kFramesToConvert = 30;
+static const int kConvertRounds = 10;
+
+// escape a string value of json
+static QString jsonEscape(const QString& value)
+{
+    QString s;
+    s.reserve(value.size());
+    foreach (const QChar& c, value) {
+        switch (c.unicode()) {
+        case '"': s += QLatin1String("\\\""); break;
+        case '\\': s += QLatin1String("\\\\"); break;
+        case '\n': s += QLatin1String("\\n"); break;
+        case '\r': s += QLatin1String("\\r"); break;
+        case '\t': s += QLatin1String("\\t"); break;
+        default:
+            if (c.unicode() < 0x20)
+                s += QString::fromLatin1("\\u%1").arg(c.unicode(), 4, 16, QLatin1Char('0'));
+            else
+                s += c;
+            break;
+        }
+    }
+    return s;
+}
+
+class Report
+{
+public:
+    void add(const QString& name, const QString& params, qint64 count, qint64 elapsed_ns, const QString& unit, qint64 bytes = 0) {
+        const qreal s = qMax<qreal>(1e-9, qreal(elapsed_ns)/1e9);
+        QString r = QString::fromLatin1("    {\"name\": \"%1\", \"params\": \"%2\", \"count\": %3, \"elapsed_ms\": %4, \"rate\": %5, \"unit\": \"%6\"")
+                .arg(jsonEscape(name)).arg(jsonEscape(params)).arg(count).arg(qreal(elapsed_ns)/1e6, 0, 'f', 3).arg(qreal(count)/s, 0, 'f', 2).arg(jsonEscape(unit));
+        if (bytes > 0)
+            r += QString::fromLatin1(", \"mbytes_per_sec\": %1").arg(qreal(bytes)/s/1e6, 0, 'f', 2);
+        r += QLatin1Char('}');
+        m_results.append(r);
+        printf("%-24s %-28s %10.2f %s/s\n", name.toUtf8().constData(), params.toUtf8().constData(), qreal(count)/s, unit.toUtf8().constData());
+        fflush(0);
+    }
+    QByteArray json(const QString& clip) const {
+        QString s = QString::fromLatin1("{\n  \"version\": \"%1\",\n  \"clip\": \"%2\",\n  \"results\": [\n")
+                .arg(QString::fromLatin1(QTAV_VERSION_STR)).arg(jsonEscape(clip));
+        s += m_results.join(QString::fromLatin1(",\n"));
+        s += QString::fromLatin1("\n  ]\n}\n");
+        return s.toUtf8();
+    }
+private:
+    QStringList m_results;
+};
+
+static QString argValue(const QStringList& args, const char* name, const QString& defaultValue = QString())
+{
+    const int idx = args.indexOf(QLatin1String(name));
+    if (idx < 0 || idx + 1 >= args.size())
+        return defaultValue;
+    return args.at(idx + 1);
+}
+
+// encode lavfi testsrc to a file so that decoding is not trivial as rawvideo
+static bool generateVideo(const QString& file, const QSize& size, int seconds, const QString& codec)
+{
+    if (QFile::exists(file))
+        return true;
+    AVDemuxer demux;
+    demux.setFormat(QString::fromLatin1("lavfi"));
+    demux.setMedia(QString::fromLatin1("testsrc=size=%1x%2:rate=25:duration=%3").arg(size.width()).arg(size.height()).arg(seconds));
+    if (!demux.load()) {
+        qWarning("failed to load lavfi testsrc");
+        return false;
+    }
+    VideoDecoder *dec = VideoDecoder::create("FFmpeg");
+    dec->setCodecContext(demux.videoCodecContext());
+    if (!dec->open()) {
+        delete dec;
+        return false;
+    }
+    VideoEncoder *enc = VideoEncoder::create("FFmpeg");
+    enc->setCodecName(codec);
+    enc->setBitRate(size.width()*size.height()*4);
+    enc->setFrameRate(25);
+    enc->setWidth(size.width());
+    enc->setHeight(size.height());
+    AVMuxer mux;
+    mux.setMedia(file);
+    bool ok = enc->open();
+    if (ok) {
+        mux.copyProperties(enc);
+        ok = mux.open();
+    }
+    while (ok && !demux.atEnd()) {
+        if (!demux.readFrame() || demux.stream() != demux.videoStream())
+            continue;
+        if (!dec->decode(demux.packet()))
+            continue;
+        VideoFrame frame(dec->frame());
+        if (!frame)
+            continue;
+        if (frame.pixelFormat() != enc->pixelFormat())
+            frame = frame.to(enc->pixelFormat());
+        if (enc->encode(frame))
+            mux.writeVideo(enc->encoded());
+    }
+    while (ok && enc->encode())
+        mux.writeVideo(enc->encoded());
+    enc->close();
+    mux.close();
+    delete enc;
+    delete dec;
+    if (!ok)
+        QFile::remove(file);
+    return ok;
+}
+
+static QList<Packet> readPackets(AVDemuxer *demux, int stream)
+{
+    QList<Packet> packets;
+    while (!demux->atEnd()) {
+        if (!demux->readFrame() || demux->stream() != stream)
+            continue;
+        packets.append(demux->packet());
+    }
+    return packets;
+}
+
+static void benchDemux(Report *r, const QString& file)
+{
+    AVDemuxer demux;
+    demux.setMedia(file);
+    if (!demux.load())
+        return;
+    qint64 count = 0, bytes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    while (!demux.atEnd()) {
+        if (!demux.readFrame())
+            continue;
+        ++count;
+        bytes += demux.packet().data.size();
+    }
+    r->add(QString::fromLatin1("AVDemuxer::readFrame"), QString(), count, timer.nsecsElapsed(), QString::fromLatin1("packets"), bytes);
+}
+
+static QList<VideoFrame> benchVideoDecoder(Report *r, const QString& file, const QList<int>& threadsList)
+{
+    QList<VideoFrame> kept;
+    AVDemuxer demux;
+    demux.setMedia(file);
+    if (!demux.load())
+        return kept;
+    const QList<Packet> packets(readPackets(&demux, demux.videoStream()));
+    foreach (int threads, threadsList) {
+        VideoDecoder *dec = VideoDecoder::create("FFmpeg");
+        dec->setProperty("threads", threads);
+        dec->setCodecContext(demux.videoCodecContext());
+        if (!dec->open()) {
+            delete dec;
+            continue;
+        }
+        qint64 count = 0;
+        qint64 copy_ns = 0; // frames kept for conversion benchmarks are not counted
+        QElapsedTimer timer;
+        timer.start();
+        foreach (const Packet& pkt, packets) {
+            if (!dec->decode(pkt))
+                continue;
+            VideoFrame frame(dec->frame());
+            if (!frame)
+                continue;
+            ++count;
+            if (kept.size() < kFramesToConvert) {
+                QElapsedTimer copy_timer;
+                copy_timer.start();
+                kept.append(frame.clone());
+                copy_ns += copy_timer.nsecsElapsed();
+            }
+        }
+        while (dec->decode(Packet::createEOF())) {
+            if (dec->frame())
+                ++count;
+        }
+        r->add(QString::fromLatin1("VideoDecoderFFmpeg"), QString::fromLatin1("threads=%1").arg(threads), count, timer.nsecsElapsed() - copy_ns, QString::fromLatin1("frames"));
+        dec->close();
+        delete dec;
+    }
+    return kept;
+}
+
+static void benchVideoConvert(Report *r, const QList<VideoFrame>& frames)
+{
+    if (frames.isEmpty())
+        return;
+    const QSize size(frames.first().size());
+    // VideoFrameConverter wraps ImageConverterFF and reuses the converter and output buffer
+    const VideoFormat::PixelFormat formats[] = { VideoFormat::Format_RGB32, VideoFormat::Format_YUV420P, VideoFormat::Format_NV12 };
+    for (size_t i = 0; i < sizeof(formats)/sizeof(formats[0]); ++i) {
+        VideoFrameConverter conv;
+        qint64 count = 0;
+        QElapsedTimer timer;
+        timer.start();
+        for (int n = 0; n < kConvertRounds; ++n) {
+            foreach (const VideoFrame& f, frames) {
+                if (conv.convert(f, formats[i]).isValid())
+                    ++count;
+            }
+        }
+        r->add(QString::fromLatin1("ImageConverterFF"), QString::fromLatin1("%1=>%2")
+               .arg(frames.first().format().name()).arg(VideoFormat(formats[i]).name())
+               , count, timer.nsecsElapsed(), QString::fromLatin1("frames"));
+    }
+    const QSize sizes[] = { size, size/2 };
+    for (size_t i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++i) {
+        qint64 count = 0;
+        QElapsedTimer timer;
+        timer.start();
+        for (int n = 0; n < kConvertRounds; ++n) {
+            foreach (const VideoFrame& f, frames) {
+                if (f.to(VideoFormat::Format_RGB32, sizes[i]).isValid())
+                    ++count;
+            }
+        }
+        r->add(QString::fromLatin1("VideoFrame::to"), QString::fromLatin1("RGB32 %1x%2").arg(sizes[i].width()).arg(sizes[i].height())
+               , count, timer.nsecsElapsed(), QString::fromLatin1("frames"));
+    }
+}
+
+/*
+ * Display path of QPainterRenderer in prescale mode, from a decoded yuv frame to an rgb image of display size with eq.
+ * chain: convert to RGB32 with swscale eq in VideoThread, then scale in the renderer. fused: fusedConvertRGB32()
+ */
+static void benchDisplayConvert(Report *r, const QList<VideoFrame>& frames)
+{
+    if (frames.isEmpty() || !canFusedConvert(frames.first().format()))
+        return;
+    const QSize size(frames.first().size());
+    // bt.601 limited range yuv to rgb, then brightness +0.1
+    const QMatrix4x4 m(1.164384f, 0.000000f, 1.596027f, -0.874202f + 0.1f,
+                       1.164384f, -0.391762f, -0.812968f, 0.531668f + 0.1f,
+                       1.164384f, 2.017232f, 0.000000f, -1.085631f + 0.1f,
+                       0.0f, 0.0f, 0.0f, 1.0f);
+    const QSize sizes[] = { size, size*2/3 };
+    for (size_t i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++i) {
+        const QString params(QString::fromLatin1("%1=>RGB32 %2x%3").arg(frames.first().format().name()).arg(sizes[i].width()).arg(sizes[i].height()));
+        VideoFrameConverter conv, scaler;
+        conv.setEq(10, 0, 0);
+        qint64 count = 0;
+        QElapsedTimer timer;
+        timer.start();
+        for (int n = 0; n < kConvertRounds; ++n) {
+            foreach (const VideoFrame& f, frames) {
+                const VideoFrame rgb(conv.convert(f, VideoFormat::Format_RGB32));
+                if (sizes[i] == size ? rgb.isValid() : scaler.convert(rgb, VideoFormat::Format_RGB32, sizes[i]).isValid())
+                    ++count;
+            }
+        }
+        r->add(QString::fromLatin1("DisplayChain"), params, count, timer.nsecsElapsed(), QString::fromLatin1("frames"));
+        QImage img(sizes[i], QImage::Format_RGB32);
+        count = 0;
+        timer.restart();
+        for (int n = 0; n < kConvertRounds; ++n) {
+            foreach (const VideoFrame& f, frames) {
+                if (fusedConvertRGB32(f, m, img.bits(), img.bytesPerLine(), sizes[i]))
+                    ++count;
+            }
+        }
+        r->add(QString::fromLatin1("FusedConvert"), params, count, timer.nsecsElapsed(), QString::fromLatin1("frames"));
+    }
+}
+
+static QList<AudioFrame> decodeAudio(int seconds)
+{
+    QList<AudioFrame> frames;
+    AVDemuxer demux;
+    demux.setFormat(QString::fromLatin1("lavfi"));
+    demux.setMedia(QString::fromLatin1("sine=frequency=440:sample_rate=44100:duration=%1").arg(seconds));
+    if (!demux.load()) {
+        qWarning("failed to load lavfi sine");
+        return frames;
+    }
+    AudioDecoder *dec = AudioDecoder::create("FFmpeg");
+    dec->setCodecContext(demux.audioCodecContext());
+    if (dec->open()) {
+        foreach (const Packet& pkt, readPackets(&demux, demux.audioStream())) {
+            if (!dec->decode(pkt))
+                continue;
+            AudioFrame f(dec->frame());
+            if (f)
+                frames.append(f.clone());
+        }
+    }
+    delete dec;
+    return frames;
+}
+
+static void benchAudio(Report *r, const QList<AudioFrame>& frames)
+{
+    if (frames.isEmpty())
+        return;
+    AudioFormat out;
+    out.setSampleFormat(AudioFormat::SampleFormat_Float);
+    out.setChannels(2);
+    out.setSampleRate(48000);
+    AudioResampler *conv = AudioResampler::create(AudioResamplerId_FF);
+    if (conv) {
+        conv->setInAudioFormat(frames.first().format());
+        conv->setOutAudioFormat(out);
+        qint64 samples = 0;
+        QElapsedTimer timer;
+        timer.start();
+        foreach (const AudioFrame& f, frames) {
+            QVector<const quint8*> planes(f.planeCount());
+            for (int i = 0; i < planes.size(); ++i)
+                planes[i] = f.constBits(i);
+            conv->setInSampesPerChannel(f.samplesPerChannel());
+            if (conv->convert(planes.data()))
+                samples += f.samplesPerChannel();
+        }
+        r->add(QString::fromLatin1("AudioResamplerFF"), QString::fromLatin1("44100 mono s16=>48000 stereo flt"), samples, timer.nsecsElapsed(), QString::fromLatin1("samples"));
+        delete conv;
+    }
+    AudioOutput ao;
+    ao.setBackends(QStringList() << QString::fromLatin1("null"));
+    ao.setAudioFormat(frames.first().format());
+    if (!ao.open()) {
+        qWarning("failed to open null audio output");
+        return;
+    }
+    qint64 samples = 0;
+    QElapsedTimer timer;
+    timer.start();
+    foreach (AudioFrame f, frames) {
+        if (ao.play(f.data(), f.timestamp()))
+            samples += f.samplesPerChannel();
+    }
+    r->add(QString::fromLatin1("AudioOutput"), QString::fromLatin1("null"), samples, timer.nsecsElapsed(), QString::fromLatin1("samples"));
+    ao.close();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    const QStringList args(a.arguments());
+    const QStringList wh(argValue(args, "-s", QString::fromLatin1("1280x720")).split(QLatin1Char('x')));
+    const QSize size(wh.first().toInt(), wh.last().toInt());
+    const int seconds = argValue(args, "-t", QString::fromLatin1("10")).toInt();
+    const QString codec = argValue(args, "-c:v", QString::fromLatin1("mpeg4"));
+    QString file = argValue(args, "-i");
+    if (file.isEmpty()) {
+        file = QDir::temp().filePath(QString::fromLatin1("qtav_benchmark_%1_%2x%3_%4s.mkv").arg(codec).arg(size.width()).arg(size.height()).arg(seconds));
+        if (!generateVideo(file, size, seconds, codec)) {
+            qWarning("failed to generate test clip");
+            return 1;
+        }
+    }
+    Report r;
+    benchDemux(&r, file);
+    const QList<VideoFrame> frames(benchVideoDecoder(&r, file, QList<int>() << 1 << 2 << 4 << 0));
+    benchVideoConvert(&r, frames);
+    benchDisplayConvert(&r, frames);
+    benchAudio(&r, decodeAudio(seconds));
+
+    const QByteArray json(r.json(file));
+    const QString out = argValue(args, "-o");
+    if (out.isEmpty()) {
+        printf("%s", json.constData());
+        return 0;
+    }
+    QFile f(out);
+    if (!f.open(QIODevice::WriteOnly)) {
+        qWarning("failed to open %s", out.toUtf8().constData());
+        return 1;
+    }
+    f.write(json);
+    return 0;
+}
@@ -0,0 +1,8 @@
+TARGET = blendass
+CONFIG -= app_bundle
+
+PROJECTROOT = $$PWD/../..
+include($$PROJECTROOT/src/libQtAV.pri)
+preparePaths($$OUT_PWD/../../out)
+
+SOURCES += main.cpp
@@ -0,0 +1,337 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+/*
+ * Validate and benchmark ASS subtitle blend kernels. Every kernel is compared with the C kernel on the same canvas, and each
+ * blend is compared with the scalar loop used before the kernels, which may differ by 1 per channel.
+ * Colors are libass 0xRRGGBBAA and converted as RenderASS() does.
+ * Usage:
+ *   blendass [-n loops] [-s WxH]                           synthetic glyph like images
+ *   blendass -f subtitle.ass -t seconds -o images.subs      record images of a subtitle file
+ *   blendass -i images.subs [-n loops]                      replay recorded images
+ */
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDataStream>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+#include <QtGui/qrgb.h>
+#include <QtAV/Subtitle.h>
+#include <QtAV/private/SubImageBlend.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace QtAV;
+
+static const quint32 kMagic = 0x53554249; //"SUBI"
+
+static void writeSet(QDataStream &s, const SubImageSet &set)
+{
+    s << qint32(set.width()) << qint32(set.height()) << qint32(set.images.size());
+    foreach (const SubImage &i, set.images)
+        s << qint32(i.x) << qint32(i.y) << qint32(i.w) << qint32(i.h) << qint32(i.stride) << i.color << i.data;
+}
+
+static bool readSet(QDataStream &s, SubImageSet *set)
+{
+    qint32 w, h, n;
+    s >> w >> h >> n;
+    if (s.status() != QDataStream::Ok || w <= 0 || h <= 0 || n < 0)
+        return false;
+    set->reset(w, h, SubImageSet::ASS);
+    for (int k = 0; k < n; ++k) {
+        qint32 x, y, iw, ih, stride;
+        SubImage i;
+        s >> x >> y >> iw >> ih >> stride >> i.color >> i.data;
+        if (s.status() != QDataStream::Ok || x < 0 || y < 0 || x + iw > w || y + ih > h || i.data.size() < stride*ih)
+            return false;
+        i.x = x; i.y = y; i.w = iw; i.h = ih; i.stride = stride;
+        set->images.append(i);
+    }
+    return true;
+}
+
+static int record(const QString &file, qreal duration, int w, int h, const QString &out)
+{
+    Subtitle sub;
+    sub.setEngines(QStringList() << QString::fromLatin1("LibASS"));
+    sub.setFileName(file);
+    sub.load();
+    if (!sub.isLoaded() || !sub.canRender()) {
+        fprintf(stderr, "failed to load %s with libass\n", file.toUtf8().constData());
+        return 1;
+    }
+    QFile f(out);
+    if (!f.open(QIODevice::WriteOnly)) {
+        fprintf(stderr, "failed to open %s\n", out.toUtf8().constData());
+        return 1;
+    }
+    QDataStream s(&f);
+    s << kMagic;
+    int frames = 0;
+    for (qreal t = 0; t < duration; t += 1.0/25.0) { // 25fps
+        sub.setTimestamp(t);
+        const SubImageSet set(sub.getSubImages(w, h));
+        if (set.images.isEmpty())
+            continue;
+        writeSet(s, set);
+        ++frames;
+    }
+    printf("recorded %d frames\n", frames);
+    return 0;
+}
+
+static QVector<SubImageSet> load(const QString &file)
+{
+    QVector<SubImageSet> sets;
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly))
+        return sets;
+    QDataStream s(&f);
+    quint32 magic = 0;
+    s >> magic;
+    if (magic != kMagic)
+        return sets;
+    while (!s.atEnd()) {
+        SubImageSet set;
+        if (!readSet(s, &set))
+            break;
+        sets.append(set);
+    }
+    return sets;
+}
+
+// text lines of random coverage strokes and an outline/shadow layer, similar to libass output
+static QVector<SubImageSet> synthetic(int w, int h)
+{
+    QVector<SubImageSet> sets;
+    srand(1);
+    for (int n = 0; n < 50; ++n) {
+        SubImageSet set(w, h, SubImageSet::ASS);
+        // libass colors 0xRRGGBBAA, AA is transparency: opaque black, half transparent black, opaque white
+        const quint32 colors[] = { 0x000000ff, 0x0000007f, 0xffffff00 };
+        for (int line = 0; line < 2; ++line) {
+            const int lw = w*(6 + rand()%3)/10;
+            const int lh = h/12;
+            for (int layer = 0; layer < 3; ++layer) {
+                SubImage i(w/2 - lw/2 + layer, h - (2 - line)*lh*3/2 - 8 + layer, lw, lh, (lw + 31) & ~31);
+                i.color = colors[layer];
+                i.data.fill(0, i.stride*i.h);
+                quint8 *d = (quint8*)i.data.data();
+                for (int x = 0; x < lw; x += 4 + rand()%8) { // vertical strokes with anti aliased edges
+                    const int sw = 1 + rand()%4;
+                    for (int y = lh/6 + rand()%(lh/6 + 1); y < lh - lh/6; ++y) {
+                        for (int k = 0; k < sw && x + k < lw; ++k)
+                            d[y*i.stride + x + k] = (k == 0 || k == sw - 1) ? quint8(64 + rand()%128) : 255;
+                    }
+                }
+                set.images.append(i);
+            }
+        }
+        sets.append(set);
+    }
+    return sets;
+}
+
+// libass 0xRRGGBBAA color to the BlendASSFunc color 0xAARRGGBB, as RenderASS() does
+static quint32 blendColor(quint32 c)
+{
+    return qRgba(c >> 24, (c >> 16) & 0xff, (c >> 8) & 0xff, 255 - (c & 0xff));
+}
+
+static void blend(BlendASSFunc f, quint32 *canvas, int width, const SubImage &i)
+{
+    const quint32 color = blendColor(i.color);
+    if (!(color >> 24))
+        return;
+    f(canvas + i.y*width + i.x, width*sizeof(quint32), (const quint8*)i.data.constData(), i.stride, i.w, i.h, color);
+}
+
+static void blend(BlendASSFunc f, QVector<quint32> *canvas, const SubImageSet &set)
+{
+    foreach (const SubImage &i, set.images)
+        blend(f, canvas->data(), set.width(), i);
+}
+
+// the scalar loop of RenderASS() before the blend kernels were added
+static void blendOld(quint32 *dst, int dstStride, const quint8 *src, int srcStride, int w, int h, quint32 color)
+{
+    const unsigned a = qAlpha(color), r = qRed(color), g = qGreen(color), b = qBlue(color);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const unsigned k = ((unsigned) src[x])*a/255;
+            const unsigned A = qAlpha(dst[x]);
+            if (A == 0 || k == 255) {
+                dst[x] = qRgba(r, g, b, k);
+            } else if (k != 0) {
+                const unsigned R = qRed(dst[x]), G = qGreen(dst[x]), B = qBlue(dst[x]);
+                // unsigned wrap around and byte wise addition as the old code
+                dst[x] = qRgba((R + (r == R ? 0 : k*(r-R)/255)) & 0xff, (G + (g == G ? 0 : k*(g-G)/255)) & 0xff
+                               , (B + (b == B ? 0 : k*(b-B)/255)) & 0xff, (A + (a == A ? 0 : k*(a-A)/255)) & 0xff);
+            }
+        }
+        src += srcStride;
+        dst = (quint32*)((quint8*)dst + dstStride);
+    }
+}
+
+/*
+ * max channel difference of f and the old loop for each image blended into the same canvas. Transparent pixels are equal
+ * whatever the rgb is. The old loop wraps a channel 255 to 0 if the color is 254 and the blend factor is small, those
+ * channels are counted in \a overflows instead.
+ */
+static int maxDiffToOld(BlendASSFunc f, const QVector<SubImageSet> &sets, quint32 background, int *overflows)
+{
+    int diff = 0;
+    QVector<quint32> canvas(sets.first().width()*sets.first().height(), background);
+    foreach (const SubImageSet &set, sets) {
+        foreach (const SubImage &i, set.images) {
+            const quint32 color = blendColor(i.color);
+            if (!(color >> 24))
+                continue;
+            QVector<quint32> before(i.w*i.h);
+            for (int y = 0; y < i.h; ++y)
+                memcpy(before.data() + y*i.w, canvas.constData() + (i.y + y)*set.width() + i.x, i.w*sizeof(quint32));
+            QVector<quint32> old(before);
+            blendOld(old.data(), i.w*sizeof(quint32), (const quint8*)i.data.constData(), i.stride, i.w, i.h, color);
+            blend(f, canvas.data(), set.width(), i);
+            for (int y = 0; y < i.h; ++y) {
+                const quint32 *c = canvas.constData() + (i.y + y)*set.width() + i.x;
+                const quint32 *o = old.constData() + y*i.w;
+                const quint32 *b = before.constData() + y*i.w;
+                for (int x = 0; x < i.w; ++x) {
+                    if (!qAlpha(c[x]) && !qAlpha(o[x]))
+                        continue;
+                    for (int s = 0; s < 32; s += 8) {
+                        const int cc = (c[x] >> s) & 0xff, oc = (o[x] >> s) & 0xff;
+                        if (oc == 0 && ((b[x] >> s) & 0xff) == 255 && cc >= 254) {
+                            ++*overflows;
+                            continue;
+                        }
+                        diff = qMax(diff, qAbs(cc - oc));
+                    }
+                }
+            }
+        }
+    }
+    return diff;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QString in, out, file;
+    qreal duration = 60;
+    int loops = 20;
+    int w = 1920, h = 1080;
+    const QStringList args(a.arguments());
+    for (int i = 1; i < args.size() - 1; ++i) {
+        if (args.at(i) == QLatin1String("-i"))
+            in = args.at(++i);
+        else if (args.at(i) == QLatin1String("-o"))
+            out = args.at(++i);
+        else if (args.at(i) == QLatin1String("-f"))
+            file = args.at(++i);
+        else if (args.at(i) == QLatin1String("-t"))
+            duration = args.at(++i).toDouble();
+        else if (args.at(i) == QLatin1String("-n"))
+            loops = qMax(1, args.at(++i).toInt());
+        else if (args.at(i) == QLatin1String("-s")) {
+            const QStringList s(args.at(++i).split(QLatin1Char('x')));
+            if (s.size() == 2) {
+                w = s.at(0).toInt();
+                h = s.at(1).toInt();
+            }
+        }
+    }
+    if (!file.isEmpty())
+        return record(file, duration, w, h, out.isEmpty() ? QString::fromLatin1("subimages.subs") : out);
+
+    const QVector<SubImageSet> sets(in.isEmpty() ? synthetic(w, h) : load(in));
+    if (sets.isEmpty()) {
+        fprintf(stderr, "no sub images\n");
+        return 1;
+    }
+    qint64 pixels = 0;
+    foreach (const SubImageSet &set, sets) {
+        foreach (const SubImage &i, set.images)
+            pixels += i.w*i.h;
+    }
+    printf("%d frames, %lld pixels per loop\n", sets.size(), (long long)pixels);
+
+    struct {
+        BlendASSKernel kernel;
+        const char* name;
+    } kernels[] = {
+        { BlendASS_C, "C" },
+        { BlendASS_SSE2, "SSE2" },
+        { BlendASS_AVX2, "AVX2" },
+        { BlendASS_NEON, "NEON" }
+    };
+    // transparent canvas and a gray one. blend all frames in one canvas to cover partially covered dst pixels
+    const quint32 backgrounds[] = { 0, 0xff808080 };
+    QVector<QVector<quint32> > refs;
+    for (size_t b = 0; b < sizeof(backgrounds)/sizeof(backgrounds[0]); ++b) {
+        QVector<quint32> ref(sets.first().width()*sets.first().height(), backgrounds[b]);
+        foreach (const SubImageSet &set, sets)
+            blend(blendASSFunc(BlendASS_C), &ref, set);
+        refs.append(ref);
+    }
+    int ret = 0;
+    double c_time = 0;
+    for (size_t k = 0; k < sizeof(kernels)/sizeof(kernels[0]); ++k) {
+        BlendASSFunc f = blendASSFunc(kernels[k].kernel);
+        if (!f) {
+            printf("%-5s: not available\n", kernels[k].name);
+            continue;
+        }
+        int mismatch = 0;
+        int old_diff = 0;
+        int old_overflows = 0;
+        for (int b = 0; b < refs.size(); ++b) {
+            QVector<quint32> canvas(refs[b].size(), backgrounds[b]);
+            foreach (const SubImageSet &set, sets)
+                blend(f, &canvas, set);
+            for (int i = 0; i < canvas.size(); ++i) {
+                if (canvas[i] != refs[b][i])
+                    ++mismatch;
+            }
+            old_diff = qMax(old_diff, maxDiffToOld(f, sets, backgrounds[b], &old_overflows));
+        }
+        QVector<quint32> canvas(refs[0].size(), 0);
+        QElapsedTimer timer;
+        timer.start();
+        for (int n = 0; n < loops; ++n) {
+            foreach (const SubImageSet &set, sets)
+                blend(f, &canvas, set);
+        }
+        const double t = double(timer.nsecsElapsed())/1e9;
+        if (kernels[k].kernel == BlendASS_C)
+            c_time = t;
+        printf("%-5s: %8.2f Mpixel/s, speedup %.2fx, mismatched pixels: %d, max difference to the old loop: %d (%d old overflows)\n"
+               , kernels[k].name, double(pixels)*double(loops)/t/1e6, t > 0 ? c_time/t : 0.0, mismatch, old_diff, old_overflows);
+        if (mismatch || old_diff > 1)
+            ret = 1;
+    }
+    return ret;
+}
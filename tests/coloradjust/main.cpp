@@ -0,0 +1,128 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+/*
+ * Validate colorAdjust() for planar yuv. Every pixel is compared with the scalar formula of the row kernels, so the SSE2
+ * rows and the scalar tails are both checked. Widths are not multiples of the SIMD widths. The in place result must be
+ * the same as the result in another frame.
+ * SIMD rounds halves to even, the scalar code rounds them away from zero, so a difference of 1 is allowed.
+ */
+#include <QtCore/QCoreApplication>
+#include <QtAV/VideoFrame.h>
+#include "utils/ColorAdjust.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace QtAV;
+
+static int component(const VideoFrame &f, int plane, int x, int y)
+{
+    const uchar *p = f.constBits(plane) + y*f.bytesPerLine(plane);
+    if (f.format().bytesPerPixel(plane) == 1)
+        return p[x];
+    return ((const quint16*)p)[x];
+}
+
+// max difference of \a dst and the expected result of \a src
+static int check(const VideoFrame &src, const VideoFrame &dst, const QMatrix4x4 &m)
+{
+    const VideoFormat fmt(src.format());
+    const int maxv = (1 << fmt.bitsPerComponent()) - 1;
+    const int w = src.width(), h = src.height();
+    const int cw = fmt.width(w, 1), ch = fmt.height(h, 1);
+    int diff = 0;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const float u = component(src, 1, x*cw/w, y*ch/h), v = component(src, 2, x*cw/w, y*ch/h);
+            const float t = float(m(0, 1))*u + float(m(0, 2))*v + float(m(0, 3))*float(maxv);
+            const int e = qBound(0, qRound(float(m(0, 0))*float(component(src, 0, x, y)) + t), maxv);
+            diff = qMax(diff, qAbs(e - component(dst, 0, x, y)));
+        }
+    }
+    for (int y = 0; y < ch; ++y) {
+        for (int x = 0; x < cw; ++x) {
+            const float u = component(src, 1, x, y), v = component(src, 2, x, y);
+            for (int p = 1; p < 3; ++p) {
+                const float e = float(m(p, 1))*u + float(m(p, 2))*v + float(m(p, 3))*float(maxv);
+                diff = qMax(diff, qAbs(qBound(0, qRound(e), maxv) - component(dst, p, x, y)));
+            }
+        }
+    }
+    return diff;
+}
+
+static bool test(VideoFormat::PixelFormat pixfmt, int w, int h, const QMatrix4x4 &m)
+{
+    const VideoFormat fmt(pixfmt);
+    VideoFrame src(w, h, fmt);
+    VideoFrame dst(w, h, fmt);
+    if (!src.allocate() || !dst.allocate()) {
+        fprintf(stderr, "failed to allocate %s %dx%d\n", fmt.name().toUtf8().constData(), w, h);
+        return false;
+    }
+    const int maxv = (1 << fmt.bitsPerComponent()) - 1;
+    for (int p = 0; p < fmt.planeCount(); ++p) {
+        for (int y = 0; y < fmt.height(h, p); ++y) {
+            uchar *d = src.bits(p) + y*src.bytesPerLine(p);
+            for (int x = 0; x < fmt.width(w, p); ++x) {
+                if (fmt.bytesPerPixel(p) == 1)
+                    d[x] = uchar(rand() & maxv);
+                else
+                    ((quint16*)d)[x] = quint16(rand() & maxv);
+            }
+        }
+    }
+    if (!colorAdjust(src, dst, m)) {
+        fprintf(stderr, "%s is not supported\n", fmt.name().toUtf8().constData());
+        return false;
+    }
+    const int diff = check(src, dst, m);
+    VideoFrame in_place(src.clone());
+    colorAdjust(in_place, in_place, m);
+    int in_place_mismatch = 0;
+    for (int p = 0; p < fmt.planeCount(); ++p) {
+        for (int y = 0; y < fmt.height(h, p); ++y) {
+            if (memcmp(in_place.constBits(p) + y*in_place.bytesPerLine(p), dst.constBits(p) + y*dst.bytesPerLine(p)
+                       , fmt.width(w, p)*fmt.bytesPerPixel(p)))
+                ++in_place_mismatch;
+        }
+    }
+    printf("%-12s %4dx%-4d: max difference %d, in place mismatched rows: %d\n", fmt.name().toUtf8().constData(), w, h, diff, in_place_mismatch);
+    return diff <= 1 && !in_place_mismatch;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    srand(1);
+    // brightness, contrast, saturation and hue like: luma depends on chroma, chroma does not depend on luma. results out of range are clamped
+    const QMatrix4x4 m(1.2f, 0.05f, -0.03f, 0.02f,
+                       0.0f, 0.9f, -0.2f, 0.15f,
+                       0.0f, 0.25f, 0.85f, -0.05f,
+                       0.0f, 0.0f, 0.0f, 1.0f);
+    bool ok = true;
+    ok = test(VideoFormat::Format_YUV420P, 16*7 + 5, 9, m) && ok; // 16 pixel luma rows, 8 pixel chroma rows and tails
+    ok = test(VideoFormat::Format_YUV420P, 13, 5, m) && ok; // scalar only
+    ok = test(VideoFormat::Format_YUV444P, 16*3 + 15, 4, m) && ok;
+    ok = test(VideoFormat::Format_YUV420P10LE, 8*9 + 3, 9, m) && ok; // 8 pixel 16 bit luma rows and tails
+    ok = test(VideoFormat::Format_YUV420P10LE, 7, 3, m) && ok;
+    return ok ? 0 : 1;
+}
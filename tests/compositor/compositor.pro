@@ -0,0 +1,11 @@
+CONFIG -= app_bundle
+CONFIG += console
+TEMPLATE = app
+TARGET = compositor
+QT += gui
+
+PROJECTROOT = $$PWD/../..
+include($$PROJECTROOT/src/libQtAV.pri)
+preparePaths($$OUT_PWD/../../out)
+
+SOURCES += main.cpp
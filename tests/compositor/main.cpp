@@ -0,0 +1,122 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+/*
+ * Headless VideoCompositor benchmark. Renders 1..36 tiles into an offscreen fbo and prints the cost per frame.
+ * Every tile receives a new frame before each render, so the upload cost is included.
+ * Usage: compositor [-s WxH] [-n frames] [-shared]
+ *   -shared: all tiles display the same frame
+ * Software gl: LIBGL_ALWAYS_SOFTWARE=1 compositor -platform offscreen
+ */
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStringList>
+#include <QtGui/QGuiApplication>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLFramebufferObject>
+#include <QtGui/QOpenGLFunctions>
+#include <QtAV/VideoCompositor.h>
+#include <QtDebug>
+
+using namespace QtAV;
+
+static VideoFrame createFrame(int w, int h, int seed)
+{
+    const VideoFormat fmt(VideoFormat::Format_YUV420P);
+    const int pitch[] = { w, w/2, w/2 };
+    const int ph[] = { h, h/2, h/2 };
+    QByteArray buf(w*h + 2*(w/2)*(h/2), 0);
+    uchar *p = (uchar*)buf.data();
+    QVector<uchar*> bits(3, 0);
+    for (int i = 0; i < 3; ++i) {
+        bits[i] = p;
+        for (int y = 0; y < ph[i]; ++y) {
+            for (int x = 0; x < pitch[i]; ++x)
+                p[y*pitch[i] + x] = i ? 128 + seed*8 : (x + y + seed*16) & 0xff;
+        }
+        p += pitch[i]*ph[i];
+    }
+    VideoFrame frame(w, h, fmt, buf);
+    frame.setBits(bits);
+    frame.setBytesPerLine(QVector<int>() << pitch[0] << pitch[1] << pitch[2]);
+    return frame;
+}
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+    QSize frame_size(640, 360);
+    int frames = 100;
+    bool shared = false;
+    const QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        const QString &a = args[i];
+        if (a == QLatin1String("-s") && i+1 < args.size()) {
+            const QStringList wh = args[++i].split(QLatin1Char('x'));
+            if (wh.size() == 2)
+                frame_size = QSize(wh[0].toInt(), wh[1].toInt());
+        } else if (a == QLatin1String("-n") && i+1 < args.size()) {
+            frames = qMax(1, args[++i].toInt());
+        } else if (a == QLatin1String("-shared")) {
+            shared = true;
+        }
+    }
+    QOffscreenSurface surface;
+    surface.create();
+    QOpenGLContext ctx;
+    if (!ctx.create() || !ctx.makeCurrent(&surface)) {
+        qWarning("failed to create opengl context");
+        return 1;
+    }
+    qDebug("GL_RENDERER: %s", (const char*)ctx.functions()->glGetString(GL_RENDERER));
+    const QSize viewport(1920, 1080);
+    QOpenGLFramebufferObject fbo(viewport);
+    fbo.bind();
+    QVector<VideoFrame> pool;
+    for (int i = 0; i < 36; ++i)
+        pool.append(createFrame(frame_size.width(), frame_size.height(), i));
+    printf("%-6s %12s %12s\n", "tiles", "ms/frame", "ms/tile");
+    static const int tile_counts[] = { 1, 4, 9, 16, 25, 36 };
+    for (size_t c = 0; c < sizeof(tile_counts)/sizeof(tile_counts[0]); ++c) {
+        const int n = tile_counts[c];
+        VideoCompositor compositor;
+        for (int i = 0; i < n; ++i)
+            compositor.addTile();
+        compositor.render(viewport); // create gl resources
+        ctx.functions()->glFinish();
+        QElapsedTimer timer;
+        timer.start();
+        for (int f = 0; f < frames; ++f) {
+            for (int i = 0; i < n; ++i) {
+                VideoFrame frame = pool[shared ? 0 : i];
+                frame.setTimestamp(qreal(f)/25.0);
+                compositor.tile(i)->receive(frame);
+            }
+            compositor.render(viewport);
+            ctx.functions()->glFinish();
+        }
+        const qreal ms = qreal(timer.nsecsElapsed())/1e6/qreal(frames);
+        printf("%-6d %12.3f %12.3f\n", n, ms, ms/qreal(n));
+    }
+    fbo.release();
+    ctx.doneCurrent();
+    return 0;
+}
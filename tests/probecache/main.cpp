@@ -0,0 +1,77 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+/*
+ * Measure AVDemuxer::load() time of the same media with and without the probe cache
+ * usage: probecache -f file [-n count]
+ */
+#include <QCoreApplication>
+#include <QtDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStringList>
+#include <QtAV/AVDemuxer.h>
+
+using namespace QtAV;
+
+static qint64 loadTime(AVDemuxer *demux, int count, bool *cached)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; ++i) {
+        if (!demux->load()) {
+            qWarning("Failed to load file: %s", demux->fileName().toUtf8().constData());
+            return -1;
+        }
+        *cached = demux->isProbeCached();
+        demux->unload();
+    }
+    return timer.elapsed();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QString file = QString::fromLatin1("test.avi");
+    int idx = a.arguments().indexOf(QLatin1String("-f"));
+    if (idx > 0)
+        file = a.arguments().at(idx + 1);
+    int count = 10;
+    idx = a.arguments().indexOf(QLatin1String("-n"));
+    if (idx > 0)
+        count = a.arguments().at(idx + 1).toInt();
+    if (count <= 0)
+        count = 1;
+
+    AVDemuxer demux;
+    demux.setMedia(file);
+    bool cached = false;
+    const qint64 t_full = loadTime(&demux, count, &cached);
+    if (t_full < 0)
+        return 1;
+    demux.setProbeCacheEnabled(true);
+    loadTime(&demux, 1, &cached); // fill the cache
+    const qint64 t_cached = loadTime(&demux, count, &cached);
+    if (t_cached < 0)
+        return 1;
+    printf("%s\n", file.toUtf8().constData());
+    printf("full probing:   %.1fms/load\n", (double)t_full/(double)count);
+    printf("probe cache:    %.1fms/load, cache used: %d\n", (double)t_cached/(double)count, cached);
+    return 0;
+}
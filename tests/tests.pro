@@ -2,14 +2,25 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     ao \
+    aomixer \
+    aopull \
+    benchmark \
+    blendass \
+    coloradjust \
     decoder \
+    probecache \
     subtitle \
     transcode
 
+greaterThan(QT_MAJOR_VERSION, 4):greaterThan(QT_MINOR_VERSION, 3):contains(QT_CONFIG, opengl) {
+  SUBDIRS += compositor
+}
+
 !no-widgets {
   SUBDIRS += \
     extract \
     qiodevice \
     qrc \
     playerthread
+  unix:!mac:!android:!ios: SUBDIRS += x11renderer
 }
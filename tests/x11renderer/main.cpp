@@ -0,0 +1,145 @@
+/******************************************************************************
+    QtAV:  Multimedia framework based on Qt and FFmpeg
+    Copyright (C) 2012-2017 Wang Bin <wbsecg1@gmail.com>
+
+*   This file is part of QtAV (from 2017)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+******************************************************************************/
+
+/*
+ * CPU cost of X11 and XVideo renderers. Frames are generated in memory and sent to each renderer at a fixed rate.
+ * Only the cpu time of this process is measured, the X server is not included.
+ * Usage: x11renderer [-vo X11|XV] [-n streams] [-s WxH] [-f pixfmt] [-r fps] [-t seconds]
+ * Headless: xvfb-run -s "-screen 0 1920x1080x24" x11renderer -vo X11 -n 4
+ * Xvfb has no XVideo adaptor, use a real X server for -vo XV
+ */
+#include <QApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+#include <QWidget>
+#include <QtAV/VideoRenderer.h>
+#include <QtAVWidgets>
+#include <QtDebug>
+#include <sys/resource.h>
+
+using namespace QtAV;
+
+static qint64 cpuTimeUs()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return qint64(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec)*1000000LL + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+static VideoFrame createFrame(const VideoFormat& fmt, int w, int h, int seed)
+{
+    QByteArray buf;
+    QVector<uchar*> bits(fmt.planeCount());
+    QVector<int> pitch(fmt.planeCount());
+    int size = 0;
+    for (int i = 0; i < fmt.planeCount(); ++i) {
+        pitch[i] = fmt.bytesPerLine(w, i);
+        size += pitch[i]*fmt.height(h, i);
+    }
+    buf.resize(size);
+    uchar *p = (uchar*)buf.data();
+    for (int i = 0; i < fmt.planeCount(); ++i) {
+        bits[i] = p;
+        const int ph = fmt.height(h, i);
+        for (int y = 0; y < ph; ++y)
+            memset(p + y*pitch[i], i ? 128 : (y + seed*8) & 0xff, pitch[i]);
+        p += pitch[i]*ph;
+    }
+    VideoFrame frame(w, h, fmt, buf);
+    frame.setBits(bits);
+    frame.setBytesPerLine(pitch);
+    return frame;
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    Widgets::registerRenderers();
+    QString vo = QStringLiteral("X11");
+    int streams = 1;
+    QSize size(1280, 720);
+    QString pixfmt = QStringLiteral("yuv420p");
+    int fps = 25;
+    int seconds = 10;
+    const QStringList args = app.arguments();
+    for (int i = 1; i < args.size() - 1; ++i) {
+        const QString &a = args[i];
+        if (a == QLatin1String("-vo")) {
+            vo = args[++i];
+        } else if (a == QLatin1String("-n")) {
+            streams = qMax(1, args[++i].toInt());
+        } else if (a == QLatin1String("-s")) {
+            const QStringList wh = args[++i].split(QLatin1Char('x'));
+            if (wh.size() == 2)
+                size = QSize(wh[0].toInt(), wh[1].toInt());
+        } else if (a == QLatin1String("-f")) {
+            pixfmt = args[++i];
+        } else if (a == QLatin1String("-r")) {
+            fps = qMax(1, args[++i].toInt());
+        } else if (a == QLatin1String("-t")) {
+            seconds = qMax(1, args[++i].toInt());
+        }
+    }
+    const VideoRendererId vid = vo.toLower() == QLatin1String("xv") ? VideoRendererId_XV : VideoRendererId_X11;
+    const VideoFormat fmt(pixfmt);
+    if (!fmt.isValid()) {
+        qWarning() << "invalid pixel format: " << pixfmt;
+        return 1;
+    }
+    QVector<VideoRenderer*> renderers;
+    QVector<VideoFrame> frames;
+    for (int i = 0; i < streams; ++i) {
+        VideoRenderer *r = VideoRenderer::create(vid);
+        if (!r || !r->isAvailable() || !r->widget()) {
+            qWarning() << "renderer is not available: " << vo;
+            return 1;
+        }
+        r->widget()->resize(size/2);
+        r->widget()->show();
+        renderers.append(r);
+        frames.append(createFrame(fmt, size.width(), size.height(), i));
+    }
+    const int total = fps*seconds;
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 cpu0 = cpuTimeUs();
+    for (int f = 0; f < total; ++f) {
+        for (int i = 0; i < renderers.size(); ++i) {
+            VideoFrame frame(frames[i]);
+            frame.setTimestamp(qreal(f)/qreal(fps));
+            renderers[i]->receive(frame);
+        }
+        app.processEvents();
+        const qint64 wait = qint64(f + 1)*1000LL/fps - timer.elapsed();
+        if (wait > 0)
+            app.processEvents(QEventLoop::WaitForMoreEvents, wait);
+    }
+    const qreal wall = qreal(timer.nsecsElapsed())/1e3;
+    const qreal cpu = qreal(cpuTimeUs() - cpu0);
+    qint64 painted = 0;
+    foreach (VideoRenderer *r, renderers)
+        painted += r->framesPainted();
+    printf("vo: %s, format: %s, %dx%d@%d, streams: %d\n", vo.toUtf8().constData(), fmt.name().toUtf8().constData(), size.width(), size.height(), fps, streams);
+    printf("cpu: %.1f%%, per stream: %.1f%%, painted: %lld/%d\n", cpu*100.0/wall, cpu*100.0/wall/qreal(streams), painted, total*streams);
+    qDeleteAll(renderers);
+    return 0;
+}
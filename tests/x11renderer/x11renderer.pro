@@ -0,0 +1,12 @@
+TEMPLATE = app
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+CONFIG -= app_bundle
+CONFIG += console
+TARGET = x11renderer
+
+PROJECTROOT = $$PWD/../..
+include($$PROJECTROOT/src/libQtAV.pri)
+include($$PROJECTROOT/widgets/libQtAVWidgets.pri)
+preparePaths($$OUT_PWD/../../out)
+
+SOURCES += main.cpp
@@ -33,12 +33,12 @@ namespace QtAV {
 
 class VideoFrame;
 class VideoOutput;
-class VideoFrameExtractor;
 class Q_AVWIDGETS_EXPORT VideoPreviewWidget : public QWidget
 {
     Q_OBJECT
 public:
     explicit VideoPreviewWidget(QWidget *parent = 0);
+    ~VideoPreviewWidget();
     void setTimestamp(qint64 msec);
     qint64 timestamp() const;
     void preview();
@@ -47,7 +47,7 @@ public:
     // default is false
     void setKeepAspectRatio(bool value = true) { m_keep_ar = value; }
     bool isKeepAspectRatio() const { return m_keep_ar; }
-    /// AutoDisplayFrame -- default is true. if true, new frames from underlying extractor will update display widget automatically.
+    /// AutoDisplayFrame -- default is true. if true, new frames from ThumbnailService will update display widget automatically.
     bool isAutoDisplayFrame() const { return m_auto_display; }
     /// If false, new frames (or frame errors) won't automatically update widget
     /// (caller must ensure to call displayFrame()/displayFrame(frame) for this if false).
@@ -71,11 +71,18 @@ Q_SIGNALS:
     void gotFrame(const QtAV::VideoFrame & frame);
 protected:
     virtual void resizeEvent(QResizeEvent *);
+    virtual void showEvent(QShowEvent *);
+    virtual void hideEvent(QHideEvent *);
+
+private Q_SLOTS:
+    void onFrameReady(int id, const QtAV::VideoFrame& frame);
+    void onError(int id, const QString& message);
 
 private:
     bool m_keep_ar, m_auto_display;
     QString m_file;
-    VideoFrameExtractor *m_extractor;
+    qint64 m_timestamp;
+    int m_request; // id of the pending ThumbnailService request. 0: none
     VideoOutput *m_out;
 };
 
@@ -20,43 +20,61 @@
 ******************************************************************************/
 
 #include "QtAVWidgets/VideoPreviewWidget.h"
-#include "QtAV/VideoFrameExtractor.h"
+#include "QtAV/ThumbnailService.h"
 #include "QtAV/VideoOutput.h"
 #include <QtGui/QResizeEvent>
 
 namespace QtAV {
+namespace {
+// frames are decoded and scaled for device pixels, otherwise they are upscaled and blurry on high dpi screens
+QSize devicePixelSize(const QWidget *w)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+    return w->size()*w->devicePixelRatioF();
+#elif QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    return w->size()*w->devicePixelRatio();
+#else
+    return w->size();
+#endif
+}
+} //namespace
 
 VideoPreviewWidget::VideoPreviewWidget(QWidget *parent)
     : QWidget(parent)
     , m_keep_ar(false)
     , m_auto_display(false) // set to false initially to trigger connections in setAutoDisplayFrame() below -- will default to true
-    , m_extractor(new VideoFrameExtractor(this))
+    , m_timestamp(0)
+    , m_request(0)
     , m_out(new VideoOutput(VideoRendererId_Widget, this))
     // FIXME: opengl may crash, so use software renderer here
 {
     setWindowFlags(Qt::FramelessWindowHint);
     Q_ASSERT_X(m_out->widget(), "VideoPreviewWidget()", "widget based renderer is not found");
     m_out->widget()->setParent(this);
-    connect(m_extractor, SIGNAL(positionChanged()), this, SIGNAL(timestampChanged()));
-    connect(m_extractor, SIGNAL(error(const QString &)), this, SIGNAL(gotError(const QString &)));
-    connect(m_extractor, SIGNAL(aborted(const QString &)), this, SIGNAL(gotAbort(const QString &)));
-    m_extractor->setAutoExtract(false);
+    // demuxers, decoders and frames are shared by all previews
+    ThumbnailService *service = ThumbnailService::instance();
+    connect(service, SIGNAL(frameReady(int,QtAV::VideoFrame)), SLOT(onFrameReady(int,QtAV::VideoFrame)));
+    connect(service, SIGNAL(error(int,QString)), SLOT(onError(int,QString)));
     m_auto_display = false;
     setAutoDisplayFrame(true); // set up frame-related connections, defaulting autoDisplayFrame to true
 }
 
+VideoPreviewWidget::~VideoPreviewWidget()
+{
+    ThumbnailService::instance()->cancel(this);
+}
+
 void VideoPreviewWidget::setAutoDisplayFrame(bool b)
 {
     if (!!b == !!m_auto_display) return; // avoid reduntant connect/disconnect calls
+    m_auto_display = b;
     if (b) {
-        connect(m_extractor, SIGNAL(frameExtracted(QtAV::VideoFrame)), SLOT(displayFrame(QtAV::VideoFrame)));
-        connect(m_extractor, SIGNAL(error(const QString &)), SLOT(displayNoFrame()));
-        connect(m_extractor, SIGNAL(aborted(const QString &)), SLOT(displayNoFrame()));
+        connect(this, SIGNAL(gotError(QString)), SLOT(displayNoFrame()));
+        connect(this, SIGNAL(gotAbort(QString)), SLOT(displayNoFrame()));
         connect(this, SIGNAL(fileChanged()), SLOT(displayNoFrame()));
     } else {
-        disconnect(m_extractor, SIGNAL(frameExtracted(QtAV::VideoFrame)), this, SLOT(displayFrame(QtAV::VideoFrame)));
-        disconnect(m_extractor, SIGNAL(error(const QString &)), this, SLOT(displayNoFrame()));
-        disconnect(m_extractor, SIGNAL(aborted(const QString &)), this, SLOT(displayNoFrame()));
+        disconnect(this, SIGNAL(gotError(QString)), this, SLOT(displayNoFrame()));
+        disconnect(this, SIGNAL(gotAbort(QString)), this, SLOT(displayNoFrame()));
         disconnect(this, SIGNAL(fileChanged()), this, SLOT(displayNoFrame()));
     }
 }
@@ -66,19 +84,38 @@ void VideoPreviewWidget::resizeEvent(QResizeEvent *e)
     m_out->widget()->resize(e->size());
 }
 
+void VideoPreviewWidget::showEvent(QShowEvent *e)
+{
+    QWidget::showEvent(e);
+    // visible previews are served first
+    ThumbnailService::instance()->setPriority(this, 1);
+}
+
+void VideoPreviewWidget::hideEvent(QHideEvent *e)
+{
+    QWidget::hideEvent(e);
+    ThumbnailService::instance()->setPriority(this, 0);
+}
+
 void VideoPreviewWidget::setTimestamp(qint64 value)
 {
-    m_extractor->setPosition(value);
+    if (m_timestamp == value)
+        return;
+    m_timestamp = value;
+    Q_EMIT timestampChanged();
 }
 
 qint64 VideoPreviewWidget::timestamp() const
 {
-    return m_extractor->position();
+    return m_timestamp;
 }
 
 void VideoPreviewWidget::preview()
 {
-    m_extractor->extract();
+    if (m_request) // the service drops the queued request of this widget
+        Q_EMIT gotAbort(QString().sprintf("Abort at position %lld: new request", m_timestamp));
+    // small previews decode in a lower resolution or quality
+    m_request = ThumbnailService::instance()->request(this, m_file, m_timestamp, devicePixelSize(m_out->widget()), isVisible() ? 1 : 0);
 }
 
 void VideoPreviewWidget::setFile(const QString &value)
@@ -86,7 +123,6 @@ void VideoPreviewWidget::setFile(const QString &value)
     if (m_file == value)
         return;
     m_file = value;
-    m_extractor->setSource(m_file);
     emit fileChanged();
 }
 
@@ -97,15 +133,11 @@ QString VideoPreviewWidget::file() const
 
 void VideoPreviewWidget::displayFrame(const QtAV::VideoFrame &frame)
 {
-    int diff = qAbs(qint64(frame.timestamp()*1000.0) - m_extractor->position());
-    if (diff > m_extractor->precision()) {
-        //qWarning("timestamp difference (%d/%lld) is too large! ignore", diff);
-    }
     if (!frame.isValid()) {
         displayNoFrame();
         return;
     }
-    QSize s = m_out->widget()->rect().size();
+    QSize s = devicePixelSize(m_out->widget());
     if (m_keep_ar) {
         QSize fs(frame.size());
         fs.scale(s, Qt::KeepAspectRatio);
@@ -129,4 +161,21 @@ void VideoPreviewWidget::displayNoFrame()
     m_out->receive(VideoFrame());
 }
 
+void VideoPreviewWidget::onFrameReady(int id, const QtAV::VideoFrame &frame)
+{
+    if (id != m_request)
+        return;
+    m_request = 0;
+    if (m_auto_display)
+        displayFrame(frame);
+}
+
+void VideoPreviewWidget::onError(int id, const QString &message)
+{
+    if (id != m_request)
+        return;
+    m_request = 0;
+    Q_EMIT gotError(message);
+}
+
 } //namespace QtAV
@@ -97,13 +97,17 @@ void WidgetRenderer::resizeEvent(QResizeEvent *e)
     update();
 }
 
-void WidgetRenderer::paintEvent(QPaintEvent *)
+void WidgetRenderer::paintEvent(QPaintEvent *e)
 {
     DPTR_D(WidgetRenderer);
+    // the backing store keeps the letterbox painted last time. a new frame only updates the video rect
+    if (!d.update_background && e->region().intersects(backgroundRegion()))
+        d.update_background = true;
     d.painter->begin(this); //Widget painting can only begin as a result of a paintEvent
     handlePaintEvent();
     if (d.painter->isActive())
         d.painter->end();
+    d.update_background = false;
 }
 
 bool WidgetRenderer::onSetOrientation(int value)
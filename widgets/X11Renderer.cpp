@@ -327,6 +327,7 @@ no_shm:
     QByteArray ximage_data[kPoolSize];
     VideoFrame frame_orig; // if renderer is resized, scale the original frame
     bool frame_changed;
+    VideoFrameConverter conv; // converts and scales into ximage data directly
 };
 
 X11Renderer::X11Renderer(QWidget *parent, Qt::WindowFlags f):
@@ -394,6 +395,17 @@ int X11RendererPrivate::resizeXImage(int index)
         interopFrame.setBits(use_shm ? (quint8*)ximage->data : (quint8*)ximage_data[index].constData());
         interopFrame.setBytesPerLine(ximage->bytes_per_line);
     }
+    if (frame_orig.constBits(0)
+            && (frame_orig.pixelFormat() != pixfmt || frame_orig.width() != ximage->width || frame_orig.height() != ximage->height)) {
+        // write the converted frame into the (shared memory) ximage. no intermediate frame and copy
+        quint8 *dst = use_shm ? (quint8*)ximage->data : (quint8*)ximage_data[index].constData();
+        const int dst_stride = ximage->bytes_per_line;
+        if (conv.convert(frame_orig, VideoFormat(pixfmt), &dst, &dst_stride, QSize(ximage->width, ximage->height))) {
+            if (!use_shm)
+                ximage->data = (char*)dst;
+            return true;
+        }
+    }
     if (frame_orig.constBits(0)
             || !video_frame.map(UserSurface, &interopFrame, VideoFormat(VideoFormat::Format_RGB32)) //check pixel format and scale to ximage size&line_size
             ) {
@@ -310,6 +310,7 @@ no_shm:
     XShmSegmentInfo shm;
 #endif //_XSHM_H_
     VideoFormat::PixelFormat format;
+    VideoFrameConverter conv;
 };
 
 bool XVRendererPrivate::XvSetPortAttributeIfExists(const char *key, int value)
@@ -356,7 +357,8 @@ XVRenderer::XVRenderer(QWidget *parent, Qt::WindowFlags f):
     }
 }
 
-bool XVRenderer::isSupported(VideoFormat::PixelFormat pixfmt) const
+// formats copied to xv image without conversion
+static bool isCopySupported(VideoFormat::PixelFormat pixfmt)
 {
     // TODO: rgb use copyplane
     return pixfmt == VideoFormat::Format_YUV420P || pixfmt == VideoFormat::Format_YV12
@@ -365,6 +367,13 @@ bool XVRenderer::isSupported(VideoFormat::PixelFormat pixfmt) const
             ;
 }
 
+bool XVRenderer::isSupported(VideoFormat::PixelFormat pixfmt) const
+{
+    // other host formats are converted into the xv image directly in receiveFrame(), so data is written only once.
+    // hw frames are downloaded as yuv420p there
+    return pixfmt != VideoFormat::Format_Invalid;
+}
+
 static void SplitPlanes(quint8 *dstu, size_t dstu_pitch,
                         quint8 *dstv, size_t dstv_pitch,
                         const quint8 *src, size_t src_pitch,
@@ -429,12 +438,32 @@ bool XVRenderer::receiveFrame(const VideoFrame& frame)
         updateUi();
         return true;
     }
+    if (!frame.constBits(0)) {
+        // hw surface, e.g. P010 or NV12 from VA-API. download it as yuv420p which xv always takes
+        const VideoFrame host(frame.to(VideoFormat::Format_YUV420P));
+        if (!host.isValid() || !host.constBits(0))
+            return false;
+        return receiveFrame(host);
+    }
+    if (frame.constBits(0) && !isCopySupported(frame.pixelFormat())) {
+        if (!d.ensureImage(frame.width(), frame.height(), VideoFormat::Format_YUV420P))
+            return false;
+        d.video_frame = frame;
+        // yv12 image, swap UV
+        quint8* dst[] = {
+            (quint8*)(d.xv_image->data + d.xv_image->offsets[0]),
+            (quint8*)(d.xv_image->data + d.xv_image->offsets[2]),
+            (quint8*)(d.xv_image->data + d.xv_image->offsets[1])
+        };
+        const int dst_linesize[] = { d.xv_image->pitches[0], d.xv_image->pitches[2], d.xv_image->pitches[1] };
+        if (!d.conv.convert(frame, VideoFormat(VideoFormat::Format_YUV420P), dst, dst_linesize, QSize(d.xv_image->width, d.xv_image->height)))
+            return false;
+        update();
+        return true;
+    }
     if (!d.ensureImage(frame.width(), frame.height(), frame.format().pixelFormat()))
         return false;
-    if (frame.constBits(0))
-        d.video_frame = frame;
-    else // FIXME: not work
-        d.video_frame = frame.to(frame.pixelFormat()); // assume frame format is supported
+    d.video_frame = frame; // host frame. hw frames are downloaded above
     int nb_planes = d.video_frame.planeCount();
     QVector<size_t> src_linesize(nb_planes);
     QVector<const quint8*> src(nb_planes);